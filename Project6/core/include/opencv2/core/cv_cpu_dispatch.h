@@ -131,12 +131,57 @@ struct VZeroUpperGuard {
 
 
 #if !defined __OPENCV_BUILD /* Compatibility code */ \
+    && !defined CV_DISABLE_OPTIMIZATION \
     && !defined __CUDACC__ /* do not include SSE/AVX/NEON headers for NVCC compiler */
 #if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
 #  include <emmintrin.h>
-#  define CV_MMX 0
-#  define CV_SSE 0
-#  define CV_SSE2 0
+#  define CV_MMX 1
+#  define CV_SSE 1
+#  define CV_SSE2 1
+/* higher levels follow the compiler target (-msse4.1, -mavx2, /arch:AVX2, ...) */
+#  if defined __SSE3__ || defined __AVX__
+#    include <pmmintrin.h>
+#    define CV_SSE3 1
+#  endif
+#  if defined __SSSE3__ || defined __AVX__
+#    include <tmmintrin.h>
+#    define CV_SSSE3 1
+#  endif
+#  if defined __SSE4_1__ || defined __AVX__
+#    include <smmintrin.h>
+#    define CV_SSE4_1 1
+#  endif
+#  if defined __SSE4_2__ || defined __AVX__
+#    include <nmmintrin.h>
+#    define CV_SSE4_2 1
+#  endif
+#  if defined __POPCNT__ || defined __AVX__
+#    ifdef _MSC_VER
+#      include <nmmintrin.h>
+#      if defined(_M_X64)
+#        define CV_POPCNT_U64 _mm_popcnt_u64
+#      endif
+#      define CV_POPCNT_U32 _mm_popcnt_u32
+#    else
+#      include <popcntintrin.h>
+#      if defined(__x86_64__)
+#        define CV_POPCNT_U64 __builtin_popcountll
+#      endif
+#      define CV_POPCNT_U32 __builtin_popcount
+#    endif
+#    define CV_POPCNT 1
+#  endif
+#  if defined __AVX__
+#    include <immintrin.h>
+#    define CV_AVX 1
+#  endif
+#  if defined __AVX2__
+#    include <immintrin.h>
+#    define CV_AVX2 1
+#  endif
+#  if defined __FMA__ && defined __AVX2__
+#    define CV_FMA3 1
+#  endif
 #elif defined _WIN32 && defined(_M_ARM)
 # include <Intrin.h>
 # include <arm_neon.h>
@@ -265,7 +265,7 @@ namespace cv {
 
 #if CV_SSE2
 
-#include "opencv2/core/hal/intrin_sse.hpp"
+#include "../hal/intrin_sse.hpp"
 
 #elif CV_NEON
 
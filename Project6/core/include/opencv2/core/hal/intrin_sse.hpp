@@ -0,0 +1,2041 @@
+#ifndef OPENCV_HAL_SSE_HPP
+#define OPENCV_HAL_SSE_HPP
+
+#include <algorithm>
+#include "../saturate.hpp"
+
+#define CV_SIMD128 1
+#define CV_SIMD128_64F 1
+
+namespace cv
+{
+
+	//! @cond IGNORED
+
+	//
+	// SSE2 (with optional SSE3/SSSE3/SSE4.1/FMA3 refinements) implementation of the
+	// 128-bit universal intrinsics. The interface and the semantics are the same as
+	// in intrin_cpp.hpp, so any kernel written against v_* types compiles unchanged.
+	//
+
+#ifndef CV_DOXYGEN
+	CV_CPU_OPTIMIZATION_HAL_NAMESPACE_BEGIN
+#endif
+
+	struct v_uint8x16
+	{
+		typedef uchar lane_type;
+		enum { nlanes = 16 };
+
+		v_uint8x16() : val(_mm_setzero_si128()) {}
+		explicit v_uint8x16(__m128i v) : val(v) {}
+		v_uint8x16(uchar v0, uchar v1, uchar v2, uchar v3, uchar v4, uchar v5, uchar v6, uchar v7,
+			uchar v8, uchar v9, uchar v10, uchar v11, uchar v12, uchar v13, uchar v14, uchar v15)
+		{
+			val = _mm_setr_epi8((char)v0, (char)v1, (char)v2, (char)v3,
+				(char)v4, (char)v5, (char)v6, (char)v7,
+				(char)v8, (char)v9, (char)v10, (char)v11,
+				(char)v12, (char)v13, (char)v14, (char)v15);
+		}
+		uchar get0() const
+		{
+			return (uchar)_mm_cvtsi128_si32(val);
+		}
+
+		__m128i val;
+	};
+
+	struct v_int8x16
+	{
+		typedef schar lane_type;
+		enum { nlanes = 16 };
+
+		v_int8x16() : val(_mm_setzero_si128()) {}
+		explicit v_int8x16(__m128i v) : val(v) {}
+		v_int8x16(schar v0, schar v1, schar v2, schar v3, schar v4, schar v5, schar v6, schar v7,
+			schar v8, schar v9, schar v10, schar v11, schar v12, schar v13, schar v14, schar v15)
+		{
+			val = _mm_setr_epi8((char)v0, (char)v1, (char)v2, (char)v3,
+				(char)v4, (char)v5, (char)v6, (char)v7,
+				(char)v8, (char)v9, (char)v10, (char)v11,
+				(char)v12, (char)v13, (char)v14, (char)v15);
+		}
+		schar get0() const
+		{
+			return (schar)_mm_cvtsi128_si32(val);
+		}
+
+		__m128i val;
+	};
+
+	struct v_uint16x8
+	{
+		typedef ushort lane_type;
+		enum { nlanes = 8 };
+
+		v_uint16x8() : val(_mm_setzero_si128()) {}
+		explicit v_uint16x8(__m128i v) : val(v) {}
+		v_uint16x8(ushort v0, ushort v1, ushort v2, ushort v3, ushort v4, ushort v5, ushort v6, ushort v7)
+		{
+			val = _mm_setr_epi16((short)v0, (short)v1, (short)v2, (short)v3,
+				(short)v4, (short)v5, (short)v6, (short)v7);
+		}
+		ushort get0() const
+		{
+			return (ushort)_mm_cvtsi128_si32(val);
+		}
+
+		__m128i val;
+	};
+
+	struct v_int16x8
+	{
+		typedef short lane_type;
+		enum { nlanes = 8 };
+
+		v_int16x8() : val(_mm_setzero_si128()) {}
+		explicit v_int16x8(__m128i v) : val(v) {}
+		v_int16x8(short v0, short v1, short v2, short v3, short v4, short v5, short v6, short v7)
+		{
+			val = _mm_setr_epi16(v0, v1, v2, v3, v4, v5, v6, v7);
+		}
+		short get0() const
+		{
+			return (short)_mm_cvtsi128_si32(val);
+		}
+
+		__m128i val;
+	};
+
+	struct v_uint32x4
+	{
+		typedef unsigned lane_type;
+		enum { nlanes = 4 };
+
+		v_uint32x4() : val(_mm_setzero_si128()) {}
+		explicit v_uint32x4(__m128i v) : val(v) {}
+		v_uint32x4(unsigned v0, unsigned v1, unsigned v2, unsigned v3)
+		{
+			val = _mm_setr_epi32((int)v0, (int)v1, (int)v2, (int)v3);
+		}
+		unsigned get0() const
+		{
+			return (unsigned)_mm_cvtsi128_si32(val);
+		}
+
+		__m128i val;
+	};
+
+	struct v_int32x4
+	{
+		typedef int lane_type;
+		enum { nlanes = 4 };
+
+		v_int32x4() : val(_mm_setzero_si128()) {}
+		explicit v_int32x4(__m128i v) : val(v) {}
+		v_int32x4(int v0, int v1, int v2, int v3)
+		{
+			val = _mm_setr_epi32(v0, v1, v2, v3);
+		}
+		int get0() const
+		{
+			return _mm_cvtsi128_si32(val);
+		}
+
+		__m128i val;
+	};
+
+	struct v_float32x4
+	{
+		typedef float lane_type;
+		enum { nlanes = 4 };
+
+		v_float32x4() : val(_mm_setzero_ps()) {}
+		explicit v_float32x4(__m128 v) : val(v) {}
+		v_float32x4(float v0, float v1, float v2, float v3)
+		{
+			val = _mm_setr_ps(v0, v1, v2, v3);
+		}
+		float get0() const
+		{
+			return _mm_cvtss_f32(val);
+		}
+
+		__m128 val;
+	};
+
+	struct v_uint64x2
+	{
+		typedef uint64 lane_type;
+		enum { nlanes = 2 };
+
+		v_uint64x2() : val(_mm_setzero_si128()) {}
+		explicit v_uint64x2(__m128i v) : val(v) {}
+		v_uint64x2(uint64 v0, uint64 v1)
+		{
+			val = _mm_setr_epi32((int)v0, (int)(v0 >> 32), (int)v1, (int)(v1 >> 32));
+		}
+		uint64 get0() const
+		{
+			int a = _mm_cvtsi128_si32(val);
+			int b = _mm_cvtsi128_si32(_mm_srli_epi64(val, 32));
+			return (unsigned)a | ((uint64)(unsigned)b << 32);
+		}
+
+		__m128i val;
+	};
+
+	struct v_int64x2
+	{
+		typedef int64 lane_type;
+		enum { nlanes = 2 };
+
+		v_int64x2() : val(_mm_setzero_si128()) {}
+		explicit v_int64x2(__m128i v) : val(v) {}
+		v_int64x2(int64 v0, int64 v1)
+		{
+			val = _mm_setr_epi32((int)v0, (int)(v0 >> 32), (int)v1, (int)(v1 >> 32));
+		}
+		int64 get0() const
+		{
+			int a = _mm_cvtsi128_si32(val);
+			int b = _mm_cvtsi128_si32(_mm_srli_epi64(val, 32));
+			return (int64)((unsigned)a | ((uint64)(unsigned)b << 32));
+		}
+
+		__m128i val;
+	};
+
+	struct v_float64x2
+	{
+		typedef double lane_type;
+		enum { nlanes = 2 };
+
+		v_float64x2() : val(_mm_setzero_pd()) {}
+		explicit v_float64x2(__m128d v) : val(v) {}
+		v_float64x2(double v0, double v1)
+		{
+			val = _mm_setr_pd(v0, v1);
+		}
+		double get0() const
+		{
+			return _mm_cvtsd_f64(val);
+		}
+
+		__m128d val;
+	};
+
+	// bit-wise "mask ? a : b"
+	inline __m128i v_select_si128(__m128i mask, __m128i a, __m128i b)
+	{
+		return _mm_xor_si128(b, _mm_and_si128(_mm_xor_si128(a, b), mask));
+	}
+
+	// arithmetic right shift of 64-bit lanes (SSE2 only has the logical one)
+	inline __m128i v_srai_epi64(__m128i a, int imm)
+	{
+		__m128i smask = _mm_shuffle_epi32(_mm_srai_epi32(a, 31), _MM_SHUFFLE(3, 3, 1, 1));
+		return _mm_xor_si128(_mm_srli_epi64(_mm_xor_si128(a, smask), imm), smask);
+	}
+
+	////////////////// Initialization and reinterpretation //////////////////
+
+#define OPENCV_HAL_IMPL_SSE_INITVEC(_Tpvec, _Tp, suffix, zsuffix, ssuffix, _Tps, cast) \
+inline _Tpvec v_setzero_##suffix() { return _Tpvec(_mm_setzero_##zsuffix()); } \
+inline _Tpvec v_setall_##suffix(_Tp v) { return _Tpvec(_mm_set1_##ssuffix((_Tps)v)); } \
+template<typename _Tpvec0> inline _Tpvec v_reinterpret_as_##suffix(const _Tpvec0& a) \
+{ return _Tpvec(cast(a.val)); }
+
+	OPENCV_HAL_IMPL_SSE_INITVEC(v_uint8x16, uchar, u8, si128, epi8, char, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_INITVEC(v_int8x16, schar, s8, si128, epi8, char, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_INITVEC(v_uint16x8, ushort, u16, si128, epi16, short, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_INITVEC(v_int16x8, short, s16, si128, epi16, short, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_INITVEC(v_uint32x4, unsigned, u32, si128, epi32, int, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_INITVEC(v_int32x4, int, s32, si128, epi32, int, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_INITVEC(v_float32x4, float, f32, ps, ps, float, _mm_castsi128_ps)
+	OPENCV_HAL_IMPL_SSE_INITVEC(v_float64x2, double, f64, pd, pd, double, _mm_castsi128_pd)
+
+	inline v_uint64x2 v_setzero_u64() { return v_uint64x2(_mm_setzero_si128()); }
+	inline v_int64x2 v_setzero_s64() { return v_int64x2(_mm_setzero_si128()); }
+	inline v_uint64x2 v_setall_u64(uint64 val) { return v_uint64x2(val, val); }
+	inline v_int64x2 v_setall_s64(int64 val) { return v_int64x2(val, val); }
+
+	template<typename _Tpvec> inline
+		v_uint64x2 v_reinterpret_as_u64(const _Tpvec& a) { return v_uint64x2(a.val); }
+	template<typename _Tpvec> inline
+		v_int64x2 v_reinterpret_as_s64(const _Tpvec& a) { return v_int64x2(a.val); }
+	inline v_float32x4 v_reinterpret_as_f32(const v_uint64x2& a)
+	{ return v_float32x4(_mm_castsi128_ps(a.val)); }
+	inline v_float32x4 v_reinterpret_as_f32(const v_int64x2& a)
+	{ return v_float32x4(_mm_castsi128_ps(a.val)); }
+	inline v_float64x2 v_reinterpret_as_f64(const v_uint64x2& a)
+	{ return v_float64x2(_mm_castsi128_pd(a.val)); }
+	inline v_float64x2 v_reinterpret_as_f64(const v_int64x2& a)
+	{ return v_float64x2(_mm_castsi128_pd(a.val)); }
+
+#define OPENCV_HAL_IMPL_SSE_INIT_FROM_FLT(_Tpvec, suffix) \
+inline _Tpvec v_reinterpret_as_##suffix(const v_float32x4& a) \
+{ return _Tpvec(_mm_castps_si128(a.val)); } \
+inline _Tpvec v_reinterpret_as_##suffix(const v_float64x2& a) \
+{ return _Tpvec(_mm_castpd_si128(a.val)); }
+
+	OPENCV_HAL_IMPL_SSE_INIT_FROM_FLT(v_uint8x16, u8)
+	OPENCV_HAL_IMPL_SSE_INIT_FROM_FLT(v_int8x16, s8)
+	OPENCV_HAL_IMPL_SSE_INIT_FROM_FLT(v_uint16x8, u16)
+	OPENCV_HAL_IMPL_SSE_INIT_FROM_FLT(v_int16x8, s16)
+	OPENCV_HAL_IMPL_SSE_INIT_FROM_FLT(v_uint32x4, u32)
+	OPENCV_HAL_IMPL_SSE_INIT_FROM_FLT(v_int32x4, s32)
+	OPENCV_HAL_IMPL_SSE_INIT_FROM_FLT(v_uint64x2, u64)
+	OPENCV_HAL_IMPL_SSE_INIT_FROM_FLT(v_int64x2, s64)
+
+	inline v_float32x4 v_reinterpret_as_f32(const v_float32x4& a) { return a; }
+	inline v_float64x2 v_reinterpret_as_f64(const v_float64x2& a) { return a; }
+	inline v_float32x4 v_reinterpret_as_f32(const v_float64x2& a) { return v_float32x4(_mm_castpd_ps(a.val)); }
+	inline v_float64x2 v_reinterpret_as_f64(const v_float32x4& a) { return v_float64x2(_mm_castps_pd(a.val)); }
+
+	//////////////// PACK ///////////////
+
+	inline v_uint8x16 v_pack(const v_uint16x8& a, const v_uint16x8& b)
+	{
+		__m128i delta = _mm_set1_epi16(255);
+		return v_uint8x16(_mm_packus_epi16(_mm_subs_epu16(a.val, _mm_subs_epu16(a.val, delta)),
+			_mm_subs_epu16(b.val, _mm_subs_epu16(b.val, delta))));
+	}
+
+	inline void v_pack_store(uchar* ptr, const v_uint16x8& a)
+	{
+		__m128i delta = _mm_set1_epi16(255);
+		__m128i a1 = _mm_subs_epu16(a.val, _mm_subs_epu16(a.val, delta));
+		_mm_storel_epi64((__m128i*)ptr, _mm_packus_epi16(a1, a1));
+	}
+
+	inline v_uint8x16 v_pack_u(const v_int16x8& a, const v_int16x8& b)
+	{
+		return v_uint8x16(_mm_packus_epi16(a.val, b.val));
+	}
+
+	inline void v_pack_u_store(uchar* ptr, const v_int16x8& a)
+	{
+		_mm_storel_epi64((__m128i*)ptr, _mm_packus_epi16(a.val, a.val));
+	}
+
+	template<int n> inline
+		v_uint8x16 v_rshr_pack(const v_uint16x8& a, const v_uint16x8& b)
+	{
+		// n > 0, so the shifted values fit into the signed 16-bit range of packus
+		__m128i delta = _mm_set1_epi16((short)(1 << (n - 1)));
+		return v_uint8x16(_mm_packus_epi16(_mm_srli_epi16(_mm_adds_epu16(a.val, delta), n),
+			_mm_srli_epi16(_mm_adds_epu16(b.val, delta), n)));
+	}
+
+	template<int n> inline
+		void v_rshr_pack_store(uchar* ptr, const v_uint16x8& a)
+	{
+		__m128i delta = _mm_set1_epi16((short)(1 << (n - 1)));
+		__m128i a1 = _mm_srli_epi16(_mm_adds_epu16(a.val, delta), n);
+		_mm_storel_epi64((__m128i*)ptr, _mm_packus_epi16(a1, a1));
+	}
+
+	template<int n> inline
+		v_uint8x16 v_rshr_pack_u(const v_int16x8& a, const v_int16x8& b)
+	{
+		__m128i delta = _mm_set1_epi16((short)(1 << (n - 1)));
+		return v_uint8x16(_mm_packus_epi16(_mm_srai_epi16(_mm_adds_epi16(a.val, delta), n),
+			_mm_srai_epi16(_mm_adds_epi16(b.val, delta), n)));
+	}
+
+	template<int n> inline
+		void v_rshr_pack_u_store(uchar* ptr, const v_int16x8& a)
+	{
+		__m128i delta = _mm_set1_epi16((short)(1 << (n - 1)));
+		__m128i a1 = _mm_srai_epi16(_mm_adds_epi16(a.val, delta), n);
+		_mm_storel_epi64((__m128i*)ptr, _mm_packus_epi16(a1, a1));
+	}
+
+	inline v_int8x16 v_pack(const v_int16x8& a, const v_int16x8& b)
+	{
+		return v_int8x16(_mm_packs_epi16(a.val, b.val));
+	}
+
+	inline void v_pack_store(schar* ptr, const v_int16x8& a)
+	{
+		_mm_storel_epi64((__m128i*)ptr, _mm_packs_epi16(a.val, a.val));
+	}
+
+	template<int n> inline
+		v_int8x16 v_rshr_pack(const v_int16x8& a, const v_int16x8& b)
+	{
+		__m128i delta = _mm_set1_epi16((short)(1 << (n - 1)));
+		return v_int8x16(_mm_packs_epi16(_mm_srai_epi16(_mm_adds_epi16(a.val, delta), n),
+			_mm_srai_epi16(_mm_adds_epi16(b.val, delta), n)));
+	}
+
+	template<int n> inline
+		void v_rshr_pack_store(schar* ptr, const v_int16x8& a)
+	{
+		__m128i delta = _mm_set1_epi16((short)(1 << (n - 1)));
+		__m128i a1 = _mm_srai_epi16(_mm_adds_epi16(a.val, delta), n);
+		_mm_storel_epi64((__m128i*)ptr, _mm_packs_epi16(a1, a1));
+	}
+
+	// saturate unsigned (resp. signed) 32-bit lanes to [0, 65535]
+	inline __m128i v_sse_pack_u32(__m128i a, __m128i b)
+	{
+#if CV_SSE4_1
+		__m128i maxval32 = _mm_set1_epi32(65535);
+		return _mm_packus_epi32(_mm_min_epu32(a, maxval32), _mm_min_epu32(b, maxval32));
+#else
+		__m128i z = _mm_setzero_si128(), maxval32 = _mm_set1_epi32(65535), delta32 = _mm_set1_epi32(32768);
+		__m128i a1 = _mm_sub_epi32(v_select_si128(_mm_cmpgt_epi32(z, a), maxval32, a), delta32);
+		__m128i b1 = _mm_sub_epi32(v_select_si128(_mm_cmpgt_epi32(z, b), maxval32, b), delta32);
+		return _mm_sub_epi16(_mm_packs_epi32(a1, b1), _mm_set1_epi16(-32768));
+#endif
+	}
+
+	inline __m128i v_sse_pack_s32_u16(__m128i a, __m128i b)
+	{
+#if CV_SSE4_1
+		return _mm_packus_epi32(a, b);
+#else
+		__m128i z = _mm_setzero_si128(), delta32 = _mm_set1_epi32(32768);
+		a = _mm_and_si128(a, _mm_cmpgt_epi32(a, z));
+		b = _mm_and_si128(b, _mm_cmpgt_epi32(b, z));
+		__m128i r = _mm_packs_epi32(_mm_sub_epi32(a, delta32), _mm_sub_epi32(b, delta32));
+		return _mm_sub_epi16(r, _mm_set1_epi16(-32768));
+#endif
+	}
+
+	inline v_uint16x8 v_pack(const v_uint32x4& a, const v_uint32x4& b)
+	{
+		return v_uint16x8(v_sse_pack_u32(a.val, b.val));
+	}
+
+	inline void v_pack_store(ushort* ptr, const v_uint32x4& a)
+	{
+		_mm_storel_epi64((__m128i*)ptr, v_sse_pack_u32(a.val, a.val));
+	}
+
+	template<int n> inline
+		v_uint16x8 v_rshr_pack(const v_uint32x4& a, const v_uint32x4& b)
+	{
+		__m128i delta = _mm_set1_epi32(1 << (n - 1));
+		return v_uint16x8(v_sse_pack_u32(_mm_srli_epi32(_mm_add_epi32(a.val, delta), n),
+			_mm_srli_epi32(_mm_add_epi32(b.val, delta), n)));
+	}
+
+	template<int n> inline
+		void v_rshr_pack_store(ushort* ptr, const v_uint32x4& a)
+	{
+		__m128i delta = _mm_set1_epi32(1 << (n - 1));
+		__m128i a1 = _mm_srli_epi32(_mm_add_epi32(a.val, delta), n);
+		_mm_storel_epi64((__m128i*)ptr, v_sse_pack_u32(a1, a1));
+	}
+
+	inline v_uint16x8 v_pack_u(const v_int32x4& a, const v_int32x4& b)
+	{
+		return v_uint16x8(v_sse_pack_s32_u16(a.val, b.val));
+	}
+
+	inline void v_pack_u_store(ushort* ptr, const v_int32x4& a)
+	{
+		_mm_storel_epi64((__m128i*)ptr, v_sse_pack_s32_u16(a.val, a.val));
+	}
+
+	template<int n> inline
+		v_uint16x8 v_rshr_pack_u(const v_int32x4& a, const v_int32x4& b)
+	{
+		__m128i delta = _mm_set1_epi32(1 << (n - 1));
+		return v_uint16x8(v_sse_pack_s32_u16(_mm_srai_epi32(_mm_add_epi32(a.val, delta), n),
+			_mm_srai_epi32(_mm_add_epi32(b.val, delta), n)));
+	}
+
+	template<int n> inline
+		void v_rshr_pack_u_store(ushort* ptr, const v_int32x4& a)
+	{
+		__m128i delta = _mm_set1_epi32(1 << (n - 1));
+		__m128i a1 = _mm_srai_epi32(_mm_add_epi32(a.val, delta), n);
+		_mm_storel_epi64((__m128i*)ptr, v_sse_pack_s32_u16(a1, a1));
+	}
+
+	inline v_int16x8 v_pack(const v_int32x4& a, const v_int32x4& b)
+	{
+		return v_int16x8(_mm_packs_epi32(a.val, b.val));
+	}
+
+	inline void v_pack_store(short* ptr, const v_int32x4& a)
+	{
+		_mm_storel_epi64((__m128i*)ptr, _mm_packs_epi32(a.val, a.val));
+	}
+
+	template<int n> inline
+		v_int16x8 v_rshr_pack(const v_int32x4& a, const v_int32x4& b)
+	{
+		__m128i delta = _mm_set1_epi32(1 << (n - 1));
+		return v_int16x8(_mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(a.val, delta), n),
+			_mm_srai_epi32(_mm_add_epi32(b.val, delta), n)));
+	}
+
+	template<int n> inline
+		void v_rshr_pack_store(short* ptr, const v_int32x4& a)
+	{
+		__m128i delta = _mm_set1_epi32(1 << (n - 1));
+		__m128i a1 = _mm_srai_epi32(_mm_add_epi32(a.val, delta), n);
+		_mm_storel_epi64((__m128i*)ptr, _mm_packs_epi32(a1, a1));
+	}
+
+	// [a0 a1 b0 b1] <- low 32 bits of the 64-bit lanes of a and b (no saturation)
+	inline __m128i v_sse_pack_epi64(__m128i a, __m128i b)
+	{
+		__m128i a1 = _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 0, 2, 0));
+		__m128i b1 = _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 0, 2, 0));
+		return _mm_unpacklo_epi64(a1, b1);
+	}
+
+	inline v_uint32x4 v_pack(const v_uint64x2& a, const v_uint64x2& b)
+	{
+		return v_uint32x4(v_sse_pack_epi64(a.val, b.val));
+	}
+
+	inline void v_pack_store(unsigned* ptr, const v_uint64x2& a)
+	{
+		_mm_storel_epi64((__m128i*)ptr, _mm_shuffle_epi32(a.val, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	inline v_int32x4 v_pack(const v_int64x2& a, const v_int64x2& b)
+	{
+		return v_int32x4(v_sse_pack_epi64(a.val, b.val));
+	}
+
+	inline void v_pack_store(int* ptr, const v_int64x2& a)
+	{
+		_mm_storel_epi64((__m128i*)ptr, _mm_shuffle_epi32(a.val, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	template<int n> inline
+		v_uint32x4 v_rshr_pack(const v_uint64x2& a, const v_uint64x2& b)
+	{
+		uint64 delta = (uint64)1 << (n - 1);
+		v_uint64x2 delta2(delta, delta);
+		__m128i a1 = _mm_srli_epi64(_mm_add_epi64(a.val, delta2.val), n);
+		__m128i b1 = _mm_srli_epi64(_mm_add_epi64(b.val, delta2.val), n);
+		return v_uint32x4(v_sse_pack_epi64(a1, b1));
+	}
+
+	template<int n> inline
+		void v_rshr_pack_store(unsigned* ptr, const v_uint64x2& a)
+	{
+		uint64 delta = (uint64)1 << (n - 1);
+		v_uint64x2 delta2(delta, delta);
+		__m128i a1 = _mm_srli_epi64(_mm_add_epi64(a.val, delta2.val), n);
+		_mm_storel_epi64((__m128i*)ptr, _mm_shuffle_epi32(a1, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	template<int n> inline
+		v_int32x4 v_rshr_pack(const v_int64x2& a, const v_int64x2& b)
+	{
+		int64 delta = (int64)1 << (n - 1);
+		v_int64x2 delta2(delta, delta);
+		__m128i a1 = v_srai_epi64(_mm_add_epi64(a.val, delta2.val), n);
+		__m128i b1 = v_srai_epi64(_mm_add_epi64(b.val, delta2.val), n);
+		return v_int32x4(v_sse_pack_epi64(a1, b1));
+	}
+
+	template<int n> inline
+		void v_rshr_pack_store(int* ptr, const v_int64x2& a)
+	{
+		int64 delta = (int64)1 << (n - 1);
+		v_int64x2 delta2(delta, delta);
+		__m128i a1 = v_srai_epi64(_mm_add_epi64(a.val, delta2.val), n);
+		_mm_storel_epi64((__m128i*)ptr, _mm_shuffle_epi32(a1, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	inline v_float32x4 v_matmul(const v_float32x4& v, const v_float32x4& m0,
+		const v_float32x4& m1, const v_float32x4& m2,
+		const v_float32x4& m3)
+	{
+		__m128 v0 = _mm_mul_ps(_mm_shuffle_ps(v.val, v.val, _MM_SHUFFLE(0, 0, 0, 0)), m0.val);
+		__m128 v1 = _mm_mul_ps(_mm_shuffle_ps(v.val, v.val, _MM_SHUFFLE(1, 1, 1, 1)), m1.val);
+		__m128 v2 = _mm_mul_ps(_mm_shuffle_ps(v.val, v.val, _MM_SHUFFLE(2, 2, 2, 2)), m2.val);
+		__m128 v3 = _mm_mul_ps(_mm_shuffle_ps(v.val, v.val, _MM_SHUFFLE(3, 3, 3, 3)), m3.val);
+
+		return v_float32x4(_mm_add_ps(_mm_add_ps(v0, v1), _mm_add_ps(v2, v3)));
+	}
+
+	inline v_float32x4 v_matmuladd(const v_float32x4& v, const v_float32x4& m0,
+		const v_float32x4& m1, const v_float32x4& m2,
+		const v_float32x4& a)
+	{
+		__m128 v0 = _mm_mul_ps(_mm_shuffle_ps(v.val, v.val, _MM_SHUFFLE(0, 0, 0, 0)), m0.val);
+		__m128 v1 = _mm_mul_ps(_mm_shuffle_ps(v.val, v.val, _MM_SHUFFLE(1, 1, 1, 1)), m1.val);
+		__m128 v2 = _mm_mul_ps(_mm_shuffle_ps(v.val, v.val, _MM_SHUFFLE(2, 2, 2, 2)), m2.val);
+
+		return v_float32x4(_mm_add_ps(_mm_add_ps(v0, v1), _mm_add_ps(v2, a.val)));
+	}
+
+	////////////////// Arithmetics //////////////////
+
+#define OPENCV_HAL_IMPL_SSE_BIN_OP(bin_op, _Tpvec, intrin) \
+inline _Tpvec operator bin_op (const _Tpvec& a, const _Tpvec& b) \
+{ \
+	return _Tpvec(intrin(a.val, b.val)); \
+} \
+inline _Tpvec& operator bin_op##= (_Tpvec& a, const _Tpvec& b) \
+{ \
+	a.val = intrin(a.val, b.val); \
+	return a; \
+}
+
+	OPENCV_HAL_IMPL_SSE_BIN_OP(+, v_uint8x16, _mm_adds_epu8)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(-, v_uint8x16, _mm_subs_epu8)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(+, v_int8x16, _mm_adds_epi8)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(-, v_int8x16, _mm_subs_epi8)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(+, v_uint16x8, _mm_adds_epu16)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(-, v_uint16x8, _mm_subs_epu16)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(+, v_int16x8, _mm_adds_epi16)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(-, v_int16x8, _mm_subs_epi16)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(+, v_uint32x4, _mm_add_epi32)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(-, v_uint32x4, _mm_sub_epi32)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(+, v_int32x4, _mm_add_epi32)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(-, v_int32x4, _mm_sub_epi32)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(+, v_float32x4, _mm_add_ps)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(-, v_float32x4, _mm_sub_ps)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(*, v_float32x4, _mm_mul_ps)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(/ , v_float32x4, _mm_div_ps)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(+, v_float64x2, _mm_add_pd)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(-, v_float64x2, _mm_sub_pd)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(*, v_float64x2, _mm_mul_pd)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(/ , v_float64x2, _mm_div_pd)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(+, v_uint64x2, _mm_add_epi64)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(-, v_uint64x2, _mm_sub_epi64)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(+, v_int64x2, _mm_add_epi64)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(-, v_int64x2, _mm_sub_epi64)
+
+	// 16-bit products saturate like the rest of the 16-bit arithmetics
+	inline __m128i v_sse_mul_epu16(__m128i a, __m128i b)
+	{
+		__m128i lo = _mm_mullo_epi16(a, b), hi = _mm_mulhi_epu16(a, b);
+		return v_sse_pack_u32(_mm_unpacklo_epi16(lo, hi), _mm_unpackhi_epi16(lo, hi));
+	}
+
+	inline __m128i v_sse_mul_epi16(__m128i a, __m128i b)
+	{
+		__m128i lo = _mm_mullo_epi16(a, b), hi = _mm_mulhi_epi16(a, b);
+		return _mm_packs_epi32(_mm_unpacklo_epi16(lo, hi), _mm_unpackhi_epi16(lo, hi));
+	}
+
+	inline __m128i v_sse_mullo_epi32(__m128i a, __m128i b)
+	{
+#if CV_SSE4_1
+		return _mm_mullo_epi32(a, b);
+#else
+		__m128i c0 = _mm_mul_epu32(a, b);
+		__m128i c1 = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		__m128i d0 = _mm_unpacklo_epi32(c0, c1);
+		__m128i d1 = _mm_unpackhi_epi32(c0, c1);
+		return _mm_unpacklo_epi64(d0, d1);
+#endif
+	}
+
+	OPENCV_HAL_IMPL_SSE_BIN_OP(*, v_uint16x8, v_sse_mul_epu16)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(*, v_int16x8, v_sse_mul_epi16)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(*, v_uint32x4, v_sse_mullo_epi32)
+	OPENCV_HAL_IMPL_SSE_BIN_OP(*, v_int32x4, v_sse_mullo_epi32)
+
+	inline void v_mul_expand(const v_int16x8& a, const v_int16x8& b,
+		v_int32x4& c, v_int32x4& d)
+	{
+		__m128i v0 = _mm_mullo_epi16(a.val, b.val);
+		__m128i v1 = _mm_mulhi_epi16(a.val, b.val);
+		c.val = _mm_unpacklo_epi16(v0, v1);
+		d.val = _mm_unpackhi_epi16(v0, v1);
+	}
+
+	inline void v_mul_expand(const v_uint16x8& a, const v_uint16x8& b,
+		v_uint32x4& c, v_uint32x4& d)
+	{
+		__m128i v0 = _mm_mullo_epi16(a.val, b.val);
+		__m128i v1 = _mm_mulhi_epu16(a.val, b.val);
+		c.val = _mm_unpacklo_epi16(v0, v1);
+		d.val = _mm_unpackhi_epi16(v0, v1);
+	}
+
+	inline void v_mul_expand(const v_uint32x4& a, const v_uint32x4& b,
+		v_uint64x2& c, v_uint64x2& d)
+	{
+		__m128i c0 = _mm_mul_epu32(a.val, b.val);
+		__m128i c1 = _mm_mul_epu32(_mm_srli_epi64(a.val, 32), _mm_srli_epi64(b.val, 32));
+		c.val = _mm_unpacklo_epi64(c0, c1);
+		d.val = _mm_unpackhi_epi64(c0, c1);
+	}
+
+	inline v_int32x4 v_dotprod(const v_int16x8& a, const v_int16x8& b)
+	{
+		return v_int32x4(_mm_madd_epi16(a.val, b.val));
+	}
+
+#define OPENCV_HAL_IMPL_SSE_LOGIC_OP(_Tpvec, suffix, not_const) \
+	OPENCV_HAL_IMPL_SSE_BIN_OP(&, _Tpvec, _mm_and_##suffix) \
+	OPENCV_HAL_IMPL_SSE_BIN_OP(| , _Tpvec, _mm_or_##suffix) \
+	OPENCV_HAL_IMPL_SSE_BIN_OP(^, _Tpvec, _mm_xor_##suffix) \
+inline _Tpvec operator ~ (const _Tpvec& a) \
+{ \
+	return _Tpvec(_mm_xor_##suffix(a.val, not_const)); \
+}
+
+	OPENCV_HAL_IMPL_SSE_LOGIC_OP(v_uint8x16, si128, _mm_set1_epi32(-1))
+	OPENCV_HAL_IMPL_SSE_LOGIC_OP(v_int8x16, si128, _mm_set1_epi32(-1))
+	OPENCV_HAL_IMPL_SSE_LOGIC_OP(v_uint16x8, si128, _mm_set1_epi32(-1))
+	OPENCV_HAL_IMPL_SSE_LOGIC_OP(v_int16x8, si128, _mm_set1_epi32(-1))
+	OPENCV_HAL_IMPL_SSE_LOGIC_OP(v_uint32x4, si128, _mm_set1_epi32(-1))
+	OPENCV_HAL_IMPL_SSE_LOGIC_OP(v_int32x4, si128, _mm_set1_epi32(-1))
+	OPENCV_HAL_IMPL_SSE_LOGIC_OP(v_uint64x2, si128, _mm_set1_epi32(-1))
+	OPENCV_HAL_IMPL_SSE_LOGIC_OP(v_int64x2, si128, _mm_set1_epi32(-1))
+	OPENCV_HAL_IMPL_SSE_LOGIC_OP(v_float32x4, ps, _mm_castsi128_ps(_mm_set1_epi32(-1)))
+	OPENCV_HAL_IMPL_SSE_LOGIC_OP(v_float64x2, pd, _mm_castsi128_pd(_mm_set1_epi32(-1)))
+
+	inline v_float32x4 v_sqrt(const v_float32x4& x)
+	{
+		return v_float32x4(_mm_sqrt_ps(x.val));
+	}
+
+	inline v_float32x4 v_invsqrt(const v_float32x4& x)
+	{
+		// one Newton-Raphson step on top of the 12-bit rsqrt estimate
+		const __m128 _0_5 = _mm_set1_ps(0.5f), _1_5 = _mm_set1_ps(1.5f);
+		__m128 t = x.val;
+		__m128 h = _mm_mul_ps(t, _0_5);
+		t = _mm_rsqrt_ps(t);
+		t = _mm_mul_ps(t, _mm_sub_ps(_1_5, _mm_mul_ps(_mm_mul_ps(t, t), h)));
+		return v_float32x4(t);
+	}
+
+	inline v_float64x2 v_sqrt(const v_float64x2& x)
+	{
+		return v_float64x2(_mm_sqrt_pd(x.val));
+	}
+
+	inline v_float64x2 v_invsqrt(const v_float64x2& x)
+	{
+		const __m128d v_1 = _mm_set1_pd(1.);
+		return v_float64x2(_mm_div_pd(v_1, _mm_sqrt_pd(x.val)));
+	}
+
+	inline v_uint8x16 v_abs(const v_int8x16& x)
+	{
+		return v_uint8x16(_mm_min_epu8(x.val, _mm_sub_epi8(_mm_setzero_si128(), x.val)));
+	}
+
+	inline v_uint16x8 v_abs(const v_int16x8& x)
+	{
+		return v_uint16x8(_mm_max_epi16(x.val, _mm_sub_epi16(_mm_setzero_si128(), x.val)));
+	}
+
+	inline v_uint32x4 v_abs(const v_int32x4& x)
+	{
+		__m128i s = _mm_srai_epi32(x.val, 31);
+		return v_uint32x4(_mm_sub_epi32(_mm_xor_si128(x.val, s), s));
+	}
+
+	inline v_float32x4 v_abs(const v_float32x4& x)
+	{
+		return v_float32x4(_mm_and_ps(x.val, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))));
+	}
+
+	inline v_float64x2 v_abs(const v_float64x2& x)
+	{
+		return v_float64x2(_mm_and_pd(x.val,
+			_mm_castsi128_pd(_mm_srli_epi64(_mm_set1_epi32(-1), 1))));
+	}
+
+	inline __m128i v_sse_min_epi8(__m128i a, __m128i b)
+	{
+#if CV_SSE4_1
+		return _mm_min_epi8(a, b);
+#else
+		__m128i delta = _mm_set1_epi8((char)-128);
+		return _mm_xor_si128(delta, _mm_min_epu8(_mm_xor_si128(a, delta), _mm_xor_si128(b, delta)));
+#endif
+	}
+
+	inline __m128i v_sse_max_epi8(__m128i a, __m128i b)
+	{
+#if CV_SSE4_1
+		return _mm_max_epi8(a, b);
+#else
+		__m128i delta = _mm_set1_epi8((char)-128);
+		return _mm_xor_si128(delta, _mm_max_epu8(_mm_xor_si128(a, delta), _mm_xor_si128(b, delta)));
+#endif
+	}
+
+	inline __m128i v_sse_min_epu16(__m128i a, __m128i b)
+	{
+#if CV_SSE4_1
+		return _mm_min_epu16(a, b);
+#else
+		return _mm_subs_epu16(a, _mm_subs_epu16(a, b));
+#endif
+	}
+
+	inline __m128i v_sse_max_epu16(__m128i a, __m128i b)
+	{
+#if CV_SSE4_1
+		return _mm_max_epu16(a, b);
+#else
+		return _mm_adds_epu16(_mm_subs_epu16(a, b), b);
+#endif
+	}
+
+	inline __m128i v_sse_min_epu32(__m128i a, __m128i b)
+	{
+#if CV_SSE4_1
+		return _mm_min_epu32(a, b);
+#else
+		__m128i delta = _mm_set1_epi32((int)0x80000000);
+		__m128i mask = _mm_cmpgt_epi32(_mm_xor_si128(a, delta), _mm_xor_si128(b, delta));
+		return v_select_si128(mask, b, a);
+#endif
+	}
+
+	inline __m128i v_sse_max_epu32(__m128i a, __m128i b)
+	{
+#if CV_SSE4_1
+		return _mm_max_epu32(a, b);
+#else
+		__m128i delta = _mm_set1_epi32((int)0x80000000);
+		__m128i mask = _mm_cmpgt_epi32(_mm_xor_si128(a, delta), _mm_xor_si128(b, delta));
+		return v_select_si128(mask, a, b);
+#endif
+	}
+
+	inline __m128i v_sse_min_epi32(__m128i a, __m128i b)
+	{
+#if CV_SSE4_1
+		return _mm_min_epi32(a, b);
+#else
+		return v_select_si128(_mm_cmpgt_epi32(a, b), b, a);
+#endif
+	}
+
+	inline __m128i v_sse_max_epi32(__m128i a, __m128i b)
+	{
+#if CV_SSE4_1
+		return _mm_max_epi32(a, b);
+#else
+		return v_select_si128(_mm_cmpgt_epi32(a, b), a, b);
+#endif
+	}
+
+#define OPENCV_HAL_IMPL_SSE_BIN_FUNC(_Tpvec, func, intrin) \
+inline _Tpvec func(const _Tpvec& a, const _Tpvec& b) \
+{ \
+	return _Tpvec(intrin(a.val, b.val)); \
+}
+
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_uint8x16, v_min, _mm_min_epu8)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_uint8x16, v_max, _mm_max_epu8)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_int8x16, v_min, v_sse_min_epi8)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_int8x16, v_max, v_sse_max_epi8)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_uint16x8, v_min, v_sse_min_epu16)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_uint16x8, v_max, v_sse_max_epu16)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_int16x8, v_min, _mm_min_epi16)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_int16x8, v_max, _mm_max_epi16)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_uint32x4, v_min, v_sse_min_epu32)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_uint32x4, v_max, v_sse_max_epu32)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_int32x4, v_min, v_sse_min_epi32)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_int32x4, v_max, v_sse_max_epi32)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_float32x4, v_min, _mm_min_ps)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_float32x4, v_max, _mm_max_ps)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_float64x2, v_min, _mm_min_pd)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_float64x2, v_max, _mm_max_pd)
+
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_uint8x16, v_add_wrap, _mm_add_epi8)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_int8x16, v_add_wrap, _mm_add_epi8)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_uint16x8, v_add_wrap, _mm_add_epi16)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_int16x8, v_add_wrap, _mm_add_epi16)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_uint8x16, v_sub_wrap, _mm_sub_epi8)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_int8x16, v_sub_wrap, _mm_sub_epi8)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_uint16x8, v_sub_wrap, _mm_sub_epi16)
+	OPENCV_HAL_IMPL_SSE_BIN_FUNC(v_int16x8, v_sub_wrap, _mm_sub_epi16)
+
+	////////////////// Comparison //////////////////
+
+#define OPENCV_HAL_IMPL_SSE_INT_CMP_OP(_Tpuvec, _Tpsvec, suffix, sbit) \
+inline _Tpuvec operator == (const _Tpuvec& a, const _Tpuvec& b) \
+{ return _Tpuvec(_mm_cmpeq_##suffix(a.val, b.val)); } \
+inline _Tpuvec operator != (const _Tpuvec& a, const _Tpuvec& b) \
+{ \
+	__m128i not_mask = _mm_set1_epi32(-1); \
+	return _Tpuvec(_mm_xor_si128(_mm_cmpeq_##suffix(a.val, b.val), not_mask)); \
+} \
+inline _Tpsvec operator == (const _Tpsvec& a, const _Tpsvec& b) \
+{ return _Tpsvec(_mm_cmpeq_##suffix(a.val, b.val)); } \
+inline _Tpsvec operator != (const _Tpsvec& a, const _Tpsvec& b) \
+{ \
+	__m128i not_mask = _mm_set1_epi32(-1); \
+	return _Tpsvec(_mm_xor_si128(_mm_cmpeq_##suffix(a.val, b.val), not_mask)); \
+} \
+inline _Tpuvec operator < (const _Tpuvec& a, const _Tpuvec& b) \
+{ \
+	__m128i smask = _mm_set1_##suffix(sbit); \
+	return _Tpuvec(_mm_cmpgt_##suffix(_mm_xor_si128(b.val, smask), _mm_xor_si128(a.val, smask))); \
+} \
+inline _Tpuvec operator > (const _Tpuvec& a, const _Tpuvec& b) \
+{ \
+	__m128i smask = _mm_set1_##suffix(sbit); \
+	return _Tpuvec(_mm_cmpgt_##suffix(_mm_xor_si128(a.val, smask), _mm_xor_si128(b.val, smask))); \
+} \
+inline _Tpuvec operator <= (const _Tpuvec& a, const _Tpuvec& b) \
+{ \
+	__m128i smask = _mm_set1_##suffix(sbit); \
+	__m128i not_mask = _mm_set1_epi32(-1); \
+	__m128i res = _mm_cmpgt_##suffix(_mm_xor_si128(a.val, smask), _mm_xor_si128(b.val, smask)); \
+	return _Tpuvec(_mm_xor_si128(res, not_mask)); \
+} \
+inline _Tpuvec operator >= (const _Tpuvec& a, const _Tpuvec& b) \
+{ \
+	__m128i smask = _mm_set1_##suffix(sbit); \
+	__m128i not_mask = _mm_set1_epi32(-1); \
+	__m128i res = _mm_cmpgt_##suffix(_mm_xor_si128(b.val, smask), _mm_xor_si128(a.val, smask)); \
+	return _Tpuvec(_mm_xor_si128(res, not_mask)); \
+} \
+inline _Tpsvec operator < (const _Tpsvec& a, const _Tpsvec& b) \
+{ \
+	return _Tpsvec(_mm_cmpgt_##suffix(b.val, a.val)); \
+} \
+inline _Tpsvec operator > (const _Tpsvec& a, const _Tpsvec& b) \
+{ \
+	return _Tpsvec(_mm_cmpgt_##suffix(a.val, b.val)); \
+} \
+inline _Tpsvec operator <= (const _Tpsvec& a, const _Tpsvec& b) \
+{ \
+	__m128i not_mask = _mm_set1_epi32(-1); \
+	return _Tpsvec(_mm_xor_si128(_mm_cmpgt_##suffix(a.val, b.val), not_mask)); \
+} \
+inline _Tpsvec operator >= (const _Tpsvec& a, const _Tpsvec& b) \
+{ \
+	__m128i not_mask = _mm_set1_epi32(-1); \
+	return _Tpsvec(_mm_xor_si128(_mm_cmpgt_##suffix(b.val, a.val), not_mask)); \
+}
+
+	OPENCV_HAL_IMPL_SSE_INT_CMP_OP(v_uint8x16, v_int8x16, epi8, (char)-128)
+	OPENCV_HAL_IMPL_SSE_INT_CMP_OP(v_uint16x8, v_int16x8, epi16, (short)-32768)
+	OPENCV_HAL_IMPL_SSE_INT_CMP_OP(v_uint32x4, v_int32x4, epi32, (int)0x80000000)
+
+#define OPENCV_HAL_IMPL_SSE_FLT_CMP_OP(_Tpvec, suffix) \
+inline _Tpvec operator == (const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(_mm_cmpeq_##suffix(a.val, b.val)); } \
+inline _Tpvec operator != (const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(_mm_cmpneq_##suffix(a.val, b.val)); } \
+inline _Tpvec operator < (const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(_mm_cmplt_##suffix(a.val, b.val)); } \
+inline _Tpvec operator > (const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(_mm_cmpgt_##suffix(a.val, b.val)); } \
+inline _Tpvec operator <= (const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(_mm_cmple_##suffix(a.val, b.val)); } \
+inline _Tpvec operator >= (const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(_mm_cmpge_##suffix(a.val, b.val)); }
+
+	OPENCV_HAL_IMPL_SSE_FLT_CMP_OP(v_float32x4, ps)
+	OPENCV_HAL_IMPL_SSE_FLT_CMP_OP(v_float64x2, pd)
+
+	////////////////// Absolute difference, magnitude, multiply-add //////////////////
+
+	inline v_uint8x16 v_absdiff(const v_uint8x16& a, const v_uint8x16& b)
+	{
+		return v_uint8x16(_mm_add_epi8(_mm_subs_epu8(a.val, b.val), _mm_subs_epu8(b.val, a.val)));
+	}
+
+	inline v_uint16x8 v_absdiff(const v_uint16x8& a, const v_uint16x8& b)
+	{
+		return v_uint16x8(_mm_add_epi16(_mm_subs_epu16(a.val, b.val), _mm_subs_epu16(b.val, a.val)));
+	}
+
+	inline v_uint32x4 v_absdiff(const v_uint32x4& a, const v_uint32x4& b)
+	{
+		return v_uint32x4(_mm_sub_epi32(v_sse_max_epu32(a.val, b.val), v_sse_min_epu32(a.val, b.val)));
+	}
+
+	inline v_uint8x16 v_absdiff(const v_int8x16& a, const v_int8x16& b)
+	{
+		__m128i d = _mm_sub_epi8(a.val, b.val);
+		__m128i m = _mm_cmpgt_epi8(b.val, a.val);
+		return v_uint8x16(_mm_sub_epi8(_mm_xor_si128(d, m), m));
+	}
+
+	inline v_uint16x8 v_absdiff(const v_int16x8& a, const v_int16x8& b)
+	{
+		return v_uint16x8(_mm_sub_epi16(_mm_max_epi16(a.val, b.val), _mm_min_epi16(a.val, b.val)));
+	}
+
+	inline v_uint32x4 v_absdiff(const v_int32x4& a, const v_int32x4& b)
+	{
+		__m128i d = _mm_sub_epi32(a.val, b.val);
+		__m128i m = _mm_cmpgt_epi32(b.val, a.val);
+		return v_uint32x4(_mm_sub_epi32(_mm_xor_si128(d, m), m));
+	}
+
+#define OPENCV_HAL_IMPL_SSE_MISC_FLT_OP(_Tpvec, _Tp, _Tpreg, suffix, absmask_vec) \
+inline _Tpvec v_absdiff(const _Tpvec& a, const _Tpvec& b) \
+{ \
+	_Tpreg absmask = absmask_vec; \
+	return _Tpvec(_mm_and_##suffix(_mm_sub_##suffix(a.val, b.val), absmask)); \
+} \
+inline _Tpvec v_magnitude(const _Tpvec& a, const _Tpvec& b) \
+{ \
+	_Tpreg res = _mm_add_##suffix(_mm_mul_##suffix(a.val, a.val), _mm_mul_##suffix(b.val, b.val)); \
+	return _Tpvec(_mm_sqrt_##suffix(res)); \
+} \
+inline _Tpvec v_sqr_magnitude(const _Tpvec& a, const _Tpvec& b) \
+{ \
+	_Tpreg res = _mm_add_##suffix(_mm_mul_##suffix(a.val, a.val), _mm_mul_##suffix(b.val, b.val)); \
+	return _Tpvec(res); \
+}
+
+	OPENCV_HAL_IMPL_SSE_MISC_FLT_OP(v_float32x4, float, __m128, ps, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)))
+	OPENCV_HAL_IMPL_SSE_MISC_FLT_OP(v_float64x2, double, __m128d, pd, _mm_castsi128_pd(_mm_srli_epi64(_mm_set1_epi32(-1), 1)))
+
+	inline v_float32x4 v_muladd(const v_float32x4& a, const v_float32x4& b, const v_float32x4& c)
+	{
+#if CV_FMA3
+		return v_float32x4(_mm_fmadd_ps(a.val, b.val, c.val));
+#else
+		return v_float32x4(_mm_add_ps(_mm_mul_ps(a.val, b.val), c.val));
+#endif
+	}
+
+	inline v_float64x2 v_muladd(const v_float64x2& a, const v_float64x2& b, const v_float64x2& c)
+	{
+#if CV_FMA3
+		return v_float64x2(_mm_fmadd_pd(a.val, b.val, c.val));
+#else
+		return v_float64x2(_mm_add_pd(_mm_mul_pd(a.val, b.val), c.val));
+#endif
+	}
+
+	inline v_int32x4 v_muladd(const v_int32x4& a, const v_int32x4& b, const v_int32x4& c)
+	{
+		return v_int32x4(_mm_add_epi32(v_sse_mullo_epi32(a.val, b.val), c.val));
+	}
+
+	////////////////// Shifts //////////////////
+
+#define OPENCV_HAL_IMPL_SSE_SHIFT_OP(_Tpuvec, _Tpsvec, suffix, srai) \
+inline _Tpuvec operator << (const _Tpuvec& a, int imm) \
+{ \
+	return _Tpuvec(_mm_slli_##suffix(a.val, imm)); \
+} \
+inline _Tpsvec operator << (const _Tpsvec& a, int imm) \
+{ \
+	return _Tpsvec(_mm_slli_##suffix(a.val, imm)); \
+} \
+inline _Tpuvec operator >> (const _Tpuvec& a, int imm) \
+{ \
+	return _Tpuvec(_mm_srli_##suffix(a.val, imm)); \
+} \
+inline _Tpsvec operator >> (const _Tpsvec& a, int imm) \
+{ \
+	return _Tpsvec(srai(a.val, imm)); \
+} \
+template<int imm> \
+inline _Tpuvec v_shl(const _Tpuvec& a) \
+{ \
+	return _Tpuvec(_mm_slli_##suffix(a.val, imm)); \
+} \
+template<int imm> \
+inline _Tpsvec v_shl(const _Tpsvec& a) \
+{ \
+	return _Tpsvec(_mm_slli_##suffix(a.val, imm)); \
+} \
+template<int imm> \
+inline _Tpuvec v_shr(const _Tpuvec& a) \
+{ \
+	return _Tpuvec(_mm_srli_##suffix(a.val, imm)); \
+} \
+template<int imm> \
+inline _Tpsvec v_shr(const _Tpsvec& a) \
+{ \
+	return _Tpsvec(srai(a.val, imm)); \
+}
+
+	OPENCV_HAL_IMPL_SSE_SHIFT_OP(v_uint16x8, v_int16x8, epi16, _mm_srai_epi16)
+	OPENCV_HAL_IMPL_SSE_SHIFT_OP(v_uint32x4, v_int32x4, epi32, _mm_srai_epi32)
+	OPENCV_HAL_IMPL_SSE_SHIFT_OP(v_uint64x2, v_int64x2, epi64, v_srai_epi64)
+
+	// (a + (1 << (n-1))) >> n without the 16-bit wrap-around of the sum
+	template<int n> inline v_uint16x8 v_rshr(const v_uint16x8& a)
+	{
+		__m128i one = _mm_set1_epi16(1);
+		return v_uint16x8(_mm_add_epi16(_mm_srli_epi16(a.val, n), _mm_and_si128(_mm_srli_epi16(a.val, n - 1), one)));
+	}
+	template<int n> inline v_int16x8 v_rshr(const v_int16x8& a)
+	{
+		__m128i one = _mm_set1_epi16(1);
+		return v_int16x8(_mm_add_epi16(_mm_srai_epi16(a.val, n), _mm_and_si128(_mm_srai_epi16(a.val, n - 1), one)));
+	}
+	template<int n> inline v_uint32x4 v_rshr(const v_uint32x4& a)
+	{
+		return v_uint32x4(_mm_srli_epi32(_mm_add_epi32(a.val, _mm_set1_epi32(1 << (n - 1))), n));
+	}
+	template<int n> inline v_int32x4 v_rshr(const v_int32x4& a)
+	{
+		return v_int32x4(_mm_srai_epi32(_mm_add_epi32(a.val, _mm_set1_epi32(1 << (n - 1))), n));
+	}
+	template<int n> inline v_uint64x2 v_rshr(const v_uint64x2& a)
+	{
+		uint64 delta = (uint64)1 << (n - 1);
+		return v_uint64x2(_mm_srli_epi64(_mm_add_epi64(a.val, v_uint64x2(delta, delta).val), n));
+	}
+	template<int n> inline v_int64x2 v_rshr(const v_int64x2& a)
+	{
+		int64 delta = (int64)1 << (n - 1);
+		return v_int64x2(v_srai_epi64(_mm_add_epi64(a.val, v_int64x2(delta, delta).val), n));
+	}
+
+	////////////////// Rotate //////////////////
+
+	// lane rotations are whole-register byte shifts; the two-register forms
+	// shift in the lanes of the second argument just like intrin_cpp.hpp does
+#define OPENCV_HAL_IMPL_SSE_ROTATE_OP(_Tpvec, cast_from, cast_to) \
+template<int imm> \
+inline _Tpvec v_rotate_right(const _Tpvec& a) \
+{ \
+	enum { CV_SHIFT = imm*(sizeof(typename _Tpvec::lane_type)) }; \
+	return _Tpvec(cast_to(_mm_srli_si128(cast_from(a.val), CV_SHIFT))); \
+} \
+template<int imm> \
+inline _Tpvec v_rotate_left(const _Tpvec& a) \
+{ \
+	enum { CV_SHIFT = imm*(sizeof(typename _Tpvec::lane_type)) }; \
+	return _Tpvec(cast_to(_mm_slli_si128(cast_from(a.val), CV_SHIFT))); \
+} \
+template<int imm> \
+inline _Tpvec v_rotate_right(const _Tpvec& a, const _Tpvec& b) \
+{ \
+	enum { CV_SHIFT1 = imm*(sizeof(typename _Tpvec::lane_type)) }; \
+	enum { CV_SHIFT2 = 16 - imm*(sizeof(typename _Tpvec::lane_type)) }; \
+	return _Tpvec(cast_to(_mm_or_si128(_mm_srli_si128(cast_from(a.val), CV_SHIFT1), \
+		_mm_slli_si128(cast_from(b.val), CV_SHIFT2)))); \
+} \
+template<int imm> \
+inline _Tpvec v_rotate_left(const _Tpvec& a, const _Tpvec& b) \
+{ \
+	enum { CV_SHIFT1 = imm*(sizeof(typename _Tpvec::lane_type)) }; \
+	enum { CV_SHIFT2 = 16 - imm*(sizeof(typename _Tpvec::lane_type)) }; \
+	return _Tpvec(cast_to(_mm_or_si128(_mm_slli_si128(cast_from(a.val), CV_SHIFT1), \
+		_mm_srli_si128(cast_from(b.val), CV_SHIFT2)))); \
+}
+
+	OPENCV_HAL_IMPL_SSE_ROTATE_OP(v_uint8x16, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_ROTATE_OP(v_int8x16, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_ROTATE_OP(v_uint16x8, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_ROTATE_OP(v_int16x8, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_ROTATE_OP(v_uint32x4, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_ROTATE_OP(v_int32x4, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_ROTATE_OP(v_uint64x2, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_ROTATE_OP(v_int64x2, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_ROTATE_OP(v_float32x4, _mm_castps_si128, _mm_castsi128_ps)
+	OPENCV_HAL_IMPL_SSE_ROTATE_OP(v_float64x2, _mm_castpd_si128, _mm_castsi128_pd)
+
+	template<int s, typename _Tpvec>
+	inline _Tpvec v_extract(const _Tpvec& a, const _Tpvec& b)
+	{
+		return v_rotate_right<s>(a, b);
+	}
+
+	////////////////// Reductions //////////////////
+
+#define OPENCV_HAL_IMPL_SSE_REDUCE_OP_16(_Tpvec, scalartype, func) \
+inline scalartype v_reduce_##func(const _Tpvec& a) \
+{ \
+	_Tpvec v = v_##func(a, _Tpvec(_mm_srli_si128(a.val, 8))); \
+	v = v_##func(v, _Tpvec(_mm_srli_si128(v.val, 4))); \
+	v = v_##func(v, _Tpvec(_mm_srli_si128(v.val, 2))); \
+	v = v_##func(v, _Tpvec(_mm_srli_si128(v.val, 1))); \
+	return v.get0(); \
+}
+
+#define OPENCV_HAL_IMPL_SSE_REDUCE_OP_8(_Tpvec, scalartype, func) \
+inline scalartype v_reduce_##func(const _Tpvec& a) \
+{ \
+	_Tpvec v = v_##func(a, _Tpvec(_mm_srli_si128(a.val, 8))); \
+	v = v_##func(v, _Tpvec(_mm_srli_si128(v.val, 4))); \
+	v = v_##func(v, _Tpvec(_mm_srli_si128(v.val, 2))); \
+	return v.get0(); \
+}
+
+#define OPENCV_HAL_IMPL_SSE_REDUCE_OP_4(_Tpvec, scalartype, func) \
+inline scalartype v_reduce_##func(const _Tpvec& a) \
+{ \
+	_Tpvec v = v_##func(a, _Tpvec(_mm_srli_si128(a.val, 8))); \
+	v = v_##func(v, _Tpvec(_mm_srli_si128(v.val, 4))); \
+	return v.get0(); \
+}
+
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_16(v_uint8x16, uchar, max)
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_16(v_uint8x16, uchar, min)
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_16(v_int8x16, schar, max)
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_16(v_int8x16, schar, min)
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_8(v_uint16x8, ushort, max)
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_8(v_uint16x8, ushort, min)
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_8(v_int16x8, short, max)
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_8(v_int16x8, short, min)
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_4(v_uint32x4, unsigned, max)
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_4(v_uint32x4, unsigned, min)
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_4(v_int32x4, int, max)
+	OPENCV_HAL_IMPL_SSE_REDUCE_OP_4(v_int32x4, int, min)
+
+	inline float v_reduce_max(const v_float32x4& a)
+	{
+		__m128 val = _mm_max_ps(a.val, _mm_movehl_ps(a.val, a.val));
+		val = _mm_max_ss(val, _mm_shuffle_ps(val, val, _MM_SHUFFLE(1, 1, 1, 1)));
+		return _mm_cvtss_f32(val);
+	}
+
+	inline float v_reduce_min(const v_float32x4& a)
+	{
+		__m128 val = _mm_min_ps(a.val, _mm_movehl_ps(a.val, a.val));
+		val = _mm_min_ss(val, _mm_shuffle_ps(val, val, _MM_SHUFFLE(1, 1, 1, 1)));
+		return _mm_cvtss_f32(val);
+	}
+
+	inline int v_sse_reduce_sum_epi32(__m128i val)
+	{
+		val = _mm_add_epi32(val, _mm_srli_si128(val, 8));
+		val = _mm_add_epi32(val, _mm_srli_si128(val, 4));
+		return _mm_cvtsi128_si32(val);
+	}
+
+	inline int v_reduce_sum(const v_uint8x16& a)
+	{
+		__m128i s = _mm_sad_epu8(a.val, _mm_setzero_si128());
+		return _mm_cvtsi128_si32(_mm_add_epi32(s, _mm_unpackhi_epi64(s, s)));
+	}
+
+	inline int v_reduce_sum(const v_int8x16& a)
+	{
+		__m128i s = _mm_sad_epu8(_mm_xor_si128(a.val, _mm_set1_epi8((char)-128)), _mm_setzero_si128());
+		return _mm_cvtsi128_si32(_mm_add_epi32(s, _mm_unpackhi_epi64(s, s))) - 128 * 16;
+	}
+
+	inline int v_reduce_sum(const v_uint16x8& a)
+	{
+		__m128i s = _mm_madd_epi16(_mm_xor_si128(a.val, _mm_set1_epi16((short)-32768)), _mm_set1_epi16(1));
+		return v_sse_reduce_sum_epi32(s) + 32768 * 8;
+	}
+
+	inline int v_reduce_sum(const v_int16x8& a)
+	{
+		return v_sse_reduce_sum_epi32(_mm_madd_epi16(a.val, _mm_set1_epi16(1)));
+	}
+
+	inline unsigned v_reduce_sum(const v_uint32x4& a)
+	{
+		return (unsigned)v_sse_reduce_sum_epi32(a.val);
+	}
+
+	inline int v_reduce_sum(const v_int32x4& a)
+	{
+		return v_sse_reduce_sum_epi32(a.val);
+	}
+
+	inline float v_reduce_sum(const v_float32x4& a)
+	{
+		__m128 val = _mm_add_ps(a.val, _mm_movehl_ps(a.val, a.val));
+		val = _mm_add_ss(val, _mm_shuffle_ps(val, val, _MM_SHUFFLE(1, 1, 1, 1)));
+		return _mm_cvtss_f32(val);
+	}
+
+	inline double v_reduce_sum(const v_float64x2& a)
+	{
+		return _mm_cvtsd_f64(_mm_add_sd(a.val, _mm_unpackhi_pd(a.val, a.val)));
+	}
+
+	inline v_float32x4 v_reduce_sum4(const v_float32x4& a, const v_float32x4& b,
+		const v_float32x4& c, const v_float32x4& d)
+	{
+#if CV_SSE3
+		__m128 ab = _mm_hadd_ps(a.val, b.val);
+		__m128 cd = _mm_hadd_ps(c.val, d.val);
+		return v_float32x4(_mm_hadd_ps(ab, cd));
+#else
+		__m128 ab = _mm_add_ps(_mm_unpacklo_ps(a.val, b.val), _mm_unpackhi_ps(a.val, b.val));
+		__m128 cd = _mm_add_ps(_mm_unpacklo_ps(c.val, d.val), _mm_unpackhi_ps(c.val, d.val));
+		return v_float32x4(_mm_add_ps(_mm_movelh_ps(ab, cd), _mm_movehl_ps(cd, ab)));
+#endif
+	}
+
+#define OPENCV_HAL_IMPL_SSE_POPCOUNT(_Tpvec) \
+inline v_uint32x4 v_popcount(const _Tpvec& a) \
+{ \
+	__m128i m1 = _mm_set1_epi32(0x55555555); \
+	__m128i m2 = _mm_set1_epi32(0x33333333); \
+	__m128i m4 = _mm_set1_epi32(0x0f0f0f0f); \
+	__m128i p = a.val; \
+	p = _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(p, 1), m1), _mm_and_si128(p, m1)); \
+	p = _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(p, 2), m2), _mm_and_si128(p, m2)); \
+	p = _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(p, 4), m4), _mm_and_si128(p, m4)); \
+	p = _mm_add_epi8(p, _mm_srli_epi32(p, 8)); \
+	p = _mm_add_epi8(p, _mm_srli_epi32(p, 16)); \
+	return v_uint32x4(_mm_and_si128(p, _mm_set1_epi32(0xff))); \
+}
+
+	OPENCV_HAL_IMPL_SSE_POPCOUNT(v_uint8x16)
+	OPENCV_HAL_IMPL_SSE_POPCOUNT(v_uint16x8)
+	OPENCV_HAL_IMPL_SSE_POPCOUNT(v_uint32x4)
+	OPENCV_HAL_IMPL_SSE_POPCOUNT(v_int8x16)
+	OPENCV_HAL_IMPL_SSE_POPCOUNT(v_int16x8)
+	OPENCV_HAL_IMPL_SSE_POPCOUNT(v_int32x4)
+	OPENCV_HAL_IMPL_SSE_POPCOUNT(v_uint64x2)
+	OPENCV_HAL_IMPL_SSE_POPCOUNT(v_int64x2)
+
+#define OPENCV_HAL_IMPL_SSE_CHECK_SIGNS(_Tpvec, suffix, pack_op, and_op, signmask, allmask) \
+inline int v_signmask(const _Tpvec& a) \
+{ \
+	return and_op(_mm_movemask_##suffix(pack_op(a.val)), signmask); \
+} \
+inline bool v_check_all(const _Tpvec& a) \
+{ return and_op(_mm_movemask_##suffix(a.val), allmask) == allmask; } \
+inline bool v_check_any(const _Tpvec& a) \
+{ return and_op(_mm_movemask_##suffix(a.val), allmask) != 0; }
+
+#define OPENCV_HAL_PACKS(a) _mm_packs_epi16(a, a)
+	inline __m128i v_packq_epi32(__m128i a)
+	{
+		__m128i b = _mm_packs_epi32(a, a);
+		return _mm_packs_epi16(b, b);
+	}
+
+	OPENCV_HAL_IMPL_SSE_CHECK_SIGNS(v_uint8x16, epi8, OPENCV_HAL_NOP, OPENCV_HAL_1ST, 65535, 65535)
+	OPENCV_HAL_IMPL_SSE_CHECK_SIGNS(v_int8x16, epi8, OPENCV_HAL_NOP, OPENCV_HAL_1ST, 65535, 65535)
+	OPENCV_HAL_IMPL_SSE_CHECK_SIGNS(v_uint16x8, epi8, OPENCV_HAL_PACKS, OPENCV_HAL_AND, 255, (int)0xaaaa)
+	OPENCV_HAL_IMPL_SSE_CHECK_SIGNS(v_int16x8, epi8, OPENCV_HAL_PACKS, OPENCV_HAL_AND, 255, (int)0xaaaa)
+	OPENCV_HAL_IMPL_SSE_CHECK_SIGNS(v_uint32x4, epi8, v_packq_epi32, OPENCV_HAL_AND, 15, (int)0x8888)
+	OPENCV_HAL_IMPL_SSE_CHECK_SIGNS(v_int32x4, epi8, v_packq_epi32, OPENCV_HAL_AND, 15, (int)0x8888)
+	OPENCV_HAL_IMPL_SSE_CHECK_SIGNS(v_float32x4, ps, OPENCV_HAL_NOP, OPENCV_HAL_1ST, 15, 15)
+	OPENCV_HAL_IMPL_SSE_CHECK_SIGNS(v_float64x2, pd, OPENCV_HAL_NOP, OPENCV_HAL_1ST, 3, 3)
+
+	inline int v_signmask(const v_uint64x2& a) { return _mm_movemask_pd(_mm_castsi128_pd(a.val)); }
+	inline int v_signmask(const v_int64x2& a) { return _mm_movemask_pd(_mm_castsi128_pd(a.val)); }
+
+#if CV_SSE4_1
+#define OPENCV_HAL_IMPL_SSE_SELECT(_Tpvec, suffix) \
+inline _Tpvec v_select(const _Tpvec& mask, const _Tpvec& a, const _Tpvec& b) \
+{ \
+	return _Tpvec(_mm_blendv_##suffix(b.val, a.val, mask.val)); \
+}
+
+	OPENCV_HAL_IMPL_SSE_SELECT(v_uint8x16, epi8)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_int8x16, epi8)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_uint16x8, epi8)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_int16x8, epi8)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_uint32x4, epi8)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_int32x4, epi8)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_uint64x2, epi8)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_int64x2, epi8)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_float32x4, ps)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_float64x2, pd)
+#else
+#define OPENCV_HAL_IMPL_SSE_SELECT(_Tpvec, suffix) \
+inline _Tpvec v_select(const _Tpvec& mask, const _Tpvec& a, const _Tpvec& b) \
+{ \
+	return _Tpvec(_mm_xor_##suffix(b.val, _mm_and_##suffix(_mm_xor_##suffix(b.val, a.val), mask.val))); \
+}
+
+	OPENCV_HAL_IMPL_SSE_SELECT(v_uint8x16, si128)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_int8x16, si128)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_uint16x8, si128)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_int16x8, si128)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_uint32x4, si128)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_int32x4, si128)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_uint64x2, si128)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_int64x2, si128)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_float32x4, ps)
+	OPENCV_HAL_IMPL_SSE_SELECT(v_float64x2, pd)
+#endif
+
+	////////////////// Expand //////////////////
+
+#define OPENCV_HAL_IMPL_SSE_EXPAND(_Tpuvec, _Tpwuvec, _Tpu, _Tpsvec, _Tpwsvec, _Tps, suffix, wsuffix, shift) \
+inline void v_expand(const _Tpuvec& a, _Tpwuvec& b0, _Tpwuvec& b1) \
+{ \
+	__m128i z = _mm_setzero_si128(); \
+	b0.val = _mm_unpacklo_##suffix(a.val, z); \
+	b1.val = _mm_unpackhi_##suffix(a.val, z); \
+} \
+inline _Tpwuvec v_load_expand(const _Tpu* ptr) \
+{ \
+	__m128i z = _mm_setzero_si128(); \
+	return _Tpwuvec(_mm_unpacklo_##suffix(_mm_loadl_epi64((const __m128i*)ptr), z)); \
+} \
+inline void v_expand(const _Tpsvec& a, _Tpwsvec& b0, _Tpwsvec& b1) \
+{ \
+	b0.val = _mm_srai_##wsuffix(_mm_unpacklo_##suffix(a.val, a.val), shift); \
+	b1.val = _mm_srai_##wsuffix(_mm_unpackhi_##suffix(a.val, a.val), shift); \
+} \
+inline _Tpwsvec v_load_expand(const _Tps* ptr) \
+{ \
+	__m128i a = _mm_loadl_epi64((const __m128i*)ptr); \
+	return _Tpwsvec(_mm_srai_##wsuffix(_mm_unpacklo_##suffix(a, a), shift)); \
+}
+
+	OPENCV_HAL_IMPL_SSE_EXPAND(v_uint8x16, v_uint16x8, uchar, v_int8x16, v_int16x8, schar, epi8, epi16, 8)
+	OPENCV_HAL_IMPL_SSE_EXPAND(v_uint16x8, v_uint32x4, ushort, v_int16x8, v_int32x4, short, epi16, epi32, 16)
+
+	inline void v_expand(const v_uint32x4& a, v_uint64x2& b0, v_uint64x2& b1)
+	{
+		__m128i z = _mm_setzero_si128();
+		b0.val = _mm_unpacklo_epi32(a.val, z);
+		b1.val = _mm_unpackhi_epi32(a.val, z);
+	}
+	inline v_uint64x2 v_load_expand(const unsigned* ptr)
+	{
+		__m128i z = _mm_setzero_si128();
+		return v_uint64x2(_mm_unpacklo_epi32(_mm_loadl_epi64((const __m128i*)ptr), z));
+	}
+	inline void v_expand(const v_int32x4& a, v_int64x2& b0, v_int64x2& b1)
+	{
+		__m128i s = _mm_srai_epi32(a.val, 31);
+		b0.val = _mm_unpacklo_epi32(a.val, s);
+		b1.val = _mm_unpackhi_epi32(a.val, s);
+	}
+	inline v_int64x2 v_load_expand(const int* ptr)
+	{
+		__m128i a = _mm_loadl_epi64((const __m128i*)ptr);
+		__m128i s = _mm_srai_epi32(a, 31);
+		return v_int64x2(_mm_unpacklo_epi32(a, s));
+	}
+
+	inline v_uint32x4 v_load_expand_q(const uchar* ptr)
+	{
+		__m128i z = _mm_setzero_si128();
+		__m128i a = _mm_cvtsi32_si128(*(const int*)ptr);
+		return v_uint32x4(_mm_unpacklo_epi16(_mm_unpacklo_epi8(a, z), z));
+	}
+
+	inline v_int32x4 v_load_expand_q(const schar* ptr)
+	{
+		__m128i a = _mm_cvtsi32_si128(*(const int*)ptr);
+		a = _mm_unpacklo_epi8(a, a);
+		a = _mm_unpacklo_epi8(a, a);
+		return v_int32x4(_mm_srai_epi32(a, 24));
+	}
+
+	////////////////// Loads and stores //////////////////
+
+#define OPENCV_HAL_IMPL_SSE_LOADSTORE_INT_OP(_Tpvec, _Tp) \
+inline _Tpvec v_load(const _Tp* ptr) \
+{ return _Tpvec(_mm_loadu_si128((const __m128i*)ptr)); } \
+inline _Tpvec v_load_aligned(const _Tp* ptr) \
+{ return _Tpvec(_mm_load_si128((const __m128i*)ptr)); } \
+inline _Tpvec v_load_low(const _Tp* ptr) \
+{ return _Tpvec(_mm_loadl_epi64((const __m128i*)ptr)); } \
+inline _Tpvec v_load_halves(const _Tp* ptr0, const _Tp* ptr1) \
+{ \
+	return _Tpvec(_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)ptr0), \
+		_mm_loadl_epi64((const __m128i*)ptr1))); \
+} \
+inline void v_store(_Tp* ptr, const _Tpvec& a) \
+{ _mm_storeu_si128((__m128i*)ptr, a.val); } \
+inline void v_store_aligned(_Tp* ptr, const _Tpvec& a) \
+{ _mm_store_si128((__m128i*)ptr, a.val); } \
+inline void v_store_low(_Tp* ptr, const _Tpvec& a) \
+{ _mm_storel_epi64((__m128i*)ptr, a.val); } \
+inline void v_store_high(_Tp* ptr, const _Tpvec& a) \
+{ _mm_storel_epi64((__m128i*)ptr, _mm_unpackhi_epi64(a.val, a.val)); }
+
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INT_OP(v_uint8x16, uchar)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INT_OP(v_int8x16, schar)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INT_OP(v_uint16x8, ushort)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INT_OP(v_int16x8, short)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INT_OP(v_uint32x4, unsigned)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INT_OP(v_int32x4, int)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INT_OP(v_uint64x2, uint64)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INT_OP(v_int64x2, int64)
+
+#define OPENCV_HAL_IMPL_SSE_LOADSTORE_FLT_OP(_Tpvec, _Tp, suffix) \
+inline _Tpvec v_load(const _Tp* ptr) \
+{ return _Tpvec(_mm_loadu_##suffix(ptr)); } \
+inline _Tpvec v_load_aligned(const _Tp* ptr) \
+{ return _Tpvec(_mm_load_##suffix(ptr)); } \
+inline _Tpvec v_load_low(const _Tp* ptr) \
+{ return _Tpvec(_mm_castsi128_##suffix(_mm_loadl_epi64((const __m128i*)ptr))); } \
+inline _Tpvec v_load_halves(const _Tp* ptr0, const _Tp* ptr1) \
+{ \
+	return _Tpvec(_mm_castsi128_##suffix( \
+		_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)ptr0), \
+			_mm_loadl_epi64((const __m128i*)ptr1)))); \
+} \
+inline void v_store(_Tp* ptr, const _Tpvec& a) \
+{ _mm_storeu_##suffix(ptr, a.val); } \
+inline void v_store_aligned(_Tp* ptr, const _Tpvec& a) \
+{ _mm_store_##suffix(ptr, a.val); } \
+inline void v_store_low(_Tp* ptr, const _Tpvec& a) \
+{ _mm_storel_epi64((__m128i*)ptr, _mm_cast##suffix##_si128(a.val)); } \
+inline void v_store_high(_Tp* ptr, const _Tpvec& a) \
+{ \
+	__m128i a1 = _mm_cast##suffix##_si128(a.val); \
+	_mm_storel_epi64((__m128i*)ptr, _mm_unpackhi_epi64(a1, a1)); \
+}
+
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_FLT_OP(v_float32x4, float, ps)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_FLT_OP(v_float64x2, double, pd)
+
+	////////////////// Zip and combine //////////////////
+
+#define OPENCV_HAL_IMPL_SSE_UNPACKS(_Tpvec, suffix, cast_from, cast_to) \
+inline void v_zip(const _Tpvec& a0, const _Tpvec& a1, _Tpvec& b0, _Tpvec& b1) \
+{ \
+	b0.val = _mm_unpacklo_##suffix(a0.val, a1.val); \
+	b1.val = _mm_unpackhi_##suffix(a0.val, a1.val); \
+} \
+inline _Tpvec v_combine_low(const _Tpvec& a, const _Tpvec& b) \
+{ \
+	__m128i a1 = cast_from(a.val), b1 = cast_from(b.val); \
+	return _Tpvec(cast_to(_mm_unpacklo_epi64(a1, b1))); \
+} \
+inline _Tpvec v_combine_high(const _Tpvec& a, const _Tpvec& b) \
+{ \
+	__m128i a1 = cast_from(a.val), b1 = cast_from(b.val); \
+	return _Tpvec(cast_to(_mm_unpackhi_epi64(a1, b1))); \
+} \
+inline void v_recombine(const _Tpvec& a, const _Tpvec& b, _Tpvec& c, _Tpvec& d) \
+{ \
+	__m128i a1 = cast_from(a.val), b1 = cast_from(b.val); \
+	c.val = cast_to(_mm_unpacklo_epi64(a1, b1)); \
+	d.val = cast_to(_mm_unpackhi_epi64(a1, b1)); \
+}
+
+	OPENCV_HAL_IMPL_SSE_UNPACKS(v_uint8x16, epi8, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_UNPACKS(v_int8x16, epi8, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_UNPACKS(v_uint16x8, epi16, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_UNPACKS(v_int16x8, epi16, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_UNPACKS(v_uint32x4, epi32, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_UNPACKS(v_int32x4, epi32, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_UNPACKS(v_uint64x2, epi64, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_UNPACKS(v_int64x2, epi64, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_UNPACKS(v_float32x4, ps, _mm_castps_si128, _mm_castsi128_ps)
+	OPENCV_HAL_IMPL_SSE_UNPACKS(v_float64x2, pd, _mm_castpd_si128, _mm_castsi128_pd)
+
+	////////////////// Conversions //////////////////
+
+	inline v_int32x4 v_round(const v_float32x4& a)
+	{
+		return v_int32x4(_mm_cvtps_epi32(a.val));
+	}
+
+	inline v_int32x4 v_floor(const v_float32x4& a)
+	{
+		__m128i a1 = _mm_cvtps_epi32(a.val);
+		__m128i mask = _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(a1), a.val));
+		return v_int32x4(_mm_add_epi32(a1, mask));
+	}
+
+	inline v_int32x4 v_ceil(const v_float32x4& a)
+	{
+		__m128i a1 = _mm_cvtps_epi32(a.val);
+		__m128i mask = _mm_castps_si128(_mm_cmpgt_ps(a.val, _mm_cvtepi32_ps(a1)));
+		return v_int32x4(_mm_sub_epi32(a1, mask));
+	}
+
+	inline v_int32x4 v_trunc(const v_float32x4& a)
+	{
+		return v_int32x4(_mm_cvttps_epi32(a.val));
+	}
+
+	inline v_int32x4 v_round(const v_float64x2& a)
+	{
+		return v_int32x4(_mm_cvtpd_epi32(a.val));
+	}
+
+	inline v_int32x4 v_floor(const v_float64x2& a)
+	{
+		__m128i a1 = _mm_cvtpd_epi32(a.val);
+		__m128i mask = _mm_castpd_si128(_mm_cmpgt_pd(_mm_cvtepi32_pd(a1), a.val));
+		mask = _mm_srli_si128(_mm_slli_si128(mask, 4), 8); // m0 m0 m1 m1 => m0 m1 0 0
+		return v_int32x4(_mm_add_epi32(a1, mask));
+	}
+
+	inline v_int32x4 v_ceil(const v_float64x2& a)
+	{
+		__m128i a1 = _mm_cvtpd_epi32(a.val);
+		__m128i mask = _mm_castpd_si128(_mm_cmpgt_pd(a.val, _mm_cvtepi32_pd(a1)));
+		mask = _mm_srli_si128(_mm_slli_si128(mask, 4), 8); // m0 m0 m1 m1 => m0 m1 0 0
+		return v_int32x4(_mm_sub_epi32(a1, mask));
+	}
+
+	inline v_int32x4 v_trunc(const v_float64x2& a)
+	{
+		return v_int32x4(_mm_cvttpd_epi32(a.val));
+	}
+
+	inline v_float32x4 v_cvt_f32(const v_int32x4& a)
+	{
+		return v_float32x4(_mm_cvtepi32_ps(a.val));
+	}
+
+	inline v_float32x4 v_cvt_f32(const v_float64x2& a)
+	{
+		return v_float32x4(_mm_cvtpd_ps(a.val));
+	}
+
+	inline v_float64x2 v_cvt_f64(const v_int32x4& a)
+	{
+		return v_float64x2(_mm_cvtepi32_pd(a.val));
+	}
+
+	inline v_float64x2 v_cvt_f64_high(const v_int32x4& a)
+	{
+		return v_float64x2(_mm_cvtepi32_pd(_mm_srli_si128(a.val, 8)));
+	}
+
+	inline v_float64x2 v_cvt_f64(const v_float32x4& a)
+	{
+		return v_float64x2(_mm_cvtps_pd(a.val));
+	}
+
+	inline v_float64x2 v_cvt_f64_high(const v_float32x4& a)
+	{
+		return v_float64x2(_mm_cvtps_pd(_mm_movehl_ps(a.val, a.val)));
+	}
+
+#define OPENCV_HAL_IMPL_SSE_TRANSPOSE4x4(_Tpvec, suffix, cast_from, cast_to) \
+inline void v_transpose4x4(const _Tpvec& a0, const _Tpvec& a1, \
+	const _Tpvec& a2, const _Tpvec& a3, \
+	_Tpvec& b0, _Tpvec& b1, \
+	_Tpvec& b2, _Tpvec& b3) \
+{ \
+	__m128i t0 = cast_from(_mm_unpacklo_##suffix(a0.val, a1.val)); \
+	__m128i t1 = cast_from(_mm_unpacklo_##suffix(a2.val, a3.val)); \
+	__m128i t2 = cast_from(_mm_unpackhi_##suffix(a0.val, a1.val)); \
+	__m128i t3 = cast_from(_mm_unpackhi_##suffix(a2.val, a3.val)); \
+	\
+	b0.val = cast_to(_mm_unpacklo_epi64(t0, t1)); \
+	b1.val = cast_to(_mm_unpackhi_epi64(t0, t1)); \
+	b2.val = cast_to(_mm_unpacklo_epi64(t2, t3)); \
+	b3.val = cast_to(_mm_unpackhi_epi64(t2, t3)); \
+}
+
+	OPENCV_HAL_IMPL_SSE_TRANSPOSE4x4(v_uint32x4, epi32, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_TRANSPOSE4x4(v_int32x4, epi32, OPENCV_HAL_NOP, OPENCV_HAL_NOP)
+	OPENCV_HAL_IMPL_SSE_TRANSPOSE4x4(v_float32x4, ps, _mm_castps_si128, _mm_castsi128_ps)
+
+	////////////////// Interleave / deinterleave //////////////////
+
+	// 8-bit
+
+	inline void v_load_deinterleave(const uchar* ptr, v_uint8x16& a, v_uint8x16& b)
+	{
+		__m128i t00 = _mm_loadu_si128((const __m128i*)ptr);
+		__m128i t01 = _mm_loadu_si128((const __m128i*)(ptr + 16));
+
+		__m128i t10 = _mm_unpacklo_epi8(t00, t01);
+		__m128i t11 = _mm_unpackhi_epi8(t00, t01);
+
+		__m128i t20 = _mm_unpacklo_epi8(t10, t11);
+		__m128i t21 = _mm_unpackhi_epi8(t10, t11);
+
+		__m128i t30 = _mm_unpacklo_epi8(t20, t21);
+		__m128i t31 = _mm_unpackhi_epi8(t20, t21);
+
+		a.val = _mm_unpacklo_epi8(t30, t31);
+		b.val = _mm_unpackhi_epi8(t30, t31);
+	}
+
+	inline void v_load_deinterleave(const uchar* ptr, v_uint8x16& a, v_uint8x16& b, v_uint8x16& c)
+	{
+		__m128i t00 = _mm_loadu_si128((const __m128i*)ptr);
+		__m128i t01 = _mm_loadu_si128((const __m128i*)(ptr + 16));
+		__m128i t02 = _mm_loadu_si128((const __m128i*)(ptr + 32));
+
+		__m128i t10 = _mm_unpacklo_epi8(t00, _mm_unpackhi_epi64(t01, t01));
+		__m128i t11 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t00, t00), t02);
+		__m128i t12 = _mm_unpacklo_epi8(t01, _mm_unpackhi_epi64(t02, t02));
+
+		__m128i t20 = _mm_unpacklo_epi8(t10, _mm_unpackhi_epi64(t11, t11));
+		__m128i t21 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t10, t10), t12);
+		__m128i t22 = _mm_unpacklo_epi8(t11, _mm_unpackhi_epi64(t12, t12));
+
+		__m128i t30 = _mm_unpacklo_epi8(t20, _mm_unpackhi_epi64(t21, t21));
+		__m128i t31 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t20, t20), t22);
+		__m128i t32 = _mm_unpacklo_epi8(t21, _mm_unpackhi_epi64(t22, t22));
+
+		a.val = _mm_unpacklo_epi8(t30, _mm_unpackhi_epi64(t31, t31));
+		b.val = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t30, t30), t32);
+		c.val = _mm_unpacklo_epi8(t31, _mm_unpackhi_epi64(t32, t32));
+	}
+
+	inline void v_load_deinterleave(const uchar* ptr, v_uint8x16& a, v_uint8x16& b, v_uint8x16& c, v_uint8x16& d)
+	{
+		__m128i u0 = _mm_loadu_si128((const __m128i*)ptr); // a0 b0 c0 d0 a1 b1 c1 d1 ...
+		__m128i u1 = _mm_loadu_si128((const __m128i*)(ptr + 16)); // a4 b4 c4 d4 ...
+		__m128i u2 = _mm_loadu_si128((const __m128i*)(ptr + 32)); // a8 b8 c8 d8 ...
+		__m128i u3 = _mm_loadu_si128((const __m128i*)(ptr + 48)); // a12 b12 c12 d12 ...
+
+		__m128i v0 = _mm_unpacklo_epi8(u0, u2); // a0 a8 b0 b8 ...
+		__m128i v1 = _mm_unpackhi_epi8(u0, u2); // a2 a10 b2 b10 ...
+		__m128i v2 = _mm_unpacklo_epi8(u1, u3); // a4 a12 b4 b12 ...
+		__m128i v3 = _mm_unpackhi_epi8(u1, u3); // a6 a14 b6 b14 ...
+
+		u0 = _mm_unpacklo_epi8(v0, v2); // a0 a4 a8 a12 ...
+		u1 = _mm_unpacklo_epi8(v1, v3); // a2 a6 a10 a14 ...
+		u2 = _mm_unpackhi_epi8(v0, v2); // a1 a5 a9 a13 ...
+		u3 = _mm_unpackhi_epi8(v1, v3); // a3 a7 a11 a15 ...
+
+		v0 = _mm_unpacklo_epi8(u0, u1); // a0 a2 a4 a6 ...
+		v1 = _mm_unpacklo_epi8(u2, u3); // a1 a3 a5 a7 ...
+		v2 = _mm_unpackhi_epi8(u0, u1); // c0 c2 c4 c6 ...
+		v3 = _mm_unpackhi_epi8(u2, u3); // c1 c3 c5 c7 ...
+
+		a.val = _mm_unpacklo_epi8(v0, v1);
+		b.val = _mm_unpackhi_epi8(v0, v1);
+		c.val = _mm_unpacklo_epi8(v2, v3);
+		d.val = _mm_unpackhi_epi8(v2, v3);
+	}
+
+	inline void v_store_interleave(uchar* ptr, const v_uint8x16& a, const v_uint8x16& b)
+	{
+		_mm_storeu_si128((__m128i*)ptr, _mm_unpacklo_epi8(a.val, b.val));
+		_mm_storeu_si128((__m128i*)(ptr + 16), _mm_unpackhi_epi8(a.val, b.val));
+	}
+
+	// a b c (16-bit each, 8 lanes) -> a0 b0 c0 a1 b1 c1 ... in three registers
+	inline void v_sse_interleave3_epi16(__m128i a, __m128i b, __m128i c,
+		__m128i& o0, __m128i& o1, __m128i& o2)
+	{
+		__m128i z = _mm_setzero_si128();
+		__m128i ab0 = _mm_unpacklo_epi16(a, b), ab1 = _mm_unpackhi_epi16(a, b);
+		__m128i c0 = _mm_unpacklo_epi16(c, z), c1 = _mm_unpackhi_epi16(c, z);
+
+		// q_i = a b c 0 a b c 0
+		__m128i q0 = _mm_unpacklo_epi32(ab0, c0);
+		__m128i q1 = _mm_unpackhi_epi32(ab0, c0);
+		__m128i q2 = _mm_unpacklo_epi32(ab1, c1);
+		__m128i q3 = _mm_unpackhi_epi32(ab1, c1);
+
+		// r_i = a b c a b c 0 0
+		__m128i m0 = _mm_setr_epi16(-1, -1, -1, 0, 0, 0, 0, 0);
+		__m128i m1 = _mm_setr_epi16(0, 0, 0, -1, -1, -1, 0, 0);
+		__m128i r0 = _mm_or_si128(_mm_and_si128(q0, m0), _mm_and_si128(_mm_srli_si128(q0, 2), m1));
+		__m128i r1 = _mm_or_si128(_mm_and_si128(q1, m0), _mm_and_si128(_mm_srli_si128(q1, 2), m1));
+		__m128i r2 = _mm_or_si128(_mm_and_si128(q2, m0), _mm_and_si128(_mm_srli_si128(q2, 2), m1));
+		__m128i r3 = _mm_or_si128(_mm_and_si128(q3, m0), _mm_and_si128(_mm_srli_si128(q3, 2), m1));
+
+		o0 = _mm_or_si128(r0, _mm_slli_si128(r1, 12));
+		o1 = _mm_or_si128(_mm_srli_si128(r1, 4), _mm_slli_si128(r2, 8));
+		o2 = _mm_or_si128(_mm_srli_si128(r2, 8), _mm_slli_si128(r3, 4));
+	}
+
+	inline void v_store_interleave(uchar* ptr, const v_uint8x16& a, const v_uint8x16& b,
+		const v_uint8x16& c)
+	{
+		__m128i z = _mm_setzero_si128();
+		__m128i p0, p1, p2, p3, p4, p5;
+		v_sse_interleave3_epi16(_mm_unpacklo_epi8(a.val, z), _mm_unpacklo_epi8(b.val, z),
+			_mm_unpacklo_epi8(c.val, z), p0, p1, p2);
+		v_sse_interleave3_epi16(_mm_unpackhi_epi8(a.val, z), _mm_unpackhi_epi8(b.val, z),
+			_mm_unpackhi_epi8(c.val, z), p3, p4, p5);
+
+		_mm_storeu_si128((__m128i*)ptr, _mm_packus_epi16(p0, p1));
+		_mm_storeu_si128((__m128i*)(ptr + 16), _mm_packus_epi16(p2, p3));
+		_mm_storeu_si128((__m128i*)(ptr + 32), _mm_packus_epi16(p4, p5));
+	}
+
+	inline void v_store_interleave(uchar* ptr, const v_uint8x16& a, const v_uint8x16& b,
+		const v_uint8x16& c, const v_uint8x16& d)
+	{
+		__m128i u0 = _mm_unpacklo_epi8(a.val, b.val); // a0 b0 a1 b1 ...
+		__m128i u1 = _mm_unpackhi_epi8(a.val, b.val); // a8 b8 a9 b9 ...
+		__m128i v0 = _mm_unpacklo_epi8(c.val, d.val); // c0 d0 c1 d1 ...
+		__m128i v1 = _mm_unpackhi_epi8(c.val, d.val); // c8 d8 c9 d9 ...
+
+		_mm_storeu_si128((__m128i*)ptr, _mm_unpacklo_epi16(u0, v0));
+		_mm_storeu_si128((__m128i*)(ptr + 16), _mm_unpackhi_epi16(u0, v0));
+		_mm_storeu_si128((__m128i*)(ptr + 32), _mm_unpacklo_epi16(u1, v1));
+		_mm_storeu_si128((__m128i*)(ptr + 48), _mm_unpackhi_epi16(u1, v1));
+	}
+
+	// 16-bit
+
+	inline void v_load_deinterleave(const ushort* ptr, v_uint16x8& a, v_uint16x8& b)
+	{
+		__m128i t00 = _mm_loadu_si128((const __m128i*)ptr); // a0 b0 a1 b1 a2 b2 a3 b3
+		__m128i t01 = _mm_loadu_si128((const __m128i*)(ptr + 8)); // a4 b4 a5 b5 a6 b6 a7 b7
+
+		__m128i t10 = _mm_unpacklo_epi16(t00, t01); // a0 a4 b0 b4 a1 a5 b1 b5
+		__m128i t11 = _mm_unpackhi_epi16(t00, t01); // a2 a6 b2 b6 a3 a7 b3 b7
+
+		__m128i t20 = _mm_unpacklo_epi16(t10, t11); // a0 a2 a4 a6 b0 b2 b4 b6
+		__m128i t21 = _mm_unpackhi_epi16(t10, t11); // a1 a3 a5 a7 b1 b3 b5 b7
+
+		a.val = _mm_unpacklo_epi16(t20, t21);
+		b.val = _mm_unpackhi_epi16(t20, t21);
+	}
+
+	inline void v_load_deinterleave(const ushort* ptr, v_uint16x8& a, v_uint16x8& b, v_uint16x8& c)
+	{
+		__m128i t00 = _mm_loadu_si128((const __m128i*)ptr);
+		__m128i t01 = _mm_loadu_si128((const __m128i*)(ptr + 8));
+		__m128i t02 = _mm_loadu_si128((const __m128i*)(ptr + 16));
+
+		__m128i t10 = _mm_unpacklo_epi16(t00, _mm_unpackhi_epi64(t01, t01));
+		__m128i t11 = _mm_unpacklo_epi16(_mm_unpackhi_epi64(t00, t00), t02);
+		__m128i t12 = _mm_unpacklo_epi16(t01, _mm_unpackhi_epi64(t02, t02));
+
+		__m128i t20 = _mm_unpacklo_epi16(t10, _mm_unpackhi_epi64(t11, t11));
+		__m128i t21 = _mm_unpacklo_epi16(_mm_unpackhi_epi64(t10, t10), t12);
+		__m128i t22 = _mm_unpacklo_epi16(t11, _mm_unpackhi_epi64(t12, t12));
+
+		a.val = _mm_unpacklo_epi16(t20, _mm_unpackhi_epi64(t21, t21));
+		b.val = _mm_unpacklo_epi16(_mm_unpackhi_epi64(t20, t20), t22);
+		c.val = _mm_unpacklo_epi16(t21, _mm_unpackhi_epi64(t22, t22));
+	}
+
+	inline void v_load_deinterleave(const ushort* ptr, v_uint16x8& a, v_uint16x8& b, v_uint16x8& c, v_uint16x8& d)
+	{
+		__m128i u0 = _mm_loadu_si128((const __m128i*)ptr); // a0 b0 c0 d0 a1 b1 c1 d1
+		__m128i u1 = _mm_loadu_si128((const __m128i*)(ptr + 8)); // a2 b2 c2 d2 ...
+		__m128i u2 = _mm_loadu_si128((const __m128i*)(ptr + 16)); // a4 b4 c4 d4 ...
+		__m128i u3 = _mm_loadu_si128((const __m128i*)(ptr + 24)); // a6 b6 c6 d6 ...
+
+		__m128i v0 = _mm_unpacklo_epi16(u0, u2); // a0 a4 b0 b4 c0 c4 d0 d4
+		__m128i v1 = _mm_unpackhi_epi16(u0, u2); // a1 a5 b1 b5 c1 c5 d1 d5
+		__m128i v2 = _mm_unpacklo_epi16(u1, u3); // a2 a6 b2 b6 c2 c6 d2 d6
+		__m128i v3 = _mm_unpackhi_epi16(u1, u3); // a3 a7 b3 b7 c3 c7 d3 d7
+
+		u0 = _mm_unpacklo_epi16(v0, v2); // a0 a2 a4 a6 b0 b2 b4 b6
+		u1 = _mm_unpackhi_epi16(v0, v2); // c0 c2 c4 c6 d0 d2 d4 d6
+		u2 = _mm_unpacklo_epi16(v1, v3); // a1 a3 a5 a7 b1 b3 b5 b7
+		u3 = _mm_unpackhi_epi16(v1, v3); // c1 c3 c5 c7 d1 d3 d5 d7
+
+		a.val = _mm_unpacklo_epi16(u0, u2);
+		b.val = _mm_unpackhi_epi16(u0, u2);
+		c.val = _mm_unpacklo_epi16(u1, u3);
+		d.val = _mm_unpackhi_epi16(u1, u3);
+	}
+
+	inline void v_store_interleave(ushort* ptr, const v_uint16x8& a, const v_uint16x8& b)
+	{
+		_mm_storeu_si128((__m128i*)ptr, _mm_unpacklo_epi16(a.val, b.val));
+		_mm_storeu_si128((__m128i*)(ptr + 8), _mm_unpackhi_epi16(a.val, b.val));
+	}
+
+	inline void v_store_interleave(ushort* ptr, const v_uint16x8& a, const v_uint16x8& b,
+		const v_uint16x8& c)
+	{
+		__m128i o0, o1, o2;
+		v_sse_interleave3_epi16(a.val, b.val, c.val, o0, o1, o2);
+		_mm_storeu_si128((__m128i*)ptr, o0);
+		_mm_storeu_si128((__m128i*)(ptr + 8), o1);
+		_mm_storeu_si128((__m128i*)(ptr + 16), o2);
+	}
+
+	inline void v_store_interleave(ushort* ptr, const v_uint16x8& a, const v_uint16x8& b,
+		const v_uint16x8& c, const v_uint16x8& d)
+	{
+		__m128i u0 = _mm_unpacklo_epi16(a.val, b.val); // a0 b0 a1 b1 a2 b2 a3 b3
+		__m128i u1 = _mm_unpackhi_epi16(a.val, b.val); // a4 b4 a5 b5 ...
+		__m128i v0 = _mm_unpacklo_epi16(c.val, d.val); // c0 d0 c1 d1 ...
+		__m128i v1 = _mm_unpackhi_epi16(c.val, d.val); // c4 d4 c5 d5 ...
+
+		_mm_storeu_si128((__m128i*)ptr, _mm_unpacklo_epi32(u0, v0));
+		_mm_storeu_si128((__m128i*)(ptr + 8), _mm_unpackhi_epi32(u0, v0));
+		_mm_storeu_si128((__m128i*)(ptr + 16), _mm_unpacklo_epi32(u1, v1));
+		_mm_storeu_si128((__m128i*)(ptr + 24), _mm_unpackhi_epi32(u1, v1));
+	}
+
+	// 32-bit
+
+	inline void v_load_deinterleave(const float* ptr, v_float32x4& a, v_float32x4& b)
+	{
+		__m128 t0 = _mm_loadu_ps(ptr); // a0 b0 a1 b1
+		__m128 t1 = _mm_loadu_ps(ptr + 4); // a2 b2 a3 b3
+
+		a.val = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(2, 0, 2, 0));
+		b.val = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	inline void v_load_deinterleave(const float* ptr, v_float32x4& a, v_float32x4& b, v_float32x4& c)
+	{
+		__m128 t0 = _mm_loadu_ps(ptr); // a0 b0 c0 a1
+		__m128 t1 = _mm_loadu_ps(ptr + 4); // b1 c1 a2 b2
+		__m128 t2 = _mm_loadu_ps(ptr + 8); // c2 a3 b3 c3
+
+		__m128 at12 = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(0, 1, 0, 2)); // a2 b1 a3 c2
+		a.val = _mm_shuffle_ps(t0, at12, _MM_SHUFFLE(2, 0, 3, 0));
+
+		__m128 bt01 = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(0, 0, 0, 1)); // b0 a0 b1 b1
+		__m128 bt12 = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(0, 2, 0, 3)); // b2 b1 b3 c2
+		b.val = _mm_shuffle_ps(bt01, bt12, _MM_SHUFFLE(2, 0, 2, 0));
+
+		__m128 ct01 = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(0, 1, 0, 2)); // c0 a0 c1 b1
+		c.val = _mm_shuffle_ps(ct01, t2, _MM_SHUFFLE(3, 0, 2, 0));
+	}
+
+	inline void v_load_deinterleave(const float* ptr, v_float32x4& a, v_float32x4& b, v_float32x4& c, v_float32x4& d)
+	{
+		v_float32x4 t0(_mm_loadu_ps(ptr)), t1(_mm_loadu_ps(ptr + 4));
+		v_float32x4 t2(_mm_loadu_ps(ptr + 8)), t3(_mm_loadu_ps(ptr + 12));
+		v_transpose4x4(t0, t1, t2, t3, a, b, c, d);
+	}
+
+	inline void v_store_interleave(float* ptr, const v_float32x4& a, const v_float32x4& b)
+	{
+		_mm_storeu_ps(ptr, _mm_unpacklo_ps(a.val, b.val));
+		_mm_storeu_ps(ptr + 4, _mm_unpackhi_ps(a.val, b.val));
+	}
+
+	inline void v_store_interleave(float* ptr, const v_float32x4& a, const v_float32x4& b, const v_float32x4& c)
+	{
+		__m128 u0 = _mm_shuffle_ps(a.val, b.val, _MM_SHUFFLE(0, 0, 0, 0)); // a0 a0 b0 b0
+		__m128 u1 = _mm_shuffle_ps(c.val, a.val, _MM_SHUFFLE(1, 1, 0, 0)); // c0 c0 a1 a1
+		__m128 u2 = _mm_shuffle_ps(b.val, c.val, _MM_SHUFFLE(1, 1, 1, 1)); // b1 b1 c1 c1
+		__m128 u3 = _mm_shuffle_ps(a.val, b.val, _MM_SHUFFLE(2, 2, 2, 2)); // a2 a2 b2 b2
+		__m128 u4 = _mm_shuffle_ps(c.val, a.val, _MM_SHUFFLE(3, 3, 2, 2)); // c2 c2 a3 a3
+		__m128 u5 = _mm_shuffle_ps(b.val, c.val, _MM_SHUFFLE(3, 3, 3, 3)); // b3 b3 c3 c3
+
+		_mm_storeu_ps(ptr, _mm_shuffle_ps(u0, u1, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(ptr + 4, _mm_shuffle_ps(u2, u3, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(ptr + 8, _mm_shuffle_ps(u4, u5, _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+
+	inline void v_store_interleave(float* ptr, const v_float32x4& a, const v_float32x4& b,
+		const v_float32x4& c, const v_float32x4& d)
+	{
+		v_float32x4 t0, t1, t2, t3;
+		v_transpose4x4(a, b, c, d, t0, t1, t2, t3);
+		_mm_storeu_ps(ptr, t0.val);
+		_mm_storeu_ps(ptr + 4, t1.val);
+		_mm_storeu_ps(ptr + 8, t2.val);
+		_mm_storeu_ps(ptr + 12, t3.val);
+	}
+
+	// 64-bit
+
+	inline void v_load_deinterleave(const double* ptr, v_float64x2& a, v_float64x2& b)
+	{
+		__m128d t0 = _mm_loadu_pd(ptr), t1 = _mm_loadu_pd(ptr + 2);
+		a.val = _mm_unpacklo_pd(t0, t1);
+		b.val = _mm_unpackhi_pd(t0, t1);
+	}
+
+	inline void v_load_deinterleave(const double* ptr, v_float64x2& a, v_float64x2& b, v_float64x2& c)
+	{
+		__m128d t0 = _mm_loadu_pd(ptr); // a0 b0
+		__m128d t1 = _mm_loadu_pd(ptr + 2); // c0 a1
+		__m128d t2 = _mm_loadu_pd(ptr + 4); // b1 c1
+
+		a.val = _mm_shuffle_pd(t0, t1, 2);
+		b.val = _mm_shuffle_pd(t0, t2, 1);
+		c.val = _mm_shuffle_pd(t1, t2, 2);
+	}
+
+	inline void v_load_deinterleave(const double* ptr, v_float64x2& a, v_float64x2& b,
+		v_float64x2& c, v_float64x2& d)
+	{
+		__m128d t0 = _mm_loadu_pd(ptr), t1 = _mm_loadu_pd(ptr + 2);
+		__m128d t2 = _mm_loadu_pd(ptr + 4), t3 = _mm_loadu_pd(ptr + 6);
+		a.val = _mm_unpacklo_pd(t0, t2);
+		b.val = _mm_unpackhi_pd(t0, t2);
+		c.val = _mm_unpacklo_pd(t1, t3);
+		d.val = _mm_unpackhi_pd(t1, t3);
+	}
+
+	inline void v_store_interleave(double* ptr, const v_float64x2& a, const v_float64x2& b)
+	{
+		_mm_storeu_pd(ptr, _mm_unpacklo_pd(a.val, b.val));
+		_mm_storeu_pd(ptr + 2, _mm_unpackhi_pd(a.val, b.val));
+	}
+
+	inline void v_store_interleave(double* ptr, const v_float64x2& a, const v_float64x2& b, const v_float64x2& c)
+	{
+		_mm_storeu_pd(ptr, _mm_unpacklo_pd(a.val, b.val));
+		_mm_storeu_pd(ptr + 2, _mm_shuffle_pd(c.val, a.val, 2));
+		_mm_storeu_pd(ptr + 4, _mm_unpackhi_pd(b.val, c.val));
+	}
+
+	inline void v_store_interleave(double* ptr, const v_float64x2& a, const v_float64x2& b,
+		const v_float64x2& c, const v_float64x2& d)
+	{
+		_mm_storeu_pd(ptr, _mm_unpacklo_pd(a.val, b.val));
+		_mm_storeu_pd(ptr + 2, _mm_unpacklo_pd(c.val, d.val));
+		_mm_storeu_pd(ptr + 4, _mm_unpackhi_pd(a.val, b.val));
+		_mm_storeu_pd(ptr + 6, _mm_unpackhi_pd(c.val, d.val));
+	}
+
+	// the remaining element types reuse the routines above through reinterpretation
+#define OPENCV_HAL_IMPL_SSE_LOADSTORE_INTERLEAVE(_Tpvec0, _Tp0, suffix0, _Tpvec1, _Tp1, suffix1) \
+inline void v_load_deinterleave(const _Tp0* ptr, _Tpvec0& a0, _Tpvec0& b0) \
+{ \
+	_Tpvec1 a1, b1; \
+	v_load_deinterleave((const _Tp1*)ptr, a1, b1); \
+	a0 = v_reinterpret_as_##suffix0(a1); \
+	b0 = v_reinterpret_as_##suffix0(b1); \
+} \
+inline void v_load_deinterleave(const _Tp0* ptr, _Tpvec0& a0, _Tpvec0& b0, _Tpvec0& c0) \
+{ \
+	_Tpvec1 a1, b1, c1; \
+	v_load_deinterleave((const _Tp1*)ptr, a1, b1, c1); \
+	a0 = v_reinterpret_as_##suffix0(a1); \
+	b0 = v_reinterpret_as_##suffix0(b1); \
+	c0 = v_reinterpret_as_##suffix0(c1); \
+} \
+inline void v_load_deinterleave(const _Tp0* ptr, _Tpvec0& a0, _Tpvec0& b0, _Tpvec0& c0, _Tpvec0& d0) \
+{ \
+	_Tpvec1 a1, b1, c1, d1; \
+	v_load_deinterleave((const _Tp1*)ptr, a1, b1, c1, d1); \
+	a0 = v_reinterpret_as_##suffix0(a1); \
+	b0 = v_reinterpret_as_##suffix0(b1); \
+	c0 = v_reinterpret_as_##suffix0(c1); \
+	d0 = v_reinterpret_as_##suffix0(d1); \
+} \
+inline void v_store_interleave(_Tp0* ptr, const _Tpvec0& a0, const _Tpvec0& b0) \
+{ \
+	_Tpvec1 a1 = v_reinterpret_as_##suffix1(a0); \
+	_Tpvec1 b1 = v_reinterpret_as_##suffix1(b0); \
+	v_store_interleave((_Tp1*)ptr, a1, b1); \
+} \
+inline void v_store_interleave(_Tp0* ptr, const _Tpvec0& a0, const _Tpvec0& b0, const _Tpvec0& c0) \
+{ \
+	_Tpvec1 a1 = v_reinterpret_as_##suffix1(a0); \
+	_Tpvec1 b1 = v_reinterpret_as_##suffix1(b0); \
+	_Tpvec1 c1 = v_reinterpret_as_##suffix1(c0); \
+	v_store_interleave((_Tp1*)ptr, a1, b1, c1); \
+} \
+inline void v_store_interleave(_Tp0* ptr, const _Tpvec0& a0, const _Tpvec0& b0, \
+	const _Tpvec0& c0, const _Tpvec0& d0) \
+{ \
+	_Tpvec1 a1 = v_reinterpret_as_##suffix1(a0); \
+	_Tpvec1 b1 = v_reinterpret_as_##suffix1(b0); \
+	_Tpvec1 c1 = v_reinterpret_as_##suffix1(c0); \
+	_Tpvec1 d1 = v_reinterpret_as_##suffix1(d0); \
+	v_store_interleave((_Tp1*)ptr, a1, b1, c1, d1); \
+}
+
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INTERLEAVE(v_int8x16, schar, s8, v_uint8x16, uchar, u8)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INTERLEAVE(v_int16x8, short, s16, v_uint16x8, ushort, u16)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INTERLEAVE(v_uint32x4, unsigned, u32, v_float32x4, float, f32)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INTERLEAVE(v_int32x4, int, s32, v_float32x4, float, f32)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INTERLEAVE(v_uint64x2, uint64, u64, v_float64x2, double, f64)
+	OPENCV_HAL_IMPL_SSE_LOADSTORE_INTERLEAVE(v_int64x2, int64, s64, v_float64x2, double, f64)
+
+	//! @name Check SIMD support
+	//! @{
+	//! @brief Check CPU capability of SIMD operation
+	static inline bool hasSIMD128()
+	{
+		// this backend is only selected when the compiler targets SSE2,
+		// so every CPU able to run the binary supports it
+		return true;
+	}
+
+	//! @}
+
+#ifndef CV_DOXYGEN
+	CV_CPU_OPTIMIZATION_HAL_NAMESPACE_END
+#endif
+
+	//! @endcond
+
+}
+
+#endif
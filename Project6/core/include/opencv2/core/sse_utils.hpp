@@ -0,0 +1,427 @@
+#ifndef OPENCV_CORE_SSE_UTILS_HPP
+#define OPENCV_CORE_SSE_UTILS_HPP
+
+#ifndef __cplusplus
+#  error sse_utils.hpp header must be compiled as C++
+#endif
+
+#include "cvdef.h"
+
+//! @addtogroup core_utils_sse
+//! @{
+
+#if CV_SSE2
+
+// Register-level channel (de)interleaving used by the raw SSE kernels
+// (split/merge, remap tables). Every function takes the channels either
+// packed one after another in memory order (interleaved) or as two
+// registers per channel (planar) and converts in place.
+
+// 8-bit
+
+inline void sse_deinterleave2_epi8(__m128i t00, __m128i t01, __m128i& a, __m128i& b)
+{
+	__m128i t10 = _mm_unpacklo_epi8(t00, t01);
+	__m128i t11 = _mm_unpackhi_epi8(t00, t01);
+
+	__m128i t20 = _mm_unpacklo_epi8(t10, t11);
+	__m128i t21 = _mm_unpackhi_epi8(t10, t11);
+
+	__m128i t30 = _mm_unpacklo_epi8(t20, t21);
+	__m128i t31 = _mm_unpackhi_epi8(t20, t21);
+
+	a = _mm_unpacklo_epi8(t30, t31);
+	b = _mm_unpackhi_epi8(t30, t31);
+}
+
+inline void sse_deinterleave3_epi8(__m128i t00, __m128i t01, __m128i t02,
+	__m128i& a, __m128i& b, __m128i& c)
+{
+	__m128i t10 = _mm_unpacklo_epi8(t00, _mm_unpackhi_epi64(t01, t01));
+	__m128i t11 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t00, t00), t02);
+	__m128i t12 = _mm_unpacklo_epi8(t01, _mm_unpackhi_epi64(t02, t02));
+
+	__m128i t20 = _mm_unpacklo_epi8(t10, _mm_unpackhi_epi64(t11, t11));
+	__m128i t21 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t10, t10), t12);
+	__m128i t22 = _mm_unpacklo_epi8(t11, _mm_unpackhi_epi64(t12, t12));
+
+	__m128i t30 = _mm_unpacklo_epi8(t20, _mm_unpackhi_epi64(t21, t21));
+	__m128i t31 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t20, t20), t22);
+	__m128i t32 = _mm_unpacklo_epi8(t21, _mm_unpackhi_epi64(t22, t22));
+
+	a = _mm_unpacklo_epi8(t30, _mm_unpackhi_epi64(t31, t31));
+	b = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t30, t30), t32);
+	c = _mm_unpacklo_epi8(t31, _mm_unpackhi_epi64(t32, t32));
+}
+
+inline void sse_deinterleave4_epi8(__m128i u0, __m128i u1, __m128i u2, __m128i u3,
+	__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+{
+	__m128i v0 = _mm_unpacklo_epi8(u0, u2);
+	__m128i v1 = _mm_unpackhi_epi8(u0, u2);
+	__m128i v2 = _mm_unpacklo_epi8(u1, u3);
+	__m128i v3 = _mm_unpackhi_epi8(u1, u3);
+
+	u0 = _mm_unpacklo_epi8(v0, v2);
+	u1 = _mm_unpacklo_epi8(v1, v3);
+	u2 = _mm_unpackhi_epi8(v0, v2);
+	u3 = _mm_unpackhi_epi8(v1, v3);
+
+	v0 = _mm_unpacklo_epi8(u0, u1);
+	v1 = _mm_unpacklo_epi8(u2, u3);
+	v2 = _mm_unpackhi_epi8(u0, u1);
+	v3 = _mm_unpackhi_epi8(u2, u3);
+
+	a = _mm_unpacklo_epi8(v0, v1);
+	b = _mm_unpackhi_epi8(v0, v1);
+	c = _mm_unpacklo_epi8(v2, v3);
+	d = _mm_unpackhi_epi8(v2, v3);
+}
+
+// a b c (8 x 16-bit each) -> a0 b0 c0 a1 b1 c1 ... in three registers
+inline void sse_interleave3_epi16(__m128i a, __m128i b, __m128i c,
+	__m128i& o0, __m128i& o1, __m128i& o2)
+{
+	__m128i z = _mm_setzero_si128();
+	__m128i ab0 = _mm_unpacklo_epi16(a, b), ab1 = _mm_unpackhi_epi16(a, b);
+	__m128i c0 = _mm_unpacklo_epi16(c, z), c1 = _mm_unpackhi_epi16(c, z);
+
+	__m128i q0 = _mm_unpacklo_epi32(ab0, c0);
+	__m128i q1 = _mm_unpackhi_epi32(ab0, c0);
+	__m128i q2 = _mm_unpacklo_epi32(ab1, c1);
+	__m128i q3 = _mm_unpackhi_epi32(ab1, c1);
+
+	__m128i m0 = _mm_setr_epi16(-1, -1, -1, 0, 0, 0, 0, 0);
+	__m128i m1 = _mm_setr_epi16(0, 0, 0, -1, -1, -1, 0, 0);
+	__m128i r0 = _mm_or_si128(_mm_and_si128(q0, m0), _mm_and_si128(_mm_srli_si128(q0, 2), m1));
+	__m128i r1 = _mm_or_si128(_mm_and_si128(q1, m0), _mm_and_si128(_mm_srli_si128(q1, 2), m1));
+	__m128i r2 = _mm_or_si128(_mm_and_si128(q2, m0), _mm_and_si128(_mm_srli_si128(q2, 2), m1));
+	__m128i r3 = _mm_or_si128(_mm_and_si128(q3, m0), _mm_and_si128(_mm_srli_si128(q3, 2), m1));
+
+	o0 = _mm_or_si128(r0, _mm_slli_si128(r1, 12));
+	o1 = _mm_or_si128(_mm_srli_si128(r1, 4), _mm_slli_si128(r2, 8));
+	o2 = _mm_or_si128(_mm_srli_si128(r2, 8), _mm_slli_si128(r3, 4));
+}
+
+inline void sse_interleave3_epi8(__m128i a, __m128i b, __m128i c,
+	__m128i& o0, __m128i& o1, __m128i& o2)
+{
+	__m128i z = _mm_setzero_si128();
+	__m128i p0, p1, p2, p3, p4, p5;
+	sse_interleave3_epi16(_mm_unpacklo_epi8(a, z), _mm_unpacklo_epi8(b, z),
+		_mm_unpacklo_epi8(c, z), p0, p1, p2);
+	sse_interleave3_epi16(_mm_unpackhi_epi8(a, z), _mm_unpackhi_epi8(b, z),
+		_mm_unpackhi_epi8(c, z), p3, p4, p5);
+
+	o0 = _mm_packus_epi16(p0, p1);
+	o1 = _mm_packus_epi16(p2, p3);
+	o2 = _mm_packus_epi16(p4, p5);
+}
+
+inline void sse_interleave4_epi8(__m128i a, __m128i b, __m128i c, __m128i d,
+	__m128i& o0, __m128i& o1, __m128i& o2, __m128i& o3)
+{
+	__m128i u0 = _mm_unpacklo_epi8(a, b), u1 = _mm_unpackhi_epi8(a, b);
+	__m128i v0 = _mm_unpacklo_epi8(c, d), v1 = _mm_unpackhi_epi8(c, d);
+
+	o0 = _mm_unpacklo_epi16(u0, v0);
+	o1 = _mm_unpackhi_epi16(u0, v0);
+	o2 = _mm_unpacklo_epi16(u1, v1);
+	o3 = _mm_unpackhi_epi16(u1, v1);
+}
+
+inline void _mm_deinterleave_epi8(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0, __m128i & v_g1)
+{
+	__m128i r0, g0, r1, g1;
+	sse_deinterleave2_epi8(v_r0, v_r1, r0, g0);
+	sse_deinterleave2_epi8(v_g0, v_g1, r1, g1);
+
+	v_r0 = r0; v_r1 = r1;
+	v_g0 = g0; v_g1 = g1;
+}
+
+inline void _mm_deinterleave_epi8(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0,
+	__m128i & v_g1, __m128i & v_b0, __m128i & v_b1)
+{
+	__m128i r0, g0, b0, r1, g1, b1;
+	sse_deinterleave3_epi8(v_r0, v_r1, v_g0, r0, g0, b0);
+	sse_deinterleave3_epi8(v_g1, v_b0, v_b1, r1, g1, b1);
+
+	v_r0 = r0; v_r1 = r1;
+	v_g0 = g0; v_g1 = g1;
+	v_b0 = b0; v_b1 = b1;
+}
+
+inline void _mm_deinterleave_epi8(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0, __m128i & v_g1,
+	__m128i & v_b0, __m128i & v_b1, __m128i & v_a0, __m128i & v_a1)
+{
+	__m128i r0, g0, b0, a0, r1, g1, b1, a1;
+	sse_deinterleave4_epi8(v_r0, v_r1, v_g0, v_g1, r0, g0, b0, a0);
+	sse_deinterleave4_epi8(v_b0, v_b1, v_a0, v_a1, r1, g1, b1, a1);
+
+	v_r0 = r0; v_r1 = r1;
+	v_g0 = g0; v_g1 = g1;
+	v_b0 = b0; v_b1 = b1;
+	v_a0 = a0; v_a1 = a1;
+}
+
+inline void _mm_interleave_epi8(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0, __m128i & v_g1)
+{
+	__m128i r0 = v_r0, r1 = v_r1, g0 = v_g0, g1 = v_g1;
+
+	v_r0 = _mm_unpacklo_epi8(r0, g0);
+	v_r1 = _mm_unpackhi_epi8(r0, g0);
+	v_g0 = _mm_unpacklo_epi8(r1, g1);
+	v_g1 = _mm_unpackhi_epi8(r1, g1);
+}
+
+inline void _mm_interleave_epi8(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0,
+	__m128i & v_g1, __m128i & v_b0, __m128i & v_b1)
+{
+	__m128i r0 = v_r0, r1 = v_r1, g0 = v_g0, g1 = v_g1, b0 = v_b0, b1 = v_b1;
+
+	sse_interleave3_epi8(r0, g0, b0, v_r0, v_r1, v_g0);
+	sse_interleave3_epi8(r1, g1, b1, v_g1, v_b0, v_b1);
+}
+
+inline void _mm_interleave_epi8(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0, __m128i & v_g1,
+	__m128i & v_b0, __m128i & v_b1, __m128i & v_a0, __m128i & v_a1)
+{
+	__m128i r0 = v_r0, r1 = v_r1, g0 = v_g0, g1 = v_g1;
+	__m128i b0 = v_b0, b1 = v_b1, a0 = v_a0, a1 = v_a1;
+
+	sse_interleave4_epi8(r0, g0, b0, a0, v_r0, v_r1, v_g0, v_g1);
+	sse_interleave4_epi8(r1, g1, b1, a1, v_b0, v_b1, v_a0, v_a1);
+}
+
+// 16-bit
+
+inline void sse_deinterleave2_epi16(__m128i t00, __m128i t01, __m128i& a, __m128i& b)
+{
+	__m128i t10 = _mm_unpacklo_epi16(t00, t01);
+	__m128i t11 = _mm_unpackhi_epi16(t00, t01);
+
+	__m128i t20 = _mm_unpacklo_epi16(t10, t11);
+	__m128i t21 = _mm_unpackhi_epi16(t10, t11);
+
+	a = _mm_unpacklo_epi16(t20, t21);
+	b = _mm_unpackhi_epi16(t20, t21);
+}
+
+inline void sse_deinterleave3_epi16(__m128i t00, __m128i t01, __m128i t02,
+	__m128i& a, __m128i& b, __m128i& c)
+{
+	__m128i t10 = _mm_unpacklo_epi16(t00, _mm_unpackhi_epi64(t01, t01));
+	__m128i t11 = _mm_unpacklo_epi16(_mm_unpackhi_epi64(t00, t00), t02);
+	__m128i t12 = _mm_unpacklo_epi16(t01, _mm_unpackhi_epi64(t02, t02));
+
+	__m128i t20 = _mm_unpacklo_epi16(t10, _mm_unpackhi_epi64(t11, t11));
+	__m128i t21 = _mm_unpacklo_epi16(_mm_unpackhi_epi64(t10, t10), t12);
+	__m128i t22 = _mm_unpacklo_epi16(t11, _mm_unpackhi_epi64(t12, t12));
+
+	a = _mm_unpacklo_epi16(t20, _mm_unpackhi_epi64(t21, t21));
+	b = _mm_unpacklo_epi16(_mm_unpackhi_epi64(t20, t20), t22);
+	c = _mm_unpacklo_epi16(t21, _mm_unpackhi_epi64(t22, t22));
+}
+
+inline void sse_deinterleave4_epi16(__m128i u0, __m128i u1, __m128i u2, __m128i u3,
+	__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+{
+	__m128i v0 = _mm_unpacklo_epi16(u0, u2);
+	__m128i v1 = _mm_unpackhi_epi16(u0, u2);
+	__m128i v2 = _mm_unpacklo_epi16(u1, u3);
+	__m128i v3 = _mm_unpackhi_epi16(u1, u3);
+
+	u0 = _mm_unpacklo_epi16(v0, v2);
+	u1 = _mm_unpackhi_epi16(v0, v2);
+	u2 = _mm_unpacklo_epi16(v1, v3);
+	u3 = _mm_unpackhi_epi16(v1, v3);
+
+	a = _mm_unpacklo_epi16(u0, u2);
+	b = _mm_unpackhi_epi16(u0, u2);
+	c = _mm_unpacklo_epi16(u1, u3);
+	d = _mm_unpackhi_epi16(u1, u3);
+}
+
+inline void sse_interleave4_epi16(__m128i a, __m128i b, __m128i c, __m128i d,
+	__m128i& o0, __m128i& o1, __m128i& o2, __m128i& o3)
+{
+	__m128i u0 = _mm_unpacklo_epi16(a, b), u1 = _mm_unpackhi_epi16(a, b);
+	__m128i v0 = _mm_unpacklo_epi16(c, d), v1 = _mm_unpackhi_epi16(c, d);
+
+	o0 = _mm_unpacklo_epi32(u0, v0);
+	o1 = _mm_unpackhi_epi32(u0, v0);
+	o2 = _mm_unpacklo_epi32(u1, v1);
+	o3 = _mm_unpackhi_epi32(u1, v1);
+}
+
+inline void _mm_deinterleave_epi16(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0, __m128i & v_g1)
+{
+	__m128i r0, g0, r1, g1;
+	sse_deinterleave2_epi16(v_r0, v_r1, r0, g0);
+	sse_deinterleave2_epi16(v_g0, v_g1, r1, g1);
+
+	v_r0 = r0; v_r1 = r1;
+	v_g0 = g0; v_g1 = g1;
+}
+
+inline void _mm_deinterleave_epi16(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0,
+	__m128i & v_g1, __m128i & v_b0, __m128i & v_b1)
+{
+	__m128i r0, g0, b0, r1, g1, b1;
+	sse_deinterleave3_epi16(v_r0, v_r1, v_g0, r0, g0, b0);
+	sse_deinterleave3_epi16(v_g1, v_b0, v_b1, r1, g1, b1);
+
+	v_r0 = r0; v_r1 = r1;
+	v_g0 = g0; v_g1 = g1;
+	v_b0 = b0; v_b1 = b1;
+}
+
+inline void _mm_deinterleave_epi16(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0, __m128i & v_g1,
+	__m128i & v_b0, __m128i & v_b1, __m128i & v_a0, __m128i & v_a1)
+{
+	__m128i r0, g0, b0, a0, r1, g1, b1, a1;
+	sse_deinterleave4_epi16(v_r0, v_r1, v_g0, v_g1, r0, g0, b0, a0);
+	sse_deinterleave4_epi16(v_b0, v_b1, v_a0, v_a1, r1, g1, b1, a1);
+
+	v_r0 = r0; v_r1 = r1;
+	v_g0 = g0; v_g1 = g1;
+	v_b0 = b0; v_b1 = b1;
+	v_a0 = a0; v_a1 = a1;
+}
+
+inline void _mm_interleave_epi16(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0, __m128i & v_g1)
+{
+	__m128i r0 = v_r0, r1 = v_r1, g0 = v_g0, g1 = v_g1;
+
+	v_r0 = _mm_unpacklo_epi16(r0, g0);
+	v_r1 = _mm_unpackhi_epi16(r0, g0);
+	v_g0 = _mm_unpacklo_epi16(r1, g1);
+	v_g1 = _mm_unpackhi_epi16(r1, g1);
+}
+
+inline void _mm_interleave_epi16(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0,
+	__m128i & v_g1, __m128i & v_b0, __m128i & v_b1)
+{
+	__m128i r0 = v_r0, r1 = v_r1, g0 = v_g0, g1 = v_g1, b0 = v_b0, b1 = v_b1;
+
+	sse_interleave3_epi16(r0, g0, b0, v_r0, v_r1, v_g0);
+	sse_interleave3_epi16(r1, g1, b1, v_g1, v_b0, v_b1);
+}
+
+inline void _mm_interleave_epi16(__m128i & v_r0, __m128i & v_r1, __m128i & v_g0, __m128i & v_g1,
+	__m128i & v_b0, __m128i & v_b1, __m128i & v_a0, __m128i & v_a1)
+{
+	__m128i r0 = v_r0, r1 = v_r1, g0 = v_g0, g1 = v_g1;
+	__m128i b0 = v_b0, b1 = v_b1, a0 = v_a0, a1 = v_a1;
+
+	sse_interleave4_epi16(r0, g0, b0, a0, v_r0, v_r1, v_g0, v_g1);
+	sse_interleave4_epi16(r1, g1, b1, a1, v_b0, v_b1, v_a0, v_a1);
+}
+
+// 32-bit floating point
+
+inline void sse_deinterleave3_ps(__m128 t0, __m128 t1, __m128 t2,
+	__m128& a, __m128& b, __m128& c)
+{
+	__m128 at12 = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(0, 1, 0, 2));
+	a = _mm_shuffle_ps(t0, at12, _MM_SHUFFLE(2, 0, 3, 0));
+
+	__m128 bt01 = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(0, 0, 0, 1));
+	__m128 bt12 = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(0, 2, 0, 3));
+	b = _mm_shuffle_ps(bt01, bt12, _MM_SHUFFLE(2, 0, 2, 0));
+
+	__m128 ct01 = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(0, 1, 0, 2));
+	c = _mm_shuffle_ps(ct01, t2, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+inline void sse_interleave3_ps(__m128 a, __m128 b, __m128 c,
+	__m128& o0, __m128& o1, __m128& o2)
+{
+	__m128 u0 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 0));
+	__m128 u1 = _mm_shuffle_ps(c, a, _MM_SHUFFLE(1, 1, 0, 0));
+	__m128 u2 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 1, 1));
+	__m128 u3 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 2, 2, 2));
+	__m128 u4 = _mm_shuffle_ps(c, a, _MM_SHUFFLE(3, 3, 2, 2));
+	__m128 u5 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(3, 3, 3, 3));
+
+	o0 = _mm_shuffle_ps(u0, u1, _MM_SHUFFLE(2, 0, 2, 0));
+	o1 = _mm_shuffle_ps(u2, u3, _MM_SHUFFLE(2, 0, 2, 0));
+	o2 = _mm_shuffle_ps(u4, u5, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+inline void _mm_deinterleave_ps(__m128 & v_r0, __m128 & v_r1, __m128 & v_g0, __m128 & v_g1)
+{
+	__m128 r0 = _mm_shuffle_ps(v_r0, v_r1, _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 g0 = _mm_shuffle_ps(v_r0, v_r1, _MM_SHUFFLE(3, 1, 3, 1));
+	__m128 r1 = _mm_shuffle_ps(v_g0, v_g1, _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 g1 = _mm_shuffle_ps(v_g0, v_g1, _MM_SHUFFLE(3, 1, 3, 1));
+
+	v_r0 = r0; v_r1 = r1;
+	v_g0 = g0; v_g1 = g1;
+}
+
+inline void _mm_deinterleave_ps(__m128 & v_r0, __m128 & v_r1, __m128 & v_g0,
+	__m128 & v_g1, __m128 & v_b0, __m128 & v_b1)
+{
+	__m128 r0, g0, b0, r1, g1, b1;
+	sse_deinterleave3_ps(v_r0, v_r1, v_g0, r0, g0, b0);
+	sse_deinterleave3_ps(v_g1, v_b0, v_b1, r1, g1, b1);
+
+	v_r0 = r0; v_r1 = r1;
+	v_g0 = g0; v_g1 = g1;
+	v_b0 = b0; v_b1 = b1;
+}
+
+inline void _mm_deinterleave_ps(__m128 & v_r0, __m128 & v_r1, __m128 & v_g0, __m128 & v_g1,
+	__m128 & v_b0, __m128 & v_b1, __m128 & v_a0, __m128 & v_a1)
+{
+	__m128 r0 = v_r0, g0 = v_r1, b0 = v_g0, a0 = v_g1;
+	__m128 r1 = v_b0, g1 = v_b1, b1 = v_a0, a1 = v_a1;
+	_MM_TRANSPOSE4_PS(r0, g0, b0, a0);
+	_MM_TRANSPOSE4_PS(r1, g1, b1, a1);
+
+	v_r0 = r0; v_r1 = r1;
+	v_g0 = g0; v_g1 = g1;
+	v_b0 = b0; v_b1 = b1;
+	v_a0 = a0; v_a1 = a1;
+}
+
+inline void _mm_interleave_ps(__m128 & v_r0, __m128 & v_r1, __m128 & v_g0, __m128 & v_g1)
+{
+	__m128 r0 = v_r0, r1 = v_r1, g0 = v_g0, g1 = v_g1;
+
+	v_r0 = _mm_unpacklo_ps(r0, g0);
+	v_r1 = _mm_unpackhi_ps(r0, g0);
+	v_g0 = _mm_unpacklo_ps(r1, g1);
+	v_g1 = _mm_unpackhi_ps(r1, g1);
+}
+
+inline void _mm_interleave_ps(__m128 & v_r0, __m128 & v_r1, __m128 & v_g0,
+	__m128 & v_g1, __m128 & v_b0, __m128 & v_b1)
+{
+	__m128 r0 = v_r0, r1 = v_r1, g0 = v_g0, g1 = v_g1, b0 = v_b0, b1 = v_b1;
+
+	sse_interleave3_ps(r0, g0, b0, v_r0, v_r1, v_g0);
+	sse_interleave3_ps(r1, g1, b1, v_g1, v_b0, v_b1);
+}
+
+inline void _mm_interleave_ps(__m128 & v_r0, __m128 & v_r1, __m128 & v_g0, __m128 & v_g1,
+	__m128 & v_b0, __m128 & v_b1, __m128 & v_a0, __m128 & v_a1)
+{
+	__m128 r0 = v_r0, g0 = v_g0, b0 = v_b0, a0 = v_a0;
+	__m128 r1 = v_r1, g1 = v_g1, b1 = v_b1, a1 = v_a1;
+	_MM_TRANSPOSE4_PS(r0, g0, b0, a0);
+	_MM_TRANSPOSE4_PS(r1, g1, b1, a1);
+
+	v_r0 = r0; v_r1 = g0;
+	v_g0 = b0; v_g1 = a0;
+	v_b0 = r1; v_b1 = g1;
+	v_a0 = b1; v_a1 = a1;
+}
+
+#endif // CV_SSE2
+
+//! @}
+
+#endif //OPENCV_CORE_SSE_UTILS_HPP
@@ -181,7 +181,5 @@ namespace cv {
 #endif
 float cv::fastAtan2(float y, float x)
 {
-	using namespace cv::hal;
-//	CV_CPU_CALL_BASELINE(fastAtan2, (y, x));
-	return 0;
+	return cv::hal::fastAtan2(y, x);
 }
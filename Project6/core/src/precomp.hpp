@@ -39,7 +39,7 @@
 
 #include "../include/opencv2/core/hal/hal.hpp"
 #include "../include/opencv2/core/hal/intrin.hpp"
-//#include "opencv2/core/sse_utils.hpp"
+#include "../include/opencv2/core/sse_utils.hpp"
 //#include "opencv2/core/neon_utils.hpp"
 //#include "opencv2/core/vsx_utils.hpp"
 #include "arithm_core.hpp"
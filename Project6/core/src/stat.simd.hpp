@@ -1,5 +1,4 @@
 #include "../include/opencv2/core/hal/intrin.hpp"
-#define CV_CPU_OPTIMIZATION_DECLARATIONS_ONLY
 namespace cv {
 	namespace hal {
 
@@ -0,0 +1,104 @@
+#include "../features2d/include/opencv2/features2d.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+using namespace cv;
+using namespace std;
+
+static void help()
+{
+	cout << "\nThis is a benchmark of HammingHashMatcher against brute force matching,\n"
+		"on random 256-bit descriptors.\n";
+	cout << "\nUsage: hamming_match_demon [train count = 200000] [query count = 1000] [max probe radius = 2]\n"
+		"The queries are train descriptors with 0-40 flipped bits, every 10th query is random.\n"
+		"The matchers run on one thread; recall@1 is the share of queries whose nearest\n"
+		"distance is the brute force one.\n"
+		"The demo is excluded from the project build, swap it with lk_demon.cpp to run it.\n" << endl;
+}
+
+static double elapsedMs(int64 t0)
+{
+	return (getTickCount() - t0)*1000. / getTickFrequency();
+}
+
+int main(int argc, char** argv)
+{
+	int trainCount = argc > 1 ? atoi(argv[1]) : 200000;
+	int queryCount = argc > 2 ? atoi(argv[2]) : 1000;
+	int maxRadius = argc > 3 ? atoi(argv[3]) : 2;
+	const int DESC_BYTES = 32;
+	// the number of 16-bit substrings the descriptors are split into
+	const int SUBSTRINGS = DESC_BYTES * 8 / 16;
+
+	help();
+
+	if (trainCount <= 0 || queryCount <= 0 || maxRadius < 0)
+	{
+		cout << "Wrong arguments\n";
+		return 0;
+	}
+
+	setNumThreads(1);
+
+	RNG rng(3);
+	Mat train(trainCount, DESC_BYTES, CV_8U), query(queryCount, DESC_BYTES, CV_8U);
+	rng.fill(train, RNG::UNIFORM, 0, 256);
+	for (int i = 0; i < queryCount; i++)
+	{
+		if (i % 10 == 9)
+		{
+			rng.fill(query.row(i), RNG::UNIFORM, 0, 256);
+			continue;
+		}
+		train.row(rng.uniform(0, trainCount)).copyTo(query.row(i));
+		int flips = rng.uniform(0, 41);
+		for (int f = 0; f < flips; f++)
+		{
+			int b = rng.uniform(0, DESC_BYTES * 8);
+			query.at<uchar>(i, b / 8) ^= (uchar)(1 << (b % 8));
+		}
+	}
+
+	vector<vector<DMatch> > bfMatches, matches;
+	BFMatcher bf(NORM_HAMMING);
+	bf.add(train);
+	int64 t0 = getTickCount();
+	bf.knnMatch(query, bfMatches, 2);
+	cout << fixed << setprecision(1);
+	cout << "BFMatcher knn2: " << elapsedMs(t0) << " ms\n";
+
+	for (int r = 0; r <= maxRadius; r++)
+	{
+		Ptr<HammingHashMatcher> matcher = HammingHashMatcher::create(r);
+		matcher->add(train);
+
+		t0 = getTickCount();
+		matcher->train();
+		double buildMs = elapsedMs(t0);
+
+		t0 = getTickCount();
+		matcher->knnMatch(query, matches, 2);
+		double queryMs = elapsedMs(t0);
+
+		// below SUBSTRINGS*(r+1) the nearest neighbour is guaranteed to be found
+		int exactBound = SUBSTRINGS * (r + 1);
+		int found = 0, inBound = 0, foundInBound = 0;
+		for (int i = 0; i < queryCount; i++)
+		{
+			bool near = bfMatches[i][0].distance < exactBound;
+			bool same = !matches[i].empty() && matches[i][0].distance == bfMatches[i][0].distance;
+			inBound += near;
+			found += same;
+			foundInBound += near && same;
+		}
+
+		cout << "HammingHashMatcher radius " << r << ": build " << buildMs << " ms, knn2 " << queryMs
+			<< " ms, recall@1 " << setprecision(3) << (double)found / queryCount << setprecision(1)
+			<< " (" << foundInBound << " of " << inBound << " queries with a nearest distance below "
+			<< exactBound << ")\n";
+	}
+
+	return 0;
+}
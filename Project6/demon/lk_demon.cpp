@@ -40,6 +40,7 @@ int main(int argc, char** argv)
 	VideoCapture cap;
 	TermCriteria termcrit(TermCriteria::COUNT | TermCriteria::EPS, 20, 0.03);
 	Size subPixWinSize(10, 10), winSize(31, 31);
+	Ptr<SparsePyrLKOpticalFlow> lk = SparsePyrLKOpticalFlow::create(winSize, 3, termcrit, 0, 0.001);
 
 	const int MAX_COUNT = 500;
 	bool needToInit = false;
@@ -56,7 +57,7 @@ int main(int argc, char** argv)
 	namedWindow("LK Demo", 1);
 	setMouseCallback("LK Demo", onMouse, 0);
 
-	Mat gray, prevGray, image, frame;
+	Mat gray, image, frame;
 	vector<Point2f> points[2];
 
 	for (;;)
@@ -67,6 +68,7 @@ int main(int argc, char** argv)
 
 		frame.copyTo(image);
 		cvtColor(image, gray, COLOR_BGR2GRAY);
+		lk->pushFrame(gray);
 
 		if (nightMode)
 			image = Scalar::all(0);
@@ -82,10 +84,7 @@ int main(int argc, char** argv)
 		{
 			vector<uchar> status;
 			vector<float> err;
-			if (prevGray.empty())
-				gray.copyTo(prevGray);
-			calcOpticalFlowPyrLK(prevGray, gray, points[0], points[1], status, err, winSize,
-				3, termcrit, 0, 0.001);
+			lk->track(points[0], points[1], status, err);
 			size_t i, k;
 			for (i = k = 0; i < points[1].size(); i++)
 			{
@@ -137,7 +136,6 @@ int main(int argc, char** argv)
 		}
 
 		std::swap(points[1], points[0]);
-		cv::swap(prevGray, gray);
 	}
 
 	return 0;
@@ -312,6 +312,16 @@ namespace cv
 
 		CV_WRAP virtual void setFastThreshold(int fastThreshold) = 0;
 		CV_WRAP virtual int getFastThreshold() const = 0;
+
+		/** @brief Sets the number of orientation bins of the descriptor pattern.
+
+		With 0, the default, the pattern is rotated by the exact angle of every keypoint. Otherwise the
+		angles are quantized to angleBins bins (30, i.e. 12 degrees, in @cite RRKB11) and the rotated
+		pattern offsets are taken from tables computed once per call, which makes the descriptor
+		extraction faster at the cost of slightly different descriptors.
+		*/
+		CV_WRAP virtual void setAngleBins(int angleBins) = 0;
+		CV_WRAP virtual int getAngleBins() const = 0;
 		CV_WRAP virtual String getDefaultName() const;
 	};
 
@@ -431,6 +441,33 @@ namespace cv
 		CV_WRAP virtual String getDefaultName() const;
 	};
 
+	/** @brief Detects corners using the FAST algorithm in the cells of a grid
+
+	FAST returns the globally strongest corners, which cluster in the textured parts of the image. This
+	function divides the image into gridSize.width x gridSize.height cells and detects the corners of
+	every cell independently (the cells are processed in parallel), so the keypoints are spread
+	uniformly over the image. When a cell has fewer than maxPerCell corners with the threshold, it is
+	processed again with minThreshold, and at most maxPerCell corners with the best response are kept
+	in every cell. The corners of a cell are the same as FAST finds on the whole image with the same
+	threshold.
+
+	@param image grayscale image where keypoints (corners) are detected.
+	@param keypoints keypoints detected on the image, grouped by the cells in the row-major order.
+	@param gridSize number of the cells along the x and y axes.
+	@param maxPerCell maximum number of keypoints kept in a cell; `maxPerCell <= 0` keeps all of them
+	and disables the second pass with minThreshold.
+	@param threshold threshold on difference between intensity of the central pixel and pixels of a
+	circle around this pixel.
+	@param minThreshold threshold for the cells that have fewer than maxPerCell keypoints with the
+	threshold.
+	@param nonmaxSuppression if true, non-maximum suppression is applied to detected corners
+	(keypoints).
+	@param type one of the three neighborhoods, see FAST.
+	*/
+	CV_EXPORTS void FASTGrid(InputArray image, CV_OUT std::vector<KeyPoint>& keypoints, Size gridSize,
+		int maxPerCell, int threshold, int minThreshold, bool nonmaxSuppression = true,
+		int type = FastFeatureDetector::TYPE_9_16);
+
 	/** @overload */
 	CV_EXPORTS void AGAST(InputArray image, CV_OUT std::vector<KeyPoint>& keypoints,
 		int threshold, bool nonmaxSuppression = true);
@@ -1119,6 +1156,54 @@ namespace cv
 
 #endif
 
+	/** @brief Multi-index hashing matcher for binary descriptors.
+
+	The train descriptors are split into 16-bit substrings and every substring indexes its own hash
+	table. A query probes, in all the tables, the buckets within a growing Hamming radius r of its
+	substrings and computes the full Hamming distance only for the descriptors found there. Since a
+	descriptor at distance d from the query has at least one substring at distance at most d/m, where m
+	is the number of substrings, the search stops as soon as the k-th best distance is below m*(r+1):
+	the result is then the same as the brute force one. The radius is limited by maxProbeRadius,
+	beyond which the matches are approximate; with 256-bit descriptors the default radius 2 keeps the
+	result exact for distances below 48.
+
+	Only NORM_HAMMING on CV_8U descriptors is supported, and masks are ignored. The tables are rebuilt
+	by train(), which is called by the match methods when descriptors have been added.
+	*/
+	class CV_EXPORTS_W HammingHashMatcher : public DescriptorMatcher
+	{
+	public:
+		CV_WRAP HammingHashMatcher(int maxProbeRadius = 2);
+
+		virtual void add(InputArrayOfArrays descriptors);
+		virtual void clear();
+
+		virtual void train();
+		virtual bool isMaskSupported() const { return false; }
+
+		CV_WRAP static Ptr<HammingHashMatcher> create(int maxProbeRadius = 2);
+
+		virtual Ptr<DescriptorMatcher> clone(bool emptyTrainData = false) const;
+	protected:
+		virtual void knnMatchImpl(InputArray queryDescriptors, std::vector<std::vector<DMatch> >& matches, int k,
+			InputArrayOfArrays masks = noArray(), bool compactResult = false);
+		virtual void radiusMatchImpl(InputArray queryDescriptors, std::vector<std::vector<DMatch> >& matches, float maxDistance,
+			InputArrayOfArrays masks = noArray(), bool compactResult = false);
+
+		int maxProbeRadius;
+
+		DescriptorCollection mergedDescriptors;
+		int addedDescCount;
+
+		//! for every substring, the first index in bucketIds of each bucket, followed by the total count
+		std::vector<std::vector<int> > bucketStarts;
+		//! for every substring, the merged descriptor indices grouped by bucket
+		std::vector<std::vector<int> > bucketIds;
+		//! the 16-bit flip masks sorted by popcount, and the first mask of each popcount
+		std::vector<ushort> flipMasks;
+		std::vector<int> flipOffsets;
+	};
+
 	//! @} features2d_match
 
 	/****************************************************************************************\
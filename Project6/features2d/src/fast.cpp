@@ -429,6 +429,113 @@ namespace cv
 		return CV_HAL_ERROR_OK;
 	}
 
+	static void FAST_type(const Mat& img, std::vector<KeyPoint>& keypoints, int threshold,
+		bool nonmax_suppression, int type)
+	{
+		switch (type) {
+		case FastFeatureDetector::TYPE_5_8:
+			FAST_t<8>(img, keypoints, threshold, nonmax_suppression);
+			break;
+		case FastFeatureDetector::TYPE_7_12:
+			FAST_t<12>(img, keypoints, threshold, nonmax_suppression);
+			break;
+		case FastFeatureDetector::TYPE_9_16:
+			FAST_t<16>(img, keypoints, threshold, nonmax_suppression);
+			break;
+		}
+	}
+
+	// finds the keypoints of rect the same way as FAST on the whole image does: the image ROI is
+	// extended by the radius of the circle and one more pixel for the non-maximum suppression, and
+	// the keypoints found outside of rect are dropped
+	static void FAST_rect(const Mat& img, const Rect& rect, std::vector<KeyPoint>& keypoints,
+		int threshold, bool nonmax_suppression, int type)
+	{
+		const int margin = 4;
+		Rect roi(rect.x - margin, rect.y - margin, rect.width + margin * 2, rect.height + margin * 2);
+		roi &= Rect(0, 0, img.cols, img.rows);
+
+		FAST_type(img(roi), keypoints, threshold, nonmax_suppression, type);
+
+		size_t i, j = 0;
+		for (i = 0; i < keypoints.size(); i++)
+		{
+			KeyPoint kpt = keypoints[i];
+			kpt.pt.x += roi.x;
+			kpt.pt.y += roi.y;
+			if (rect.contains(Point(cvRound(kpt.pt.x), cvRound(kpt.pt.y))))
+				keypoints[j++] = kpt;
+		}
+		keypoints.resize(j);
+	}
+
+	static const int FAST_STRIPE_ROWS = 128;
+
+	class FASTGridInvoker : public ParallelLoopBody
+	{
+	public:
+		FASTGridInvoker(const Mat& _img, Size _gridSize, int _maxPerCell, int _threshold, int _minThreshold,
+			bool _nonmax_suppression, int _type, std::vector<std::vector<KeyPoint> >& _cells) :
+			img(_img), gridSize(_gridSize), maxPerCell(_maxPerCell), threshold(_threshold),
+			minThreshold(_minThreshold), nonmax_suppression(_nonmax_suppression), type(_type), cells(_cells)
+		{
+		}
+
+		void operator()(const Range& range) const
+		{
+			for (int i = range.start; i < range.end; i++)
+			{
+				int cx = i % gridSize.width, cy = i / gridSize.width;
+				int x0 = cx * img.cols / gridSize.width, x1 = (cx + 1) * img.cols / gridSize.width;
+				int y0 = cy * img.rows / gridSize.height, y1 = (cy + 1) * img.rows / gridSize.height;
+				Rect rect(x0, y0, x1 - x0, y1 - y0);
+				std::vector<KeyPoint>& keypoints = cells[i];
+
+				FAST_rect(img, rect, keypoints, threshold, nonmax_suppression, type);
+
+				// the cell is low-contrast, try again with the lower threshold
+				if (maxPerCell > 0 && (int)keypoints.size() < maxPerCell && minThreshold < threshold)
+					FAST_rect(img, rect, keypoints, minThreshold, nonmax_suppression, type);
+
+				if (maxPerCell > 0 && (int)keypoints.size() > maxPerCell)
+				{
+					KeyPointsFilter::retainBest(keypoints, maxPerCell);
+					keypoints.resize(maxPerCell);
+				}
+			}
+		}
+
+	private:
+		const Mat& img;
+		Size gridSize;
+		int maxPerCell;
+		int threshold;
+		int minThreshold;
+		bool nonmax_suppression;
+		int type;
+		std::vector<std::vector<KeyPoint> >& cells;
+	};
+
+	void FASTGrid(InputArray _img, std::vector<KeyPoint>& keypoints, Size gridSize, int maxPerCell,
+		int threshold, int minThreshold, bool nonmax_suppression, int type)
+	{
+		CV_INSTRUMENT_REGION()
+
+		Mat img = _img.getMat();
+		CV_Assert(img.type() == CV_8UC1);
+		CV_Assert(gridSize.width > 0 && gridSize.height > 0 &&
+			gridSize.width <= img.cols && gridSize.height <= img.rows);
+
+		int ncells = gridSize.area();
+		std::vector<std::vector<KeyPoint> > cells(ncells);
+		parallel_for_(Range(0, ncells), FASTGridInvoker(img, gridSize, maxPerCell, threshold, minThreshold,
+			nonmax_suppression, type, cells), ncells);
+
+		keypoints.clear();
+		for (int i = 0; i < ncells; i++)
+			keypoints.insert(keypoints.end(), cells[i].begin(), cells[i].end());
+	}
+
 	void FAST(InputArray _img, std::vector<KeyPoint>& keypoints, int threshold, bool nonmax_suppression, int type)
 	{
 		CV_INSTRUMENT_REGION()
@@ -446,21 +553,33 @@ namespace cv
 //		CV_OVX_RUN(true,
 //		openvx_FAST(_img, keypoints, threshold, nonmax_suppression, type))
 
-		switch (type) {
-		case FastFeatureDetector::TYPE_5_8:
-			FAST_t<8>(_img, keypoints, threshold, nonmax_suppression);
-			break;
-		case FastFeatureDetector::TYPE_7_12:
-			FAST_t<12>(_img, keypoints, threshold, nonmax_suppression);
-			break;
-		case FastFeatureDetector::TYPE_9_16:
 #ifdef HAVE_TEGRA_OPTIMIZATION
-			if (tegra::useTegra() && tegra::FAST(_img, keypoints, threshold, nonmax_suppression))
-				break;
+		if (type == FastFeatureDetector::TYPE_9_16 && tegra::useTegra() &&
+			tegra::FAST(_img, keypoints, threshold, nonmax_suppression))
+			return;
 #endif
-			FAST_t<16>(_img, keypoints, threshold, nonmax_suppression);
-			break;
+
+		// with several threads, the image is processed in horizontal stripes, each overlapping the
+		// neighbours by the 4 rows FAST_rect needs; the keypoints of a stripe are those FAST finds
+		// there in the whole image, so merging the stripes in order gives the same result
+		int nstripes = getNumThreads() > 1 ? std::max(img.rows / FAST_STRIPE_ROWS, 1) : 1;
+		if (nstripes == 1)
+		{
+			FAST_type(img, keypoints, threshold, nonmax_suppression, type);
+			return;
 		}
+
+		std::vector<std::vector<KeyPoint> > stripes(nstripes);
+		parallel_for_(Range(0, nstripes), FASTGridInvoker(img, Size(1, nstripes), 0, threshold, threshold,
+			nonmax_suppression, type, stripes), nstripes);
+
+		size_t total = 0;
+		for (int i = 0; i < nstripes; i++)
+			total += stripes[i].size();
+		keypoints.clear();
+		keypoints.reserve(total);
+		for (int i = 0; i < nstripes; i++)
+			keypoints.insert(keypoints.end(), stripes[i].begin(), stripes[i].end());
 	}
 
 
@@ -0,0 +1,1046 @@
+#include "precomp.hpp"
+#include "../../core/include/opencv2/core/hal/intrin.hpp"
+#include <limits>
+
+namespace cv
+{
+
+	/****************************************************************************************\
+	*                                DescriptorMatcher::DescriptorCollection                *
+	\****************************************************************************************/
+
+	DescriptorMatcher::DescriptorCollection::DescriptorCollection()
+	{}
+
+	DescriptorMatcher::DescriptorCollection::DescriptorCollection(const DescriptorCollection& collection)
+	{
+		mergedDescriptors = collection.mergedDescriptors.clone();
+		startIdxs = collection.startIdxs;
+	}
+
+	DescriptorMatcher::DescriptorCollection::~DescriptorCollection()
+	{}
+
+	void DescriptorMatcher::DescriptorCollection::set(const std::vector<Mat>& descriptors)
+	{
+		clear();
+
+		size_t imageCount = descriptors.size();
+		CV_Assert(imageCount > 0);
+
+		startIdxs.resize(imageCount);
+
+		int dim = 0;
+		int type = -1;
+		startIdxs[0] = 0;
+		for (size_t i = 1; i < imageCount; i++)
+		{
+			int s = 0;
+			if (!descriptors[i - 1].empty())
+			{
+				dim = descriptors[i - 1].cols;
+				type = descriptors[i - 1].type();
+				s = descriptors[i - 1].rows;
+			}
+			startIdxs[i] = startIdxs[i - 1] + s;
+		}
+		if (imageCount == 1)
+		{
+			if (descriptors[0].empty()) return;
+
+			dim = descriptors[0].cols;
+			type = descriptors[0].type();
+		}
+		CV_Assert(dim > 0);
+
+		int count = startIdxs[imageCount - 1] + descriptors[imageCount - 1].rows;
+
+		if (count > 0)
+		{
+			mergedDescriptors.create(count, dim, type);
+			for (size_t i = 0; i < imageCount; i++)
+			{
+				if (!descriptors[i].empty())
+				{
+					CV_Assert(descriptors[i].cols == dim && descriptors[i].type() == type);
+					Mat m = mergedDescriptors.rowRange(startIdxs[i], startIdxs[i] + descriptors[i].rows);
+					descriptors[i].copyTo(m);
+				}
+			}
+		}
+	}
+
+	void DescriptorMatcher::DescriptorCollection::clear()
+	{
+		startIdxs.clear();
+		mergedDescriptors.release();
+	}
+
+	const Mat DescriptorMatcher::DescriptorCollection::getDescriptor(int imgIdx, int localDescIdx) const
+	{
+		CV_Assert(imgIdx < (int)startIdxs.size());
+		int globalIdx = startIdxs[imgIdx] + localDescIdx;
+		CV_Assert(globalIdx < (int)size());
+
+		return getDescriptor(globalIdx);
+	}
+
+	const Mat& DescriptorMatcher::DescriptorCollection::getDescriptors() const
+	{
+		return mergedDescriptors;
+	}
+
+	const Mat DescriptorMatcher::DescriptorCollection::getDescriptor(int globalDescIdx) const
+	{
+		CV_Assert(globalDescIdx < size());
+		return mergedDescriptors.row(globalDescIdx);
+	}
+
+	void DescriptorMatcher::DescriptorCollection::getLocalIdx(int globalDescIdx, int& imgIdx, int& localDescIdx) const
+	{
+		CV_Assert((globalDescIdx >= 0) && (globalDescIdx < size()));
+		std::vector<int>::const_iterator img_it = std::upper_bound(startIdxs.begin(), startIdxs.end(), globalDescIdx);
+		--img_it;
+		imgIdx = (int)(img_it - startIdxs.begin());
+		localDescIdx = globalDescIdx - (*img_it);
+	}
+
+	int DescriptorMatcher::DescriptorCollection::size() const
+	{
+		return mergedDescriptors.rows;
+	}
+
+	/****************************************************************************************\
+	*                                    DescriptorMatcher                                   *
+	\****************************************************************************************/
+
+	static void convertMatches(const std::vector<std::vector<DMatch> >& knnMatches, std::vector<DMatch>& matches)
+	{
+		matches.clear();
+		matches.reserve(knnMatches.size());
+		for (size_t i = 0; i < knnMatches.size(); i++)
+		{
+			CV_Assert(knnMatches[i].size() <= 1);
+			if (!knnMatches[i].empty())
+				matches.push_back(knnMatches[i][0]);
+		}
+	}
+
+	DescriptorMatcher::~DescriptorMatcher()
+	{}
+
+	void DescriptorMatcher::add(InputArrayOfArrays _descriptors)
+	{
+		if (_descriptors.isMatVector())
+		{
+			std::vector<Mat> descriptors;
+			_descriptors.getMatVector(descriptors);
+			trainDescCollection.insert(trainDescCollection.end(), descriptors.begin(), descriptors.end());
+		}
+		else if (_descriptors.isMat())
+		{
+			Mat descriptors = _descriptors.getMat();
+			trainDescCollection.push_back(descriptors);
+		}
+		else
+			CV_Error(Error::StsBadArg, "The descriptors must be a Mat or a vector of Mat");
+	}
+
+	const std::vector<Mat>& DescriptorMatcher::getTrainDescriptors() const
+	{
+		return trainDescCollection;
+	}
+
+	void DescriptorMatcher::clear()
+	{
+		utrainDescCollection.clear();
+		trainDescCollection.clear();
+	}
+
+	bool DescriptorMatcher::empty() const
+	{
+		return trainDescCollection.empty() && utrainDescCollection.empty();
+	}
+
+	void DescriptorMatcher::train()
+	{}
+
+	void DescriptorMatcher::match(InputArray queryDescriptors, InputArray trainDescriptors,
+		std::vector<DMatch>& matches, InputArray mask) const
+	{
+		CV_INSTRUMENT_REGION()
+
+		Ptr<DescriptorMatcher> tempMatcher = clone(true);
+		tempMatcher->add(trainDescriptors);
+		tempMatcher->match(queryDescriptors, matches, std::vector<Mat>(1, mask.getMat()));
+	}
+
+	void DescriptorMatcher::knnMatch(InputArray queryDescriptors, InputArray trainDescriptors,
+		std::vector<std::vector<DMatch> >& matches, int knn,
+		InputArray mask, bool compactResult) const
+	{
+		CV_INSTRUMENT_REGION()
+
+		Ptr<DescriptorMatcher> tempMatcher = clone(true);
+		tempMatcher->add(trainDescriptors);
+		tempMatcher->knnMatch(queryDescriptors, matches, knn, std::vector<Mat>(1, mask.getMat()), compactResult);
+	}
+
+	void DescriptorMatcher::radiusMatch(InputArray queryDescriptors, InputArray trainDescriptors,
+		std::vector<std::vector<DMatch> >& matches, float maxDistance, InputArray mask,
+		bool compactResult) const
+	{
+		CV_INSTRUMENT_REGION()
+
+		Ptr<DescriptorMatcher> tempMatcher = clone(true);
+		tempMatcher->add(trainDescriptors);
+		tempMatcher->radiusMatch(queryDescriptors, matches, maxDistance, std::vector<Mat>(1, mask.getMat()), compactResult);
+	}
+
+	void DescriptorMatcher::match(InputArray queryDescriptors, std::vector<DMatch>& matches, InputArrayOfArrays masks)
+	{
+		CV_INSTRUMENT_REGION()
+
+		std::vector<std::vector<DMatch> > knnMatches;
+		knnMatch(queryDescriptors, knnMatches, 1, masks, true /*compactResult*/);
+		convertMatches(knnMatches, matches);
+	}
+
+	void DescriptorMatcher::checkMasks(InputArrayOfArrays _masks, int queryDescriptorsCount) const
+	{
+		std::vector<Mat> masks;
+		_masks.getMatVector(masks);
+		// Check masks
+		size_t imageCount = trainDescCollection.size();
+		if (!masks.empty() && imageCount > 0)
+		{
+			CV_Assert(masks.size() == imageCount);
+			for (size_t i = 0; i < imageCount; i++)
+			{
+				if (!masks[i].empty() && !trainDescCollection[i].empty())
+				{
+					CV_Assert(masks[i].rows == queryDescriptorsCount &&
+						masks[i].cols == trainDescCollection[i].rows && masks[i].type() == CV_8UC1);
+				}
+			}
+		}
+	}
+
+	void DescriptorMatcher::knnMatch(InputArray queryDescriptors, std::vector<std::vector<DMatch> >& matches, int knn,
+		InputArrayOfArrays masks, bool compactResult)
+	{
+		CV_INSTRUMENT_REGION()
+
+		if (empty() || queryDescriptors.empty())
+		{
+			matches.clear();
+			return;
+		}
+
+		CV_Assert(knn > 0);
+
+		checkMasks(masks, queryDescriptors.size().height);
+
+		train();
+		knnMatchImpl(queryDescriptors, matches, knn, masks, compactResult);
+	}
+
+	void DescriptorMatcher::radiusMatch(InputArray queryDescriptors, std::vector<std::vector<DMatch> >& matches, float maxDistance,
+		InputArrayOfArrays masks, bool compactResult)
+	{
+		CV_INSTRUMENT_REGION()
+
+		matches.clear();
+		if (empty() || queryDescriptors.empty())
+			return;
+
+		CV_Assert(maxDistance > std::numeric_limits<float>::epsilon());
+
+		checkMasks(masks, queryDescriptors.size().height);
+
+		train();
+		radiusMatchImpl(queryDescriptors, matches, maxDistance, masks, compactResult);
+	}
+
+	void DescriptorMatcher::read(const FileNode&)
+	{}
+
+	void DescriptorMatcher::write(FileStorage&) const
+	{}
+
+	bool DescriptorMatcher::isPossibleMatch(InputArray _mask, int queryIdx, int trainIdx)
+	{
+		Mat mask = _mask.getMat();
+		return mask.empty() || mask.at<uchar>(queryIdx, trainIdx);
+	}
+
+	bool DescriptorMatcher::isMaskedOut(InputArrayOfArrays _masks, int queryIdx)
+	{
+		std::vector<Mat> masks;
+		_masks.getMatVector(masks);
+
+		size_t outCount = 0;
+		for (size_t i = 0; i < masks.size(); i++)
+		{
+			if (!masks[i].empty() && (countNonZero(masks[i].row(queryIdx)) == 0))
+				outCount++;
+		}
+
+		return !masks.empty() && outCount == masks.size();
+	}
+
+	Ptr<DescriptorMatcher> DescriptorMatcher::create(const String& descriptorMatcherType)
+	{
+		Ptr<DescriptorMatcher> dm;
+		if (!descriptorMatcherType.compare("BruteForce")) // L2
+			dm = makePtr<BFMatcher>(int(NORM_L2)); // anonymous enums can't be template parameters
+		else if (!descriptorMatcherType.compare("BruteForce-SL2")) // Squared L2
+			dm = makePtr<BFMatcher>(int(NORM_L2SQR));
+		else if (!descriptorMatcherType.compare("BruteForce-L1"))
+			dm = makePtr<BFMatcher>(int(NORM_L1));
+		else if (!descriptorMatcherType.compare("BruteForce-Hamming") ||
+			!descriptorMatcherType.compare("BruteForce-HammingLUT"))
+			dm = makePtr<BFMatcher>(int(NORM_HAMMING));
+		else if (!descriptorMatcherType.compare("BruteForce-Hamming(2)"))
+			dm = makePtr<BFMatcher>(int(NORM_HAMMING2));
+		else
+			CV_Error(Error::StsBadArg, "Unknown matcher name");
+
+		return dm;
+	}
+
+	Ptr<DescriptorMatcher> DescriptorMatcher::create(int matcherType)
+	{
+		String name;
+
+		switch (matcherType)
+		{
+		case BRUTEFORCE:
+			name = "BruteForce";
+			break;
+		case BRUTEFORCE_L1:
+			name = "BruteForce-L1";
+			break;
+		case BRUTEFORCE_HAMMING:
+			name = "BruteForce-Hamming";
+			break;
+		case BRUTEFORCE_HAMMINGLUT:
+			name = "BruteForce-HammingLUT";
+			break;
+		case BRUTEFORCE_SL2:
+			name = "BruteForce-SL2";
+			break;
+		default:
+			CV_Error(Error::StsBadArg, "Specified descriptor matcher type is not supported.");
+			break;
+		}
+
+		return DescriptorMatcher::create(name);
+	}
+
+	/****************************************************************************************\
+	*                                      BFMatcher                                         *
+	\****************************************************************************************/
+
+	// ORB descriptors are 32 bytes; their distance is computed inline with the hardware popcount or
+	// the vectorized byte popcount, the other sizes go to hal::normHamming
+	struct HammingDistance
+	{
+		typedef uchar ValueType;
+		typedef int ResultType;
+
+		ResultType operator()(const uchar* a, const uchar* b, int n) const
+		{
+			if (n == 32)
+			{
+#if CV_POPCNT && defined CV_POPCNT_U64
+				const uint64* a8 = (const uint64*)a;
+				const uint64* b8 = (const uint64*)b;
+				return (int)(CV_POPCNT_U64(a8[0] ^ b8[0]) + CV_POPCNT_U64(a8[1] ^ b8[1]) +
+					CV_POPCNT_U64(a8[2] ^ b8[2]) + CV_POPCNT_U64(a8[3] ^ b8[3]));
+#elif CV_SIMD128
+				v_uint32x4 t = v_popcount(v_load(a) ^ v_load(b)) + v_popcount(v_load(a + 16) ^ v_load(b + 16));
+				return (int)v_reduce_sum(t);
+#endif
+			}
+			return hal::normHamming(a, b, n);
+		}
+	};
+
+	struct Hamming2Distance
+	{
+		typedef uchar ValueType;
+		typedef int ResultType;
+
+		ResultType operator()(const uchar* a, const uchar* b, int n) const
+		{
+			return hal::normHamming(a, b, n, 2);
+		}
+	};
+
+	template<typename T> struct L1Distance
+	{
+		typedef T ValueType;
+		typedef typename Accumulator<T>::Type ResultType;
+
+		ResultType operator()(const T* a, const T* b, int n) const
+		{
+			return normL1<ValueType, ResultType>(a, b, n);
+		}
+	};
+
+	// the square is compared, the root is taken only for the output matches
+	template<typename T> struct L2SqrDistance
+	{
+		typedef T ValueType;
+		typedef typename Accumulator<T>::Type ResultType;
+
+		ResultType operator()(const T* a, const T* b, int n) const
+		{
+			return normL2Sqr<ValueType, ResultType>(a, b, n);
+		}
+	};
+
+	// Finds the k nearest train rows of every query row. The queries are split into blocks processed
+	// in parallel, and every block goes over the train set in blocks small enough to stay in cache
+	// while all the queries of the block are compared with them. The k best distances and indices
+	// of a query are kept sorted in dist/idx, which can hold the results for a previous train
+	// matrix, so several train images are processed one after another with idxOfs added to the
+	// indices. The mask is indexed (query, train), or (train, query) when it is transposed.
+	template<class Distance> class BFMatchInvoker : public ParallelLoopBody
+	{
+	public:
+		typedef typename Distance::ValueType T;
+		typedef typename Distance::ResultType DT;
+
+		enum { QUERY_BLOCK = 16 };
+
+		BFMatchInvoker(const Mat& _query, const Mat& _train, const Mat& _mask, bool _transposedMask,
+			int _k, int _idxOfs, DT* _dist, int* _idx) :
+			query(_query), train(_train), mask(_mask), transposedMask(_transposedMask),
+			k(_k), idxOfs(_idxOfs), dist(_dist), idx(_idx)
+		{
+			// about 16Kb of the train descriptors per block
+			trainBlock = std::max((int)(16384 / std::max(train.cols*train.elemSize(), (size_t)1)), 16);
+		}
+
+		void operator()(const Range& range) const
+		{
+			Distance distance;
+			int n = query.cols;
+
+			for (int t0 = 0; t0 < train.rows; t0 += trainBlock)
+			{
+				int t1 = std::min(t0 + trainBlock, train.rows);
+
+				for (int q = range.start; q < range.end; q++)
+				{
+					const T* a = query.ptr<T>(q);
+					DT* bestDist = dist + (size_t)q*k;
+					int* bestIdx = idx + (size_t)q*k;
+					DT worst = bestDist[k - 1];
+					const uchar* mrow = mask.data && !transposedMask ? mask.ptr(q) : 0;
+
+					for (int t = t0; t < t1; t++)
+					{
+						if (mask.data && !(mrow ? mrow[t] : mask.at<uchar>(t, q)))
+							continue;
+
+						DT d = distance(a, train.ptr<T>(t), n);
+						if (d < worst)
+						{
+							int j = k - 1;
+							for (; j > 0 && d < bestDist[j - 1]; j--)
+							{
+								bestDist[j] = bestDist[j - 1];
+								bestIdx[j] = bestIdx[j - 1];
+							}
+							bestDist[j] = d;
+							bestIdx[j] = t + idxOfs;
+							worst = bestDist[k - 1];
+						}
+					}
+				}
+			}
+		}
+
+	private:
+		const Mat& query;
+		const Mat& train;
+		const Mat& mask;
+		bool transposedMask;
+		int k;
+		int idxOfs;
+		DT* dist;
+		int* idx;
+		int trainBlock;
+	};
+
+	template<class Distance> static void
+		findNearest(const Mat& query, const Mat& train, const Mat& mask, bool transposedMask, int k,
+			int idxOfs, typename Distance::ResultType* dist, int* idx)
+	{
+		int nblocks = (query.rows + BFMatchInvoker<Distance>::QUERY_BLOCK - 1) / BFMatchInvoker<Distance>::QUERY_BLOCK;
+		parallel_for_(Range(0, query.rows), BFMatchInvoker<Distance>(query, train, mask, transposedMask,
+			k, idxOfs, dist, idx), nblocks);
+	}
+
+	// the train set is the concatenation of the train images; crossCheck keeps a match only when its
+	// query is the nearest one of its train descriptor within the train image
+	template<class Distance> static void
+		bfKnnMatch(const Mat& query, const std::vector<Mat>& trainCollection, const std::vector<Mat>& masks,
+			int k, bool crossCheck, bool sqrtDistance, std::vector<std::vector<DMatch> >& matches)
+	{
+		typedef typename Distance::ResultType DT;
+		const DT maxDist = std::numeric_limits<DT>::max();
+
+		std::vector<int> startIdxs(trainCollection.size() + 1, 0);
+		for (size_t i = 0; i < trainCollection.size(); i++)
+			startIdxs[i + 1] = startIdxs[i] + trainCollection[i].rows;
+
+		std::vector<DT> dist((size_t)query.rows*k, maxDist);
+		std::vector<int> idx((size_t)query.rows*k, -1);
+
+		for (size_t i = 0; i < trainCollection.size(); i++)
+		{
+			const Mat& train = trainCollection[i];
+			if (train.empty())
+				continue;
+			CV_Assert(train.type() == query.type() && train.cols == query.cols);
+			Mat mask = i < masks.size() ? masks[i] : Mat();
+
+			if (!crossCheck)
+			{
+				findNearest<Distance>(query, train, mask, false, k, startIdxs[i], &dist[0], &idx[0]);
+				continue;
+			}
+
+			// the nearest query of every train descriptor and the nearest train descriptor of every
+			// query in this image; a query keeps its match from the previous images otherwise
+			std::vector<DT> rdist(train.rows, maxDist), qdist(query.rows, maxDist);
+			std::vector<int> ridx(train.rows, -1), qidx(query.rows, -1);
+			findNearest<Distance>(train, query, mask, true, 1, 0, &rdist[0], &ridx[0]);
+			findNearest<Distance>(query, train, mask, false, 1, 0, &qdist[0], &qidx[0]);
+
+			for (int q = 0; q < query.rows; q++)
+			{
+				int t = qidx[q];
+				if (t >= 0 && ridx[t] == q && qdist[q] < dist[q])
+				{
+					dist[q] = qdist[q];
+					idx[q] = t + startIdxs[i];
+				}
+			}
+		}
+
+		matches.resize(query.rows);
+		for (int q = 0; q < query.rows; q++)
+		{
+			std::vector<DMatch>& mq = matches[q];
+			mq.clear();
+			for (int j = 0; j < k && idx[(size_t)q*k + j] >= 0; j++)
+			{
+				int gi = idx[(size_t)q*k + j];
+				int imgIdx = (int)(std::upper_bound(startIdxs.begin(), startIdxs.end(), gi) - startIdxs.begin()) - 1;
+				double d = (double)dist[(size_t)q*k + j];
+				mq.push_back(DMatch(q, gi - startIdxs[imgIdx], imgIdx, (float)(sqrtDistance ? std::sqrt(d) : d)));
+			}
+		}
+	}
+
+	// collects the train rows not farther than maxDistance from every query row, in parallel over
+	// the query blocks; the matches of a query are appended in the train order
+	template<class Distance> class BFRadiusMatchInvoker : public ParallelLoopBody
+	{
+	public:
+		typedef typename Distance::ValueType T;
+		typedef typename Distance::ResultType DT;
+
+		BFRadiusMatchInvoker(const Mat& _query, const Mat& _train, const Mat& _mask, int _imgIdx,
+			DT _maxDistance, bool _sqrtDistance, std::vector<std::vector<DMatch> >& _matches) :
+			query(_query), train(_train), mask(_mask), imgIdx(_imgIdx), maxDistance(_maxDistance),
+			sqrtDistance(_sqrtDistance), matches(_matches)
+		{
+			trainBlock = std::max((int)(16384 / std::max(train.cols*train.elemSize(), (size_t)1)), 16);
+		}
+
+		void operator()(const Range& range) const
+		{
+			Distance distance;
+			int n = query.cols;
+
+			for (int t0 = 0; t0 < train.rows; t0 += trainBlock)
+			{
+				int t1 = std::min(t0 + trainBlock, train.rows);
+
+				for (int q = range.start; q < range.end; q++)
+				{
+					const T* a = query.ptr<T>(q);
+					const uchar* mrow = mask.data ? mask.ptr(q) : 0;
+					std::vector<DMatch>& mq = matches[q];
+
+					for (int t = t0; t < t1; t++)
+					{
+						if (mrow && !mrow[t])
+							continue;
+
+						DT d = distance(a, train.ptr<T>(t), n);
+						if (d <= maxDistance)
+							mq.push_back(DMatch(q, t, imgIdx, (float)(sqrtDistance ? std::sqrt((double)d) : (double)d)));
+					}
+				}
+			}
+		}
+
+	private:
+		const Mat& query;
+		const Mat& train;
+		const Mat& mask;
+		int imgIdx;
+		DT maxDistance;
+		bool sqrtDistance;
+		std::vector<std::vector<DMatch> >& matches;
+		int trainBlock;
+	};
+
+	template<class Distance> static void
+		bfRadiusMatch(const Mat& query, const std::vector<Mat>& trainCollection, const std::vector<Mat>& masks,
+			double maxDistance, bool sqrtDistance, std::vector<std::vector<DMatch> >& matches)
+	{
+		typedef typename Distance::ResultType DT;
+
+		// the distance is compared before the root is taken
+		double maxDist = sqrtDistance ? maxDistance * maxDistance : maxDistance;
+		DT maxDistT = std::numeric_limits<DT>::is_integer ? (DT)std::min(std::floor(maxDist), (double)INT_MAX) : (DT)maxDist;
+
+		matches.clear();
+		matches.resize(query.rows);
+		int nblocks = (query.rows + BFMatchInvoker<Distance>::QUERY_BLOCK - 1) / BFMatchInvoker<Distance>::QUERY_BLOCK;
+
+		for (size_t i = 0; i < trainCollection.size(); i++)
+		{
+			const Mat& train = trainCollection[i];
+			if (train.empty())
+				continue;
+			CV_Assert(train.type() == query.type() && train.cols == query.cols);
+			Mat mask = i < masks.size() ? masks[i] : Mat();
+
+			parallel_for_(Range(0, query.rows), BFRadiusMatchInvoker<Distance>(query, train, mask, (int)i,
+				maxDistT, sqrtDistance, matches), nblocks);
+		}
+
+		for (int q = 0; q < query.rows; q++)
+			std::stable_sort(matches[q].begin(), matches[q].end());
+	}
+
+	BFMatcher::BFMatcher(int _normType, bool _crossCheck)
+	{
+		normType = _normType;
+		crossCheck = _crossCheck;
+	}
+
+	Ptr<BFMatcher> BFMatcher::create(int _normType, bool _crossCheck)
+	{
+		return makePtr<BFMatcher>(_normType, _crossCheck);
+	}
+
+	Ptr<DescriptorMatcher> BFMatcher::clone(bool emptyTrainData) const
+	{
+		Ptr<BFMatcher> matcher = makePtr<BFMatcher>(normType, crossCheck);
+		if (!emptyTrainData)
+		{
+			matcher->trainDescCollection.resize(trainDescCollection.size());
+			std::transform(trainDescCollection.begin(), trainDescCollection.end(),
+				matcher->trainDescCollection.begin(), clone_op);
+		}
+		return matcher;
+	}
+
+	// erases the matches of the queries masked out in all the train images
+	static void compactMatches(std::vector<std::vector<DMatch> >& matches, const std::vector<char>& maskedOut)
+	{
+		size_t i, j = 0;
+		for (i = 0; i < matches.size(); i++)
+		{
+			if (maskedOut[i])
+				continue;
+			if (i != j)
+				std::swap(matches[j], matches[i]);
+			j++;
+		}
+		matches.resize(j);
+	}
+
+	void BFMatcher::knnMatchImpl(InputArray _queryDescriptors, std::vector<std::vector<DMatch> >& matches, int knn,
+		InputArrayOfArrays _masks, bool compactResult)
+	{
+		Mat queryDescriptors = _queryDescriptors.getMat();
+		std::vector<Mat> masks;
+		_masks.getMatVector(masks);
+
+		int depth = queryDescriptors.depth();
+		CV_Assert(!crossCheck || knn == 1);
+
+		if (normType == NORM_HAMMING && depth == CV_8U)
+			bfKnnMatch<HammingDistance>(queryDescriptors, trainDescCollection, masks, knn, crossCheck, false, matches);
+		else if (normType == NORM_HAMMING2 && depth == CV_8U)
+			bfKnnMatch<Hamming2Distance>(queryDescriptors, trainDescCollection, masks, knn, crossCheck, false, matches);
+		else if ((normType == NORM_L2 || normType == NORM_L2SQR) && depth == CV_32F)
+			bfKnnMatch<L2SqrDistance<float> >(queryDescriptors, trainDescCollection, masks, knn, crossCheck, normType == NORM_L2, matches);
+		else if ((normType == NORM_L2 || normType == NORM_L2SQR) && depth == CV_8U)
+			bfKnnMatch<L2SqrDistance<uchar> >(queryDescriptors, trainDescCollection, masks, knn, crossCheck, normType == NORM_L2, matches);
+		else if (normType == NORM_L1 && depth == CV_32F)
+			bfKnnMatch<L1Distance<float> >(queryDescriptors, trainDescCollection, masks, knn, crossCheck, false, matches);
+		else if (normType == NORM_L1 && depth == CV_8U)
+			bfKnnMatch<L1Distance<uchar> >(queryDescriptors, trainDescCollection, masks, knn, crossCheck, false, matches);
+		else
+			CV_Error(Error::StsUnsupportedFormat, "Unsupported combination of the descriptor type and the norm");
+
+		if (compactResult && !masks.empty())
+		{
+			std::vector<char> maskedOut(matches.size());
+			for (size_t i = 0; i < matches.size(); i++)
+				maskedOut[i] = isMaskedOut(masks, (int)i);
+			compactMatches(matches, maskedOut);
+		}
+	}
+
+	void BFMatcher::radiusMatchImpl(InputArray _queryDescriptors, std::vector<std::vector<DMatch> >& matches,
+		float maxDistance, InputArrayOfArrays _masks, bool compactResult)
+	{
+		Mat queryDescriptors = _queryDescriptors.getMat();
+		std::vector<Mat> masks;
+		_masks.getMatVector(masks);
+
+		int depth = queryDescriptors.depth();
+
+		if (normType == NORM_HAMMING && depth == CV_8U)
+			bfRadiusMatch<HammingDistance>(queryDescriptors, trainDescCollection, masks, maxDistance, false, matches);
+		else if (normType == NORM_HAMMING2 && depth == CV_8U)
+			bfRadiusMatch<Hamming2Distance>(queryDescriptors, trainDescCollection, masks, maxDistance, false, matches);
+		else if ((normType == NORM_L2 || normType == NORM_L2SQR) && depth == CV_32F)
+			bfRadiusMatch<L2SqrDistance<float> >(queryDescriptors, trainDescCollection, masks, maxDistance, normType == NORM_L2, matches);
+		else if ((normType == NORM_L2 || normType == NORM_L2SQR) && depth == CV_8U)
+			bfRadiusMatch<L2SqrDistance<uchar> >(queryDescriptors, trainDescCollection, masks, maxDistance, normType == NORM_L2, matches);
+		else if (normType == NORM_L1 && depth == CV_32F)
+			bfRadiusMatch<L1Distance<float> >(queryDescriptors, trainDescCollection, masks, maxDistance, false, matches);
+		else if (normType == NORM_L1 && depth == CV_8U)
+			bfRadiusMatch<L1Distance<uchar> >(queryDescriptors, trainDescCollection, masks, maxDistance, false, matches);
+		else
+			CV_Error(Error::StsUnsupportedFormat, "Unsupported combination of the descriptor type and the norm");
+
+		if (compactResult)
+		{
+			// without masks, the queries without matches are dropped
+			std::vector<char> maskedOut(matches.size());
+			for (size_t i = 0; i < matches.size(); i++)
+				maskedOut[i] = masks.empty() ? matches[i].empty() : isMaskedOut(masks, (int)i);
+			compactMatches(matches, maskedOut);
+		}
+	}
+
+	/****************************************************************************************\
+	*                                  HammingHashMatcher                                    *
+	\****************************************************************************************/
+
+	// the 16-bit substring s of a descriptor of n bytes; the last one has 8 bits when n is odd
+	static inline int substringKey(const uchar* d, int s, int n)
+	{
+		return 2 * s + 1 < n ? d[2 * s] | (d[2 * s + 1] << 8) : d[2 * s];
+	}
+
+	static inline int substringBits(int s, int n)
+	{
+		return 2 * s + 1 < n ? 16 : 8;
+	}
+
+	// counting sort of the train descriptors by the key of every substring
+	class HammingHashBuildInvoker : public ParallelLoopBody
+	{
+	public:
+		HammingHashBuildInvoker(const Mat& _train, std::vector<std::vector<int> >& _bucketStarts,
+			std::vector<std::vector<int> >& _bucketIds) :
+			train(_train), bucketStarts(_bucketStarts), bucketIds(_bucketIds)
+		{}
+
+		void operator()(const Range& range) const
+		{
+			int n = train.cols;
+
+			for (int s = range.start; s < range.end; s++)
+			{
+				std::vector<int>& starts = bucketStarts[s];
+				std::vector<int>& ids = bucketIds[s];
+				int nbuckets = 1 << substringBits(s, n);
+
+				starts.assign(nbuckets + 1, 0);
+				ids.resize(train.rows);
+
+				for (int i = 0; i < train.rows; i++)
+					starts[substringKey(train.ptr(i), s, n) + 1]++;
+				for (int b = 0; b < nbuckets; b++)
+					starts[b + 1] += starts[b];
+
+				std::vector<int> pos(starts.begin(), starts.end() - 1);
+				for (int i = 0; i < train.rows; i++)
+					ids[pos[substringKey(train.ptr(i), s, n)]++] = i;
+			}
+		}
+
+	private:
+		const Mat& train;
+		std::vector<std::vector<int> >& bucketStarts;
+		std::vector<std::vector<int> >& bucketIds;
+	};
+
+	// Probes the buckets within the radius r = 0, 1, ... of the query substrings, computes the
+	// distance of every descriptor found for the first time and stops as soon as no unseen
+	// descriptor can be closer than the current k-th best (or than maxDistance when k == 0, where
+	// all the descriptors not farther than maxDistance are collected).
+	class HammingHashSearchInvoker : public ParallelLoopBody
+	{
+	public:
+		HammingHashSearchInvoker(const Mat& _query, const Mat& _train,
+			const std::vector<std::vector<int> >& _bucketStarts, const std::vector<std::vector<int> >& _bucketIds,
+			const std::vector<ushort>& _flipMasks, const std::vector<int>& _flipOffsets,
+			int _k, int _maxDistance, std::vector<std::vector<DMatch> >& _matches) :
+			query(_query), train(_train), bucketStarts(_bucketStarts), bucketIds(_bucketIds),
+			flipMasks(_flipMasks), flipOffsets(_flipOffsets), k(_k), maxDistance(_maxDistance), matches(_matches)
+		{}
+
+		void operator()(const Range& range) const
+		{
+			HammingDistance distance;
+			int n = train.cols, nsub = (int)bucketStarts.size();
+			int maxRadius = (int)flipOffsets.size() - 2;
+
+			// the last query which reached each train descriptor
+			std::vector<int> visited(train.rows, -1);
+			AutoBuffer<int> _buf(nsub + k * 2);
+			int* keys = _buf;
+			int* bestDist = keys + nsub;
+			int* bestIdx = bestDist + k;
+			std::vector<DMatch> found;
+
+			for (int q = range.start; q < range.end; q++)
+			{
+				const uchar* a = query.ptr(q);
+				for (int s = 0; s < nsub; s++)
+					keys[s] = substringKey(a, s, n);
+				for (int j = 0; j < k; j++)
+				{
+					bestDist[j] = INT_MAX;
+					bestIdx[j] = -1;
+				}
+				found.clear();
+
+				for (int r = 0; r <= maxRadius; r++)
+				{
+					for (int s = 0; s < nsub; s++)
+					{
+						const int* starts = &bucketStarts[s][0];
+						const int* ids = &bucketIds[s][0];
+						int bits = substringBits(s, n);
+
+						for (int f = flipOffsets[r]; f < flipOffsets[r + 1]; f++)
+						{
+							int m = flipMasks[f];
+							if (m >> bits)
+								continue;
+
+							int key = keys[s] ^ m;
+							for (int b = starts[key]; b < starts[key + 1]; b++)
+							{
+								int t = ids[b];
+								if (visited[t] == q)
+									continue;
+								visited[t] = q;
+
+								int d = distance(a, train.ptr(t), n);
+								if (k == 0)
+								{
+									if (d <= maxDistance)
+										found.push_back(DMatch(q, t, (float)d));
+								}
+								else if (d < bestDist[k - 1])
+								{
+									int j = k - 1;
+									for (; j > 0 && d < bestDist[j - 1]; j--)
+									{
+										bestDist[j] = bestDist[j - 1];
+										bestIdx[j] = bestIdx[j - 1];
+									}
+									bestDist[j] = d;
+									bestIdx[j] = t;
+								}
+							}
+						}
+					}
+
+					// every unseen descriptor has all its substrings farther than r
+					int bound = nsub * (r + 1);
+					if ((k == 0 ? maxDistance : bestDist[k - 1]) < bound)
+						break;
+				}
+
+				if (k > 0)
+				{
+					for (int j = 0; j < k && bestIdx[j] >= 0; j++)
+						found.push_back(DMatch(q, bestIdx[j], (float)bestDist[j]));
+				}
+				else
+					std::stable_sort(found.begin(), found.end());
+
+				matches[q] = found;
+			}
+		}
+
+	private:
+		const Mat& query;
+		const Mat& train;
+		const std::vector<std::vector<int> >& bucketStarts;
+		const std::vector<std::vector<int> >& bucketIds;
+		const std::vector<ushort>& flipMasks;
+		const std::vector<int>& flipOffsets;
+		int k;
+		int maxDistance;
+		std::vector<std::vector<DMatch> >& matches;
+	};
+
+	HammingHashMatcher::HammingHashMatcher(int _maxProbeRadius)
+		: maxProbeRadius(_maxProbeRadius), addedDescCount(0)
+	{
+		CV_Assert(maxProbeRadius >= 0);
+
+		// the masks flipping up to maxRadius bits of a substring, ordered by the number of flips
+		int maxRadius = std::min(maxProbeRadius, 16);
+		flipOffsets.assign(maxRadius + 2, 0);
+		for (int m = 0; m < 65536; m++)
+		{
+			int c = hal::normHamming((const uchar*)&m, 2);
+			if (c <= maxRadius)
+				flipOffsets[c + 1]++;
+		}
+		for (int r = 0; r <= maxRadius; r++)
+			flipOffsets[r + 1] += flipOffsets[r];
+
+		flipMasks.resize(flipOffsets[maxRadius + 1]);
+		std::vector<int> pos(flipOffsets.begin(), flipOffsets.end() - 1);
+		for (int m = 0; m < 65536; m++)
+		{
+			int c = hal::normHamming((const uchar*)&m, 2);
+			if (c <= maxRadius)
+				flipMasks[pos[c]++] = (ushort)m;
+		}
+	}
+
+	Ptr<HammingHashMatcher> HammingHashMatcher::create(int _maxProbeRadius)
+	{
+		return makePtr<HammingHashMatcher>(_maxProbeRadius);
+	}
+
+	void HammingHashMatcher::add(InputArrayOfArrays _descriptors)
+	{
+		if (_descriptors.isMatVector())
+		{
+			std::vector<Mat> descriptors;
+			_descriptors.getMatVector(descriptors);
+			for (size_t i = 0; i < descriptors.size(); i++)
+				addedDescCount += descriptors[i].rows;
+		}
+		else if (_descriptors.isMat())
+			addedDescCount += _descriptors.getMat().rows;
+
+		DescriptorMatcher::add(_descriptors);
+	}
+
+	void HammingHashMatcher::clear()
+	{
+		DescriptorMatcher::clear();
+
+		mergedDescriptors.clear();
+		bucketStarts.clear();
+		bucketIds.clear();
+		addedDescCount = 0;
+	}
+
+	void HammingHashMatcher::train()
+	{
+		CV_INSTRUMENT_REGION()
+
+		if (!bucketStarts.empty() && mergedDescriptors.size() == addedDescCount)
+			return;
+
+		mergedDescriptors.set(trainDescCollection);
+		const Mat& train = mergedDescriptors.getDescriptors();
+		CV_Assert(train.type() == CV_8UC1);
+
+		int nsub = (train.cols + 1) / 2;
+		bucketStarts.assign(nsub, std::vector<int>());
+		bucketIds.assign(nsub, std::vector<int>());
+		parallel_for_(Range(0, nsub), HammingHashBuildInvoker(train, bucketStarts, bucketIds));
+	}
+
+	Ptr<DescriptorMatcher> HammingHashMatcher::clone(bool emptyTrainData) const
+	{
+		Ptr<HammingHashMatcher> matcher = makePtr<HammingHashMatcher>(maxProbeRadius);
+		if (!emptyTrainData)
+		{
+			matcher->trainDescCollection.resize(trainDescCollection.size());
+			std::transform(trainDescCollection.begin(), trainDescCollection.end(),
+				matcher->trainDescCollection.begin(), clone_op);
+			matcher->addedDescCount = addedDescCount;
+		}
+		return matcher;
+	}
+
+	// the matches are returned with the indices in the merged train descriptors
+	static void hammingHashSearch(const Mat& query, const Mat& train,
+		const std::vector<std::vector<int> >& bucketStarts, const std::vector<std::vector<int> >& bucketIds,
+		const std::vector<ushort>& flipMasks, const std::vector<int>& flipOffsets,
+		int k, int maxDistance, std::vector<std::vector<DMatch> >& matches)
+	{
+		CV_Assert(query.type() == CV_8UC1 && query.cols == train.cols);
+
+		matches.clear();
+		matches.resize(query.rows);
+		if (train.empty())
+			return;
+
+		// every stripe allocates the visited marks of the whole train set
+		int nstripes = std::min(std::max(getNumThreads(), 1) * 4, query.rows);
+		parallel_for_(Range(0, query.rows), HammingHashSearchInvoker(query, train, bucketStarts, bucketIds,
+			flipMasks, flipOffsets, k, maxDistance, matches), nstripes);
+	}
+
+	void HammingHashMatcher::knnMatchImpl(InputArray _queryDescriptors, std::vector<std::vector<DMatch> >& matches, int knn,
+		InputArrayOfArrays /*masks*/, bool /*compactResult*/)
+	{
+		hammingHashSearch(_queryDescriptors.getMat(), mergedDescriptors.getDescriptors(), bucketStarts, bucketIds,
+			flipMasks, flipOffsets, knn, 0, matches);
+
+		for (size_t i = 0; i < matches.size(); i++)
+			for (size_t j = 0; j < matches[i].size(); j++)
+				mergedDescriptors.getLocalIdx(matches[i][j].trainIdx, matches[i][j].imgIdx, matches[i][j].trainIdx);
+	}
+
+	void HammingHashMatcher::radiusMatchImpl(InputArray _queryDescriptors, std::vector<std::vector<DMatch> >& matches,
+		float maxDistance, InputArrayOfArrays /*masks*/, bool compactResult)
+	{
+		hammingHashSearch(_queryDescriptors.getMat(), mergedDescriptors.getDescriptors(), bucketStarts, bucketIds,
+			flipMasks, flipOffsets, 0, cvFloor(maxDistance), matches);
+
+		for (size_t i = 0; i < matches.size(); i++)
+			for (size_t j = 0; j < matches[i].size(); j++)
+				mergedDescriptors.getLocalIdx(matches[i][j].trainIdx, matches[i][j].imgIdx, matches[i][j].trainIdx);
+
+		if (compactResult)
+		{
+			std::vector<char> noMatches(matches.size());
+			for (size_t i = 0; i < matches.size(); i++)
+				noMatches[i] = matches[i].empty();
+			compactMatches(matches, noMatches);
+		}
+	}
+
+}
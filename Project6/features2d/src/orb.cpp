@@ -1,5 +1,6 @@
 #include "precomp.hpp"
 //#include "opencl_kernels_features2d.hpp"
+#include "../../core/include/opencv2/core/hal/intrin.hpp"
 #include <iterator>
 
 #ifndef CV_IMPL_ADD
@@ -87,18 +88,34 @@ namespace cv
 	}
 #endif
 
-	/**
-	* Function that computes the Harris responses in a
-	* blockSize x blockSize patch at given points in the image
-	*/
-	static void
-		HarrisResponses(const Mat& img, const std::vector<Rect>& layerinfo,
-			std::vector<KeyPoint>& pts, int blockSize, float harris_k)
+	// the keypoints are scored and described in parallel chunks of this size
+	static const int ORB_KEYPOINT_CHUNK = 64;
+
+	static inline double keypointStripes(size_t npoints)
 	{
-		CV_Assert(img.type() == CV_8UC1 && blockSize*blockSize <= 2048);
+		return (double)((npoints + ORB_KEYPOINT_CHUNK - 1) / ORB_KEYPOINT_CHUNK);
+	}
 
-		size_t ptidx, ptsize = pts.size();
+	class HarrisResponsesInvoker : public ParallelLoopBody
+	{
+	public:
+		HarrisResponsesInvoker(const Mat& _img, const std::vector<Rect>& _layerinfo,
+			std::vector<KeyPoint>& _pts, int _blockSize, float _harris_k) :
+			img(_img), layerinfo(_layerinfo), pts(_pts), blockSize(_blockSize), harris_k(_harris_k)
+		{}
 
+		void operator()(const Range& range) const;
+
+	private:
+		const Mat& img;
+		const std::vector<Rect>& layerinfo;
+		std::vector<KeyPoint>& pts;
+		int blockSize;
+		float harris_k;
+	};
+
+	void HarrisResponsesInvoker::operator()(const Range& range) const
+	{
 		const uchar* ptr00 = img.ptr<uchar>();
 		int step = (int)(img.step / img.elemSize1());
 		int r = blockSize / 2;
@@ -112,7 +129,7 @@ namespace cv
 			for (int j = 0; j < blockSize; j++)
 				ofs[i*blockSize + j] = (int)(i*step + j);
 
-		for (ptidx = 0; ptidx < ptsize; ptidx++)
+		for (int ptidx = range.start; ptidx < range.end; ptidx++)
 		{
 			int x0 = cvRound(pts[ptidx].pt.x);
 			int y0 = cvRound(pts[ptidx].pt.y);
@@ -135,15 +152,45 @@ namespace cv
 		}
 	}
 
+	/**
+	* Function that computes the Harris responses in a
+	* blockSize x blockSize patch at given points in the image
+	*/
+	static void
+		HarrisResponses(const Mat& img, const std::vector<Rect>& layerinfo,
+			std::vector<KeyPoint>& pts, int blockSize, float harris_k)
+	{
+		CV_Assert(img.type() == CV_8UC1 && blockSize*blockSize <= 2048);
+
+		parallel_for_(Range(0, (int)pts.size()), HarrisResponsesInvoker(img, layerinfo, pts, blockSize, harris_k),
+			keypointStripes(pts.size()));
+	}
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-	static void ICAngles(const Mat& img, const std::vector<Rect>& layerinfo,
-		std::vector<KeyPoint>& pts, const std::vector<int> & u_max, int half_k)
+	class ICAnglesInvoker : public ParallelLoopBody
+	{
+	public:
+		ICAnglesInvoker(const Mat& _img, const std::vector<Rect>& _layerinfo,
+			std::vector<KeyPoint>& _pts, const std::vector<int>& _u_max, int _half_k) :
+			img(_img), layerinfo(_layerinfo), pts(_pts), u_max(_u_max), half_k(_half_k)
+		{}
+
+		void operator()(const Range& range) const;
+
+	private:
+		const Mat& img;
+		const std::vector<Rect>& layerinfo;
+		std::vector<KeyPoint>& pts;
+		const std::vector<int>& u_max;
+		int half_k;
+	};
+
+	void ICAnglesInvoker::operator()(const Range& range) const
 	{
 		int step = (int)img.step1();
-		size_t ptidx, ptsize = pts.size();
 
-		for (ptidx = 0; ptidx < ptsize; ptidx++)
+		for (int ptidx = range.start; ptidx < range.end; ptidx++)
 		{
 			const Rect& layer = layerinfo[pts[ptidx].octave];
 			const uchar* center = &img.at<uchar>(cvRound(pts[ptidx].pt.y) + layer.y, cvRound(pts[ptidx].pt.x) + layer.x);
@@ -173,53 +220,121 @@ namespace cv
 		}
 	}
 
+	static void ICAngles(const Mat& img, const std::vector<Rect>& layerinfo,
+		std::vector<KeyPoint>& pts, const std::vector<int> & u_max, int half_k)
+	{
+		parallel_for_(Range(0, (int)pts.size()), ICAnglesInvoker(img, layerinfo, pts, u_max, half_k),
+			keypointStripes(pts.size()));
+	}
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-	static void
-		computeOrbDescriptors(const Mat& imagePyramid, const std::vector<Rect>& layerInfo,
-			const std::vector<float>& layerScale, std::vector<KeyPoint>& keypoints,
-			Mat& descriptors, const std::vector<Point>& _pattern, int dsize, int wta_k)
+	// Offsets from the keypoint center of the pattern points rotated by the angle of cosine a and
+	// sine b, rounded to the nearest pixel
+	static void rotatePatternOffsets(const Point* pattern, int npoints, float a, float b, int step, int* ofs)
+	{
+		int i = 0;
+#if CV_SIMD128
+		v_float32x4 va = v_setall_f32(a), vb = v_setall_f32(b);
+		v_int32x4 vstep = v_setall_s32(step);
+		for (; i <= npoints - 4; i += 4)
+		{
+			v_int32x4 px, py;
+			v_load_deinterleave((const int*)(pattern + i), px, py);
+			v_float32x4 fx = v_cvt_f32(px), fy = v_cvt_f32(py);
+			v_int32x4 ix = v_round(fx*va - fy*vb), iy = v_round(fx*vb + fy*va);
+			v_store(ofs + i, iy*vstep + ix);
+		}
+#endif
+		for (; i < npoints; i++)
+		{
+			float x = pattern[i].x*a - pattern[i].y*b;
+			float y = pattern[i].x*b + pattern[i].y*a;
+			ofs[i] = cvRound(y)*step + cvRound(x);
+		}
+	}
+
+	class OrbDescriptorsInvoker : public ParallelLoopBody
+	{
+	public:
+		OrbDescriptorsInvoker(const Mat& _imagePyramid, const std::vector<Rect>& _layerInfo,
+			const std::vector<float>& _layerScale, const std::vector<KeyPoint>& _keypoints,
+			Mat& _descriptors, const std::vector<Point>& _pattern, const std::vector<int>& _angleOfs,
+			int _angleBins, int _dsize, int _wta_k) :
+			imagePyramid(_imagePyramid), layerInfo(_layerInfo), layerScale(_layerScale), keypoints(_keypoints),
+			descriptors(_descriptors), orbPattern(_pattern), angleOfs(_angleOfs), angleBins(_angleBins),
+			dsize(_dsize), wta_k(_wta_k)
+		{}
+
+		void operator()(const Range& range) const;
+
+	private:
+		const Mat& imagePyramid;
+		const std::vector<Rect>& layerInfo;
+		const std::vector<float>& layerScale;
+		const std::vector<KeyPoint>& keypoints;
+		Mat& descriptors;
+		const std::vector<Point>& orbPattern;
+		const std::vector<int>& angleOfs;
+		int angleBins;
+		int dsize;
+		int wta_k;
+	};
+
+	void OrbDescriptorsInvoker::operator()(const Range& range) const
 	{
 		int step = (int)imagePyramid.step;
-		int j, i, nkeypoints = (int)keypoints.size();
+		int npoints = (int)orbPattern.size();
+		int j, i;
+
+		AutoBuffer<int> ofsbuf(npoints);
+		AutoBuffer<uchar> valbuf(npoints);
 
-		for (j = 0; j < nkeypoints; j++)
+		for (j = range.start; j < range.end; j++)
 		{
 			const KeyPoint& kpt = keypoints[j];
 			const Rect& layer = layerInfo[kpt.octave];
 			float scale = 1.f / layerScale[kpt.octave];
-			float angle = kpt.angle;
-
-			angle *= (float)(CV_PI / 180.f);
-			float a = (float)cos(angle), b = (float)sin(angle);
 
 			const uchar* center = &imagePyramid.at<uchar>(cvRound(kpt.pt.y*scale) + layer.y,
 				cvRound(kpt.pt.x*scale) + layer.x);
-			float x, y;
-			int ix, iy;
-			const Point* pattern = &_pattern[0];
 			uchar* desc = descriptors.ptr<uchar>(j);
 
-#if 1
-#define GET_VALUE(idx) \
-               (x = pattern[idx].x*a - pattern[idx].y*b, \
-                y = pattern[idx].x*b + pattern[idx].y*a, \
-                ix = cvRound(x), \
-                iy = cvRound(y), \
-                *(center + iy*step + ix) )
-#else
-#define GET_VALUE(idx) \
-            (x = pattern[idx].x*a - pattern[idx].y*b, \
-            y = pattern[idx].x*b + pattern[idx].y*a, \
-            ix = cvFloor(x), iy = cvFloor(y), \
-            x -= ix, y -= iy, \
-            cvRound(center[iy*step + ix]*(1-x)*(1-y) + center[(iy+1)*step + ix]*(1-x)*y + \
-                    center[iy*step + ix+1]*x*(1-y) + center[(iy+1)*step + ix+1]*x*y))
-#endif
+			// the rotated pattern of the keypoint, from the table of its angle bin when the angles are quantized
+			const int* ofs = ofsbuf;
+			if (angleBins > 0)
+			{
+				int bin = cvRound(kpt.angle*angleBins / 360.f) % angleBins;
+				ofs = &angleOfs[(size_t)(bin < 0 ? bin + angleBins : bin)*npoints];
+			}
+			else
+			{
+				float angle = kpt.angle*(float)(CV_PI / 180.f);
+				rotatePatternOffsets(&orbPattern[0], npoints, (float)cos(angle), (float)sin(angle), step, ofsbuf);
+			}
+
+			// gather all the samples first, the comparisons then run on contiguous values
+			uchar* vals = valbuf;
+			for (i = 0; i < npoints; i++)
+				vals[i] = center[ofs[i]];
+
+#define GET_VALUE(idx) ((int)vals[idx])
 
 			if (wta_k == 2)
 			{
-				for (i = 0; i < dsize; ++i, pattern += 16)
+				i = 0;
+#if CV_SIMD128
+				// 16 pairs, i.e. 2 bytes of the descriptor, at a time
+				for (; i <= dsize - 2; i += 2, vals += 32)
+				{
+					v_uint8x16 t0, t1;
+					v_load_deinterleave(vals, t0, t1);
+					int mask = v_signmask(t0 < t1);
+					desc[i] = (uchar)mask;
+					desc[i + 1] = (uchar)(mask >> 8);
+				}
+#endif
+				for (; i < dsize; ++i, vals += 16)
 				{
 					int t0, t1, val;
 					t0 = GET_VALUE(0); t1 = GET_VALUE(1);
@@ -244,7 +359,7 @@ namespace cv
 			}
 			else if (wta_k == 3)
 			{
-				for (i = 0; i < dsize; ++i, pattern += 12)
+				for (i = 0; i < dsize; ++i, vals += 12)
 				{
 					int t0, t1, t2, val;
 					t0 = GET_VALUE(0); t1 = GET_VALUE(1); t2 = GET_VALUE(2);
@@ -264,7 +379,7 @@ namespace cv
 			}
 			else if (wta_k == 4)
 			{
-				for (i = 0; i < dsize; ++i, pattern += 16)
+				for (i = 0; i < dsize; ++i, vals += 16)
 				{
 					int t0, t1, t2, t3, u, v, k, val;
 					t0 = GET_VALUE(0); t1 = GET_VALUE(1);
@@ -308,6 +423,30 @@ namespace cv
 		}
 	}
 
+	static void
+		computeOrbDescriptors(const Mat& imagePyramid, const std::vector<Rect>& layerInfo,
+			const std::vector<float>& layerScale, std::vector<KeyPoint>& keypoints,
+			Mat& descriptors, const std::vector<Point>& _pattern, int dsize, int wta_k, int angleBins)
+	{
+		// the pattern rotated to the center of every angle bin
+		std::vector<int> angleOfs;
+		if (angleBins > 0)
+		{
+			int npoints = (int)_pattern.size();
+			int step = (int)imagePyramid.step;
+			angleOfs.resize((size_t)angleBins*npoints);
+			for (int bin = 0; bin < angleBins; bin++)
+			{
+				float angle = (float)(bin*2 * CV_PI / angleBins);
+				rotatePatternOffsets(&_pattern[0], npoints, (float)cos(angle), (float)sin(angle), step,
+					&angleOfs[(size_t)bin*npoints]);
+			}
+		}
+
+		parallel_for_(Range(0, (int)keypoints.size()), OrbDescriptorsInvoker(imagePyramid, layerInfo, layerScale,
+			keypoints, descriptors, _pattern, angleOfs, angleBins, dsize, wta_k), keypointStripes(keypoints.size()));
+	}
+
 
 	static void initializeOrbPattern(const Point* pattern0, std::vector<Point>& pattern, int ntuples, int tupleSize, int poolSize)
 	{
@@ -622,7 +761,7 @@ namespace cv
 			int _firstLevel, int _WTA_K, int _scoreType, int _patchSize, int _fastThreshold) :
 			nfeatures(_nfeatures), scaleFactor(_scaleFactor), nlevels(_nlevels),
 			edgeThreshold(_edgeThreshold), firstLevel(_firstLevel), wta_k(_WTA_K),
-			scoreType(_scoreType), patchSize(_patchSize), fastThreshold(_fastThreshold)
+			scoreType(_scoreType), patchSize(_patchSize), fastThreshold(_fastThreshold), angleBins(0)
 		{}
 
 		void setMaxFeatures(int maxFeatures) { nfeatures = maxFeatures; }
@@ -652,6 +791,9 @@ namespace cv
 		void setFastThreshold(int fastThreshold_) { fastThreshold = fastThreshold_; }
 		int getFastThreshold() const { return fastThreshold; }
 
+		void setAngleBins(int angleBins_) { CV_Assert(angleBins_ >= 0); angleBins = angleBins_; }
+		int getAngleBins() const { return angleBins; }
+
 		// returns the descriptor size in bytes
 		int descriptorSize() const;
 		// returns the descriptor type
@@ -674,6 +816,7 @@ namespace cv
 		int scoreType;
 		int patchSize;
 		int fastThreshold;
+		int angleBins;
 	};
 
 	int ORB_Impl::descriptorSize() const
@@ -726,6 +869,62 @@ namespace cv
 	}
 #endif
 
+	// FAST detection and preselection of the keypoints of every pyramid level
+	class DetectLevelKeypointsInvoker : public ParallelLoopBody
+	{
+	public:
+		DetectLevelKeypointsInvoker(const Mat& _imagePyramid, const Mat& _maskPyramid,
+			const std::vector<Rect>& _layerInfo, const std::vector<float>& _layerScale,
+			const std::vector<int>& _nfeaturesPerLevel, int _edgeThreshold, int _patchSize,
+			int _scoreType, int _fastThreshold, std::vector<std::vector<KeyPoint> >& _levelKeypoints) :
+			imagePyramid(_imagePyramid), maskPyramid(_maskPyramid), layerInfo(_layerInfo), layerScale(_layerScale),
+			nfeaturesPerLevel(_nfeaturesPerLevel), edgeThreshold(_edgeThreshold), patchSize(_patchSize),
+			scoreType(_scoreType), fastThreshold(_fastThreshold), levelKeypoints(_levelKeypoints)
+		{}
+
+		void operator()(const Range& range) const
+		{
+			for (int level = range.start; level < range.end; level++)
+			{
+				std::vector<KeyPoint>& keypoints = levelKeypoints[level];
+				int featuresNum = nfeaturesPerLevel[level];
+				Mat img = imagePyramid(layerInfo[level]);
+				Mat mask = maskPyramid.empty() ? Mat() : maskPyramid(layerInfo[level]);
+
+				// Detect FAST features, 20 is a good threshold
+				{
+					Ptr<FastFeatureDetector> fd = FastFeatureDetector::create(fastThreshold, true);
+					fd->detect(img, keypoints, mask);
+				}
+
+				// Remove keypoints very close to the border
+				KeyPointsFilter::runByImageBorder(keypoints, img.size(), edgeThreshold);
+
+				// Keep more points than necessary as FAST does not give amazing corners
+				KeyPointsFilter::retainBest(keypoints, scoreType == ORB_Impl::HARRIS_SCORE ? 2 * featuresNum : featuresNum);
+
+				float sf = layerScale[level];
+				for (size_t i = 0; i < keypoints.size(); i++)
+				{
+					keypoints[i].octave = level;
+					keypoints[i].size = patchSize * sf;
+				}
+			}
+		}
+
+	private:
+		const Mat& imagePyramid;
+		const Mat& maskPyramid;
+		const std::vector<Rect>& layerInfo;
+		const std::vector<float>& layerScale;
+		const std::vector<int>& nfeaturesPerLevel;
+		int edgeThreshold;
+		int patchSize;
+		int scoreType;
+		int fastThreshold;
+		std::vector<std::vector<KeyPoint> >& levelKeypoints;
+	};
+
 	/** Compute the ORB_Impl keypoints on an image
 	* @param image_pyramid the image pyramid to compute the features and descriptors on
 	* @param mask_pyramid the masks to apply at every level
@@ -786,37 +985,16 @@ namespace cv
 		allKeypoints.clear();
 		std::vector<KeyPoint> keypoints;
 		std::vector<int> counters(nlevels);
-		keypoints.reserve(nfeaturesPerLevel[0] * 2);
+		std::vector<std::vector<KeyPoint> > levelKeypoints(nlevels);
+
+		// the levels are detected in parallel and concatenated in order
+		parallel_for_(Range(0, nlevels), DetectLevelKeypointsInvoker(imagePyramid, maskPyramid, layerInfo,
+			layerScale, nfeaturesPerLevel, edgeThreshold, patchSize, scoreType, fastThreshold, levelKeypoints), nlevels);
 
 		for (level = 0; level < nlevels; level++)
 		{
-			int featuresNum = nfeaturesPerLevel[level];
-			Mat img = imagePyramid(layerInfo[level]);
-			Mat mask = maskPyramid.empty() ? Mat() : maskPyramid(layerInfo[level]);
-
-			// Detect FAST features, 20 is a good threshold
-			{
-				Ptr<FastFeatureDetector> fd = FastFeatureDetector::create(fastThreshold, true);
-				fd->detect(img, keypoints, mask);
-			}
-
-			// Remove keypoints very close to the border
-			KeyPointsFilter::runByImageBorder(keypoints, img.size(), edgeThreshold);
-
-			// Keep more points than necessary as FAST does not give amazing corners
-			KeyPointsFilter::retainBest(keypoints, scoreType == ORB_Impl::HARRIS_SCORE ? 2 * featuresNum : featuresNum);
-
-			nkeypoints = (int)keypoints.size();
-			counters[level] = nkeypoints;
-
-			float sf = layerScale[level];
-			for (i = 0; i < nkeypoints; i++)
-			{
-				keypoints[i].octave = level;
-				keypoints[i].size = patchSize * sf;
-			}
-
-			std::copy(keypoints.begin(), keypoints.end(), std::back_inserter(allKeypoints));
+			counters[level] = (int)levelKeypoints[level].size();
+			std::copy(levelKeypoints[level].begin(), levelKeypoints[level].end(), std::back_inserter(allKeypoints));
 		}
 
 		std::vector<Vec3i> ukeypoints_buf;
@@ -909,6 +1087,30 @@ namespace cv
 	}
 
 
+	class SmoothLevelsInvoker : public ParallelLoopBody
+	{
+	public:
+		SmoothLevelsInvoker(Mat& _imagePyramid, const std::vector<Rect>& _layerInfo) :
+			imagePyramid(_imagePyramid), layerInfo(_layerInfo)
+		{}
+
+		void operator()(const Range& range) const
+		{
+			for (int level = range.start; level < range.end; level++)
+			{
+				// preprocess the resized image
+				Mat workingMat = imagePyramid(layerInfo[level]);
+
+				//boxFilter(working_mat, working_mat, working_mat.depth(), Size(5,5), Point(-1,-1), true, BORDER_REFLECT_101);
+				GaussianBlur(workingMat, workingMat, Size(7, 7), 2, 2, BORDER_REFLECT_101);
+			}
+		}
+
+	private:
+		Mat& imagePyramid;
+		const std::vector<Rect>& layerInfo;
+	};
+
 	/** Compute the ORB_Impl features and descriptors on an image
 	* @param img the image to compute the features and descriptors on
 	* @param mask the mask to apply
@@ -1120,14 +1322,8 @@ namespace cv
 				initializeOrbPattern(pattern0, pattern, ntuples, wta_k, npoints);
 			}
 
-			for (level = 0; level < nLevels; level++)
-			{
-				// preprocess the resized image
-				Mat workingMat = imagePyramid(layerInfo[level]);
-
-				//boxFilter(working_mat, working_mat, working_mat.depth(), Size(5,5), Point(-1,-1), true, BORDER_REFLECT_101);
-				GaussianBlur(workingMat, workingMat, Size(7, 7), 2, 2, BORDER_REFLECT_101);
-			}
+			// the levels are separated by their borders, so they are smoothed in parallel
+			parallel_for_(Range(0, nLevels), SmoothLevelsInvoker(imagePyramid, layerInfo), nLevels);
 
 #ifdef HAVE_OPENCL
 			if (useOCL)
@@ -1153,7 +1349,7 @@ namespace cv
 			{
 				Mat descriptors = _descriptors.getMat();
 				computeOrbDescriptors(imagePyramid, layerInfo, layerScale,
-					keypoints, descriptors, pattern, dsize, wta_k);
+					keypoints, descriptors, pattern, dsize, wta_k, angleBins);
 			}
 		}
 	}
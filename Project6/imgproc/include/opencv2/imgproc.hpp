@@ -1738,6 +1738,76 @@ namespace cv
 		InputArray mask, int blockSize,
 		int gradientSize, bool useHarrisDetector = false,
 		double k = 0.04);
+
+	/** @brief Determines strong corners in the parts of an image not covered by already tracked corners.
+
+	The function is an incremental version of goodFeaturesToTrack for the trackers that replenish the
+	lost tracks every few frames. The image is divided into cells of minDistance/2 pixels,
+	and the corner quality measure is computed only in the cells that have pixels farther than
+	minDistance from all of existingCorners, so when most of the image is covered by the tracks, only a
+	small part of it is examined. The selection then follows goodFeaturesToTrack, with existingCorners
+	taking part in the minDistance check: the returned corners are at least minDistance away from
+	existingCorners and from each other. Without existing corners the function returns the same corners
+	as goodFeaturesToTrack.
+
+	@param image Input 8-bit or floating-point 32-bit, single-channel image.
+	@param existingCorners Already tracked corners, a vector of 2D points (vector<Point2f> or a
+	2-channel matrix). The points outside the image are ignored.
+	@param corners Output vector of the new corners, existingCorners are not included.
+	@param maxCorners Maximum number of new corners to return. `maxCorners <= 0` implies that no limit
+	on the maximum is set.
+	@param qualityLevel Parameter characterizing the minimal accepted quality of image corners. Unlike
+	goodFeaturesToTrack, the parameter value is multiplied by the best corner quality measure in the
+	examined cells, not in the whole image.
+	@param minDistance Minimum possible Euclidean distance between the returned corners and between
+	them and existingCorners.
+	@param mask Optional region of interest, see goodFeaturesToTrack.
+	@param blockSize Size of an average block for computing a derivative covariation matrix over each
+	pixel neighborhood. See cornerEigenValsAndVecs .
+	@param gradientSize Aperture parameter for the Sobel operator.
+	@param useHarrisDetector Parameter indicating whether to use a Harris detector (see #cornerHarris)
+	or #cornerMinEigenVal.
+	@param k Free parameter of the Harris detector.
+
+	@sa goodFeaturesToTrack, calcOpticalFlowPyrLK
+	*/
+	CV_EXPORTS_W void goodFeaturesToTrackIncremental(InputArray image, InputArray existingCorners,
+		OutputArray corners, int maxCorners, double qualityLevel, double minDistance,
+		InputArray mask = noArray(), int blockSize = 3, int gradientSize = 3,
+		bool useHarrisDetector = false, double k = 0.04);
+
+	/** @brief Determines strong corners in the cells of a grid.
+
+	goodFeaturesToTrack returns the globally strongest corners, which cluster in the textured parts of
+	the image. This function divides the image into gridSize.width x gridSize.height cells, computes
+	the corner quality measure of the cells in parallel and selects up to maxPerCell corners in every
+	cell, so the corners are spread uniformly over the image. The quality threshold of a cell is
+	qualityLevel times the best corner quality measure in the cell, so the low-contrast cells get their
+	corners too. The cells are selected one by one in the row-major order, and all the returned corners
+	are at least minDistance apart.
+
+	@param image Input 8-bit or floating-point 32-bit, single-channel image.
+	@param corners Output vector of detected corners, grouped by the cells.
+	@param gridSize Number of the cells along the x and y axes.
+	@param maxPerCell Maximum number of corners in a cell. `maxPerCell <= 0` implies that no limit on
+	the maximum is set.
+	@param qualityLevel Parameter characterizing the minimal accepted quality of image corners,
+	relative to the best corner of the cell. See goodFeaturesToTrack.
+	@param minDistance Minimum possible Euclidean distance between the returned corners.
+	@param mask Optional region of interest, see goodFeaturesToTrack.
+	@param blockSize Size of an average block for computing a derivative covariation matrix over each
+	pixel neighborhood. See cornerEigenValsAndVecs .
+	@param gradientSize Aperture parameter for the Sobel operator.
+	@param useHarrisDetector Parameter indicating whether to use a Harris detector (see #cornerHarris)
+	or #cornerMinEigenVal.
+	@param k Free parameter of the Harris detector.
+
+	@sa goodFeaturesToTrack
+	*/
+	CV_EXPORTS_W void goodFeaturesToTrackGrid(InputArray image, OutputArray corners, Size gridSize,
+		int maxPerCell, double qualityLevel, double minDistance,
+		InputArray mask = noArray(), int blockSize = 3, int gradientSize = 3,
+		bool useHarrisDetector = false, double k = 0.04);
 	/** @example houghlines.cpp
 	An example using the Hough line detector
 	![Sample input image](Hough_Lines_Tutorial_Original_Image.jpg) ![Output image](Hough_Lines_Tutorial_Result.jpg)
@@ -3576,6 +3646,49 @@ namespace cv
 	CV_EXPORTS_W void matchTemplate(InputArray image, InputArray templ,
 		OutputArray result, int method, InputArray mask = noArray());
 
+	/** @brief Matches a fixed set of templates against many images.
+
+	The class computes the same maps as #matchTemplate , but the template spectra and statistics are
+	computed once and cached between calls, and the spectrum of every image block is computed once
+	and shared by all the templates. The blocks are processed in parallel.
+
+	The cached spectra depend on the image size, so they are rebuilt only when the image size changes.
+	*/
+	class CV_EXPORTS_W TemplateMatcher : public Algorithm
+	{
+	public:
+		/** @brief Adds templates to the set.
+
+		@param templs A template or a vector of templates of the same type as the images that will be
+		searched (8-bit or 32-bit floating-point). The templates may have different sizes.
+		*/
+		CV_WRAP virtual void add(InputArrayOfArrays templs) = 0;
+
+		/** @brief Compares all the templates against the image.
+
+		@param image Image where the search is running. It must not be smaller than any template.
+		@param results Vector of the comparison maps, one for each template in the order they were
+		added, see #matchTemplate .
+		*/
+		CV_WRAP virtual void match(InputArray image, OutputArrayOfArrays results) = 0;
+
+		//! Returns the number of templates in the set.
+		CV_WRAP virtual int getTemplatesCount() const = 0;
+
+		/** @brief Sets the comparison method.
+
+		@param method Comparison method, see #TemplateMatchModes
+		*/
+		CV_WRAP virtual void setMethod(int method) = 0;
+		CV_WRAP virtual int getMethod() const = 0;
+	};
+
+	/** @brief Creates implementation for cv::TemplateMatcher .
+
+	@param method Comparison method, see #TemplateMatchModes
+	*/
+	CV_EXPORTS_W Ptr<TemplateMatcher> createTemplateMatcher(int method = TM_CCOEFF_NORMED);
+
 	//! @}
 
 	//! @addtogroup imgproc_shape
@@ -199,99 +199,225 @@ namespace cv
 	enum { MINEIGENVAL = 0, HARRIS = 1, EIGENVALSVECS = 2 };
 
 
-	static void
-		cornerEigenValsVecs(const Mat& src, Mat& eigenv, int block_size,
-			int aperture_size, int op_type, double k = 0.,
-			int borderType = BORDER_DEFAULT)
+	static void calcCovRow(const float* dxdata, const float* dydata, float* cov_data, int width)
 	{
-#ifdef HAVE_TEGRA_OPTIMIZATION
-		if (tegra::useTegra() && tegra::cornerEigenValsVecs(src, eigenv, block_size, aperture_size, op_type, k, borderType))
-			return;
-#endif
 #if CV_TRY_AVX
 		bool haveAvx = CV_CPU_HAS_SUPPORT_AVX;
 #endif
 #if CV_SIMD128
 		bool haveSimd = hasSIMD128();
 #endif
+		int j;
 
-		int depth = src.depth();
-		double scale = (double)(1 << ((aperture_size > 0 ? aperture_size : 3) - 1)) * block_size;
-		if (aperture_size < 0)
-			scale *= 2.0;
-		if (depth == CV_8U)
-			scale *= 255.0;
-		scale = 1.0 / scale;
-
-		CV_Assert(src.type() == CV_8UC1 || src.type() == CV_32FC1);
+#if CV_TRY_AVX
+		if (haveAvx)
+			j = cornerEigenValsVecsLine_AVX(dxdata, dydata, cov_data, width);
+		else
+#endif // CV_TRY_AVX
+			j = 0;
 
-		Mat Dx, Dy;
-		if (aperture_size > 0)
+#if CV_SIMD128
+		if (haveSimd)
 		{
-			Sobel(src, Dx, CV_32F, 1, 0, aperture_size, scale, 0, borderType);
-			Sobel(src, Dy, CV_32F, 0, 1, aperture_size, scale, 0, borderType);
+			for (; j <= width - v_float32x4::nlanes; j += v_float32x4::nlanes)
+			{
+				v_float32x4 v_dx = v_load(dxdata + j);
+				v_float32x4 v_dy = v_load(dydata + j);
+
+				v_float32x4 v_dst0, v_dst1, v_dst2;
+				v_dst0 = v_dx * v_dx;
+				v_dst1 = v_dx * v_dy;
+				v_dst2 = v_dy * v_dy;
+
+				v_store_interleave(cov_data + j * 3, v_dst0, v_dst1, v_dst2);
+			}
 		}
-		else
+#endif // CV_SIMD128
+
+		for (; j < width; j++)
 		{
-			Scharr(src, Dx, CV_32F, 1, 0, scale, 0, borderType);
-			Scharr(src, Dy, CV_32F, 0, 1, scale, 0, borderType);
+			float dx = dxdata[j];
+			float dy = dydata[j];
+
+			cov_data[j * 3] = dx * dx;
+			cov_data[j * 3 + 1] = dx * dy;
+			cov_data[j * 3 + 2] = dy * dy;
 		}
+	}
 
-		Size size = src.size();
-		Mat cov(size, CV_32FC3);
-		int i, j;
+	// the output rows of a stripe are computed in chunks of the input rows: the derivative and the
+	// box filter engines keep the rows they still need in their ring buffers, so only a few rows of
+	// Dx, Dy and the covariance are alive at a time instead of the full-size float images
+	class CornerEigenValsVecsInvoker : public ParallelLoopBody
+	{
+	public:
+		CornerEigenValsVecsInvoker(const Mat& _src, Mat& _eigenv, const Mat* _kx, const Mat* _ky,
+			int _block_size, int _op_type, double _k, int _borderType, int _stripeRows) :
+			src(_src), eigenv(_eigenv), kx(_kx), ky(_ky), block_size(_block_size), op_type(_op_type),
+			k(_k), borderType(_borderType), stripeRows(_stripeRows)
+		{
+		}
 
-		for (i = 0; i < size.height; i++)
+		void operator()(const Range& range) const
 		{
-			float* cov_data = cov.ptr<float>(i);
-			const float* dxdata = Dx.ptr<float>(i);
-			const float* dydata = Dy.ptr<float>(i);
+			const int CHUNK_ROWS = 16;
+			int width = src.cols, height = src.rows;
+			int border = borderType & ~BORDER_ISOLATED;
+
+			Ptr<FilterEngine> fx = createSeparableLinearFilter(src.type(), CV_32F, kx[0], ky[0],
+				Point(-1, -1), 0, border);
+			Ptr<FilterEngine> fy = createSeparableLinearFilter(src.type(), CV_32F, kx[1], ky[1],
+				Point(-1, -1), 0, border);
+			Ptr<FilterEngine> fbox = createBoxFilter(CV_32FC3, CV_32FC3, Size(block_size, block_size),
+				Point(-1, -1), false, border);
+
+			// the derivative engines return up to kernel size - 1 more rows than they get at the end
+			// of the stripe, and so does the box filter
+			int derivRows = CHUNK_ROWS + fx->ksize.height, boxRows = derivRows + block_size;
+			Mat Dx(derivRows, width, CV_32F), Dy(derivRows, width, CV_32F);
+			Mat cov(derivRows, width, CV_32FC3), sum(boxRows, width, CV_32FC3);
+
+			Size wsz(width, height);
+			Point ofs;
+			if (!(borderType & BORDER_ISOLATED))
+				src.locateROI(wsz, ofs);
+
+			for (int stripe = range.start; stripe < range.end; stripe++)
+			{
+				int y0 = stripe * stripeRows, y1 = std::min(y0 + stripeRows, height);
 
-#if CV_TRY_AVX
-			if (haveAvx)
-				j = cornerEigenValsVecsLine_AVX(dxdata, dydata, cov_data, size.width);
-			else
-#endif // CV_TRY_AVX
-				j = 0;
+				// the covariance rows the box filter needs for the stripe
+				int c0 = fbox->start(Size(width, height), Size(width, y1 - y0), Point(0, y0));
+				int c1 = c0 + fbox->remainingInputRows();
 
-#if CV_SIMD128
-			if (haveSimd)
-			{
-				for (; j <= size.width - v_float32x4::nlanes; j += v_float32x4::nlanes)
+				int sy = fx->start(wsz, Size(width, c1 - c0), Point(ofs.x, ofs.y + c0)) - ofs.y;
+				fy->start(wsz, Size(width, c1 - c0), Point(ofs.x, ofs.y + c0));
+				const uchar* sptr = src.data + (ptrdiff_t)sy*src.step;
+				int dstY = y0;
+
+				while (fx->remainingInputRows() > 0)
 				{
-					v_float32x4 v_dx = v_load(dxdata + j);
-					v_float32x4 v_dy = v_load(dydata + j);
+					int n = std::min(CHUNK_ROWS, fx->remainingInputRows());
+					int dn = fx->proceed(sptr, (int)src.step, n, Dx.ptr(), (int)Dx.step);
+					fy->proceed(sptr, (int)src.step, n, Dy.ptr(), (int)Dy.step);
+					sptr += (ptrdiff_t)n*src.step;
 
-					v_float32x4 v_dst0, v_dst1, v_dst2;
-					v_dst0 = v_dx * v_dx;
-					v_dst1 = v_dx * v_dy;
-					v_dst2 = v_dy * v_dy;
+					if (dn == 0)
+						continue;
 
-					v_store_interleave(cov_data + j * 3, v_dst0, v_dst1, v_dst2);
+					for (int i = 0; i < dn; i++)
+						calcCovRow(Dx.ptr<float>(i), Dy.ptr<float>(i), cov.ptr<float>(i), width);
+
+					int sn = fbox->proceed(cov.ptr(), (int)cov.step, dn, sum.ptr(), (int)sum.step);
+					if (sn == 0)
+						continue;
+
+					calcRows(sum, dstY, sn);
+					dstY += sn;
 				}
+				CV_Assert(dstY == y1);
 			}
-#endif // CV_SIMD128
+		}
 
-			for (; j < size.width; j++)
+	private:
+		void calcOp(const Mat& _cov, Mat _dst) const
+		{
+			if (op_type == MINEIGENVAL)
+				calcMinEigenVal(_cov, _dst);
+			else if (op_type == HARRIS)
+				calcHarris(_cov, _dst, k);
+			else if (op_type == EIGENVALSVECS)
+				calcEigenValsVecs(_cov, _dst);
+		}
+
+		// computes the output rows [dstY, dstY + n) from the first n rows of cov. The calc* functions
+		// handle continuous data as one line and use the scalar code for the last pixels of the line,
+		// which rounds differently; applied to the whole image, it covered only the last width*height%4
+		// pixels, so the pixels before them are passed in multiples of 4 here, the rest of a chunk
+		// going once more as its last 4 pixels
+		void calcRows(const Mat& cov, int dstY, int n) const
+		{
+			Mat _dst = eigenv.rowRange(dstY, dstY + n);
+			if (!eigenv.isContinuous())
 			{
-				float dx = dxdata[j];
-				float dy = dydata[j];
+				calcOp(cov.rowRange(0, n), _dst);
+				return;
+			}
+
+			int width = eigenv.cols, total = width * n;
+			int vecEnd = std::min(eigenv.rows*width / 4 * 4 - dstY * width, total);
+			Mat cov1 = cov.rowRange(0, n).reshape(0, 1), dst1 = _dst.reshape(0, 1);
 
-				cov_data[j * 3] = dx * dx;
-				cov_data[j * 3 + 1] = dx * dy;
-				cov_data[j * 3 + 2] = dy * dy;
+			if (vecEnd >= 4)
+			{
+				calcOp(cov1.colRange(0, vecEnd), dst1.colRange(0, vecEnd));
+				if (vecEnd % 4 != 0)
+					calcOp(cov1.colRange(vecEnd - 4, vecEnd), dst1.colRange(vecEnd - 4, vecEnd));
 			}
+			else
+				vecEnd = 0;
+			if (vecEnd < total)
+				calcOp(cov1.colRange(vecEnd, total), dst1.colRange(vecEnd, total));
+		}
+
+		const Mat& src;
+		Mat& eigenv;
+		const Mat* kx;
+		const Mat* ky;
+		int block_size;
+		int op_type;
+		double k;
+		int borderType;
+		int stripeRows;
+	};
+
+
+	static void
+		cornerEigenValsVecs(const Mat& src, Mat& eigenv, int block_size,
+			int aperture_size, int op_type, double k = 0.,
+			int borderType = BORDER_DEFAULT)
+	{
+#ifdef HAVE_TEGRA_OPTIMIZATION
+		if (tegra::useTegra() && tegra::cornerEigenValsVecs(src, eigenv, block_size, aperture_size, op_type, k, borderType))
+			return;
+#endif
+
+		int depth = src.depth();
+		double scale = (double)(1 << ((aperture_size > 0 ? aperture_size : 3) - 1)) * block_size;
+		if (aperture_size < 0)
+			scale *= 2.0;
+		if (depth == CV_8U)
+			scale *= 255.0;
+		scale = 1.0 / scale;
+
+		CV_Assert(src.type() == CV_8UC1 || src.type() == CV_32FC1);
+
+		// the kernels of Sobel/Scharr, with the scale applied to the smoothing part as they do
+		Mat kx[2], ky[2];
+		getDerivKernels(kx[0], ky[0], 1, 0, aperture_size, false, CV_32F);
+		getDerivKernels(kx[1], ky[1], 0, 1, aperture_size, false, CV_32F);
+		ky[0] *= scale;
+		kx[1] *= scale;
+
+		// aperture_size == 1 gives 1x3 and 3x1 kernels; both derivatives are streamed together,
+		// so the smoothing kernel of 1 is padded with zeros to get the same number of rows out
+		if (ky[0].total() != ky[1].total())
+		{
+			Mat& k1 = ky[0].total() < ky[1].total() ? ky[0] : ky[1];
+			Mat& k2 = kx[0].total() < kx[1].total() ? kx[0] : kx[1];
+			copyMakeBorder(k1, k1, 1, 1, 0, 0, BORDER_CONSTANT, Scalar::all(0));
+			copyMakeBorder(k2, k2, 1, 1, 0, 0, BORDER_CONSTANT, Scalar::all(0));
 		}
 
-		boxFilter(cov, cov, cov.depth(), Size(block_size, block_size),
-			Point(-1, -1), false, borderType);
+		// the stripes do not depend on the number of threads, so neither does the result. The box filter
+		// restarts its running column sums at every stripe, which may change the last bit of a few
+		// outputs compared to filtering the whole image at once
+		int stripeRows = 128;
+		int nstripes = std::max(src.rows / stripeRows, 1);
+		stripeRows = (src.rows + nstripes - 1) / nstripes;
 
-		if (op_type == MINEIGENVAL)
-			calcMinEigenVal(cov, eigenv);
-		else if (op_type == HARRIS)
-			calcHarris(cov, eigenv, k);
-		else if (op_type == EIGENVALSVECS)
-			calcEigenValsVecs(cov, eigenv);
+		parallel_for_(Range(0, nstripes), CornerEigenValsVecsInvoker(src, eigenv, kx, ky, block_size,
+			op_type, k, borderType, stripeRows), nstripes);
 	}
 
 #ifdef HAVE_OPENCL
@@ -1,4 +1,220 @@
 #include "precomp.hpp"
+#include "../../core/include/opencv2/core/hal/intrin.hpp"
+
+namespace cv
+{
+
+	// samples a row of a 32f patch from the two image rows around it with the bilinear weights,
+	// summing in the same order as getRectSubPix
+	static void sampleSubPixRow(const float* src0, const float* src1, float* dst, int width,
+		float a11, float a12, float a21, float a22)
+	{
+		int j = 0;
+#if CV_SIMD128
+		v_float32x4 va11 = v_setall_f32(a11), va12 = v_setall_f32(a12);
+		v_float32x4 va21 = v_setall_f32(a21), va22 = v_setall_f32(a22);
+		for (; j <= width - 4; j += 4)
+		{
+			v_float32x4 s = v_load(src0 + j) * va11 + v_load(src0 + j + 1) * va12 +
+				v_load(src1 + j) * va21 + v_load(src1 + j + 1) * va22;
+			v_store(dst + j, s);
+		}
+#endif
+		for (; j < width; j++)
+			dst[j] = src0[j] * a11 + src0[j + 1] * a12 + src1[j] * a21 + src1[j + 1] * a22;
+	}
+
+	// the 8u version follows getRectSubPix_8u32f, which shares the products of every source
+	// column between the two patch pixels it contributes to; the weights are the ones set up there
+	static void sampleSubPixRow(const uchar* src0, const uchar* src1, float* dst, int width,
+		float a, float a12, float a22, float b1, float b2, double s)
+	{
+		float prev = (1 - a)*(b1*src0[0] + b2 * src1[0]);
+		for (int j = 0; j < width; j++)
+		{
+			float t = a12 * src0[j + 1] + a22 * src1[j + 1];
+			dst[j] = prev + t;
+			prev = (float)(t*s);
+		}
+	}
+
+	// bilinear weights of the patch whose top-left corner is at the fractional offset (ax, ay)
+	struct SubPixWeights
+	{
+		void set(const float*, float ax, float ay)
+		{
+			a11 = (1.f - ax)*(1.f - ay); a12 = ax * (1.f - ay);
+			a21 = (1.f - ax)*ay; a22 = ax * ay;
+		}
+		void set(const uchar*, float ax, float ay)
+		{
+			a = MAX(ax, 0.0001f);
+			a12 = a * (1.f - ay); a22 = a * ay;
+			b1 = 1.f - ay; b2 = ay;
+			s = (1. - a) / a;
+		}
+		void sample(const float* src0, const float* src1, float* dst, int width) const
+		{
+			sampleSubPixRow(src0, src1, dst, width, a11, a12, a21, a22);
+		}
+		void sample(const uchar* src0, const uchar* src1, float* dst, int width) const
+		{
+			sampleSubPixRow(src0, src1, dst, width, a, a12, a22, b1, b2, s);
+		}
+
+		float a, a11, a12, a21, a22, b1, b2;
+		double s;
+	};
+
+	// accumulates the weighted gradient moments of a row of the window; cur points to the patch
+	// pixel to the left of the window, prev and next to the pixels above and below the window row.
+	// acc is {a, b, c, bb1, bb2} of the linear system of cornerSubPix. The moments are summed in double,
+	// since the system may be ill-conditioned
+	static void accumulateSubPixRow(const float* prev, const float* cur, const float* next,
+		const float* mask, int win_w, float px0, float py, double* acc)
+	{
+		int j = 0;
+#if CV_SIMD128_64F
+		v_float64x2 va = v_setzero_f64(), vb = v_setzero_f64(), vc = v_setzero_f64();
+		v_float64x2 vbb1 = v_setzero_f64(), vbb2 = v_setzero_f64();
+		v_float64x2 vpx = v_float64x2(px0, px0 + 1), vpy = v_setall_f64(py), v2 = v_setall_f64(2.);
+		for (; j <= win_w - 2; j += 2, vpx += v2)
+		{
+			v_float32x4 m4 = v_load(mask + j);
+			v_float32x4 tgx4 = v_load(cur + j + 2) - v_load(cur + j);
+			v_float32x4 tgy4 = v_load(next + j + 1) - v_load(prev + j + 1);
+			v_float64x2 m = v_cvt_f64(m4), tgx = v_cvt_f64(tgx4), tgy = v_cvt_f64(tgy4);
+			v_float64x2 gxx = tgx * tgx * m, gxy = tgx * tgy * m, gyy = tgy * tgy * m;
+			va += gxx; vb += gxy; vc += gyy;
+			vbb1 += gxx * vpx + gxy * vpy;
+			vbb2 += gxy * vpx + gyy * vpy;
+		}
+		acc[0] += v_reduce_sum(va); acc[1] += v_reduce_sum(vb); acc[2] += v_reduce_sum(vc);
+		acc[3] += v_reduce_sum(vbb1); acc[4] += v_reduce_sum(vbb2);
+#endif
+		for (; j < win_w; j++)
+		{
+			double m = mask[j];
+			double tgx = cur[j + 2] - cur[j];
+			double tgy = next[j + 1] - prev[j + 1];
+			double gxx = tgx * tgx * m;
+			double gxy = tgx * tgy * m;
+			double gyy = tgy * tgy * m;
+			double px = px0 + j;
+			acc[0] += gxx; acc[1] += gxy; acc[2] += gyy;
+			acc[3] += gxx * px + gxy * py;
+			acc[4] += gxy * px + gyy * py;
+		}
+	}
+
+	// refines the corners independently; every range reuses one patch buffer, and when the patch
+	// is inside the image its rows are sampled directly from the image right before their
+	// gradients are accumulated
+	class CornerSubPixInvoker : public ParallelLoopBody
+	{
+	public:
+		CornerSubPixInvoker(const Mat& _src, Point2f* _corners, const Mat& _mask, Size _win,
+			int _maxIters, double _eps) :
+			src(_src), corners(_corners), mask(_mask), win(_win), maxIters(_maxIters), eps(_eps)
+		{
+		}
+
+		void operator()(const Range& range) const
+		{
+			if (src.depth() == CV_8U)
+				refine<uchar>(range);
+			else if (src.depth() == CV_32F)
+				refine<float>(range);
+			else
+				CV_Error(CV_StsUnsupportedFormat, "Unsupported image format");
+		}
+
+	private:
+		template<typename T> void refine(const Range& range) const
+		{
+			int win_w = win.width * 2 + 1, win_h = win.height * 2 + 1;
+			int patch_w = win_w + 2, patch_h = win_h + 2;
+			AutoBuffer<float> _buf(patch_w*patch_h);
+			Mat subpix_buf(patch_h, patch_w, CV_32F, (float*)_buf);
+			float* patch = subpix_buf.ptr<float>();
+			const float* maskp = mask.ptr<float>();
+			size_t step = src.step / sizeof(T);
+
+			for (int pt_i = range.start; pt_i < range.end; pt_i++)
+			{
+				Point2f cT = corners[pt_i], cI = cT;
+				int iter = 0;
+				double err = 0;
+
+				do
+				{
+					double acc[5] = { 0, 0, 0, 0, 0 };
+					float ox = cI.x - (patch_w - 1)*0.5f, oy = cI.y - (patch_h - 1)*0.5f;
+					int ix = cvFloor(ox), iy = cvFloor(oy);
+
+					if (0 <= ix && ix + patch_w < src.cols && 0 <= iy && iy + patch_h < src.rows)
+					{
+						const T* s = src.ptr<T>(iy) + ix;
+						SubPixWeights w;
+						w.set(s, ox - ix, oy - iy);
+
+						w.sample(s, s + step, patch, patch_w);
+						w.sample(s + step, s + step * 2, patch + patch_w, patch_w);
+						for (int i = 0; i < win_h; i++)
+						{
+							const T* s1 = s + step * (i + 2);
+							float* row = patch + patch_w * (i + 1);
+							w.sample(s1, s1 + step, row + patch_w, patch_w);
+							accumulateSubPixRow(row - patch_w, row, row + patch_w, maskp + i * win_w,
+								win_w, (float)-win.width, (float)(i - win.height), acc);
+						}
+					}
+					else
+					{
+						// the patch crosses the image border, which getRectSubPix replicates
+						getRectSubPix(src, subpix_buf.size(), cI, subpix_buf, CV_32F);
+						for (int i = 0; i < win_h; i++)
+						{
+							float* row = patch + patch_w * (i + 1);
+							accumulateSubPixRow(row - patch_w, row, row + patch_w, maskp + i * win_w,
+								win_w, (float)-win.width, (float)(i - win.height), acc);
+						}
+					}
+
+					double a = acc[0], b = acc[1], c = acc[2], bb1 = acc[3], bb2 = acc[4];
+					double det = a * c - b * b;
+					if (fabs(det) <= DBL_EPSILON * DBL_EPSILON)
+						break;
+
+					// 2x2 matrix inversion
+					double scale = 1.0 / det;
+					Point2f cI2;
+					cI2.x = (float)(cI.x + c * scale*bb1 - b * scale*bb2);
+					cI2.y = (float)(cI.y - b * scale*bb1 + a * scale*bb2);
+					err = (cI2.x - cI.x) * (cI2.x - cI.x) + (cI2.y - cI.y) * (cI2.y - cI.y);
+					cI = cI2;
+					if (cI.x < 0 || cI.x >= src.cols || cI.y < 0 || cI.y >= src.rows)
+						break;
+				} while (++iter < maxIters && err > eps);
+
+				// if new point is too far from initial, it means poor convergence.
+				// leave initial point as the result
+				if (fabs(cI.x - cT.x) > win.width || fabs(cI.y - cT.y) > win.height)
+					cI = cT;
+
+				corners[pt_i] = cI;
+			}
+		}
+
+		const Mat& src;
+		Point2f* corners;
+		const Mat& mask;
+		Size win;
+		int maxIters;
+		double eps;
+	};
+
+}
 
 void cv::cornerSubPix(InputArray _image, InputOutputArray _corners,
 	Size win, Size zeroZone, TermCriteria criteria)
@@ -7,7 +223,7 @@ void cv::cornerSubPix(InputArray _image, InputOutputArray _corners,
 
 	const int MAX_ITERS = 100;
 	int win_w = win.width * 2 + 1, win_h = win.height * 2 + 1;
-	int i, j, k;
+	int i, j;
 	int max_iters = (criteria.type & CV_TERMCRIT_ITER) ? MIN(MAX(criteria.maxCount, 1), MAX_ITERS) : MAX_ITERS;
 	double eps = (criteria.type & CV_TERMCRIT_EPS) ? MAX(criteria.epsilon, 0.) : 0;
 	eps *= eps; // use square of error in comparison operations
@@ -24,7 +240,7 @@ void cv::cornerSubPix(InputArray _image, InputOutputArray _corners,
 	CV_Assert(src.cols >= win.width * 2 + 5 && src.rows >= win.height * 2 + 5);
 	CV_Assert(src.channels() == 1);
 
-	Mat maskm(win_h, win_w, CV_32F), subpix_buf(win_h + 2, win_w + 2, CV_32F);
+	Mat maskm(win_h, win_w, CV_32F);
 	float* mask = maskm.ptr<float>();
 
 	for (i = 0; i < win_h; i++)
@@ -52,65 +268,7 @@ void cv::cornerSubPix(InputArray _image, InputOutputArray _corners,
 	}
 
 	// do optimization loop for all the points
-	for (int pt_i = 0; pt_i < count; pt_i++)
-	{
-		Point2f cT = corners[pt_i], cI = cT;
-		int iter = 0;
-		double err = 0;
-
-		do
-		{
-			Point2f cI2;
-			double a = 0, b = 0, c = 0, bb1 = 0, bb2 = 0;
-
-			getRectSubPix(src, Size(win_w + 2, win_h + 2), cI, subpix_buf, subpix_buf.type());
-			const float* subpix = &subpix_buf.at<float>(1, 1);
-
-			// process gradient
-			for (i = 0, k = 0; i < win_h; i++, subpix += win_w + 2)
-			{
-				double py = i - win.height;
-
-				for (j = 0; j < win_w; j++, k++)
-				{
-					double m = mask[k];
-					double tgx = subpix[j + 1] - subpix[j - 1];
-					double tgy = subpix[j + win_w + 2] - subpix[j - win_w - 2];
-					double gxx = tgx * tgx * m;
-					double gxy = tgx * tgy * m;
-					double gyy = tgy * tgy * m;
-					double px = j - win.width;
-
-					a += gxx;
-					b += gxy;
-					c += gyy;
-
-					bb1 += gxx * px + gxy * py;
-					bb2 += gxy * px + gyy * py;
-				}
-			}
-
-			double det = a * c - b * b;
-			if (fabs(det) <= DBL_EPSILON * DBL_EPSILON)
-				break;
-
-			// 2x2 matrix inversion
-			double scale = 1.0 / det;
-			cI2.x = (float)(cI.x + c * scale*bb1 - b * scale*bb2);
-			cI2.y = (float)(cI.y - b * scale*bb1 + a * scale*bb2);
-			err = (cI2.x - cI.x) * (cI2.x - cI.x) + (cI2.y - cI.y) * (cI2.y - cI.y);
-			cI = cI2;
-			if (cI.x < 0 || cI.x >= src.cols || cI.y < 0 || cI.y >= src.rows)
-				break;
-		} while (++iter < max_iters && err > eps);
-
-		// if new point is too far from initial, it means poor convergence.
-		// leave initial point as the result
-		if (fabs(cI.x - cT.x) > win.width || fabs(cI.y - cT.y) > win.height)
-			cI = cT;
-
-		corners[pt_i] = cI;
-	}
+	parallel_for_(Range(0, count), CornerSubPixInvoker(src, corners, maskm, win, max_iters, eps));
 }
 
 
@@ -1,9 +1,11 @@
 #include "precomp.hpp"
+#include "../../core/include/opencv2/core/hal/intrin.hpp"
 
 #include <cstdio>
 #include <vector>
 #include <iostream>
 #include <functional>
+#include <algorithm>
 
 namespace cv
 {
@@ -21,8 +23,6 @@ namespace cv
 		}
 	};
 
-#ifdef HAVE_OPENCL
-
 	struct Corner
 	{
 		float val;
@@ -36,6 +36,8 @@ namespace cv
 		}
 	};
 
+#ifdef HAVE_OPENCL
+
 	static bool ocl_goodFeaturesToTrack(InputArray _image, OutputArray _corners,
 		int maxCorners, double qualityLevel, double minDistance,
 		InputArray _mask, int blockSize, int gradientSize,
@@ -316,6 +318,423 @@ namespace cv
 
 #endif
 
+	// orders the corners so that the strongest one is at the top of a heap
+	struct CornerWorse
+	{
+		bool operator () (const Corner& a, const Corner& b) const
+		{
+			return b < a;
+		}
+	};
+
+	// adds the candidate to the list; if the list is limited, it is kept as a heap of the best
+	// maxCandidates corners with the weakest one at the top
+	static inline void pushCorner(std::vector<Corner>& corners, const Corner& c, int maxCandidates)
+	{
+		if (maxCandidates <= 0)
+			corners.push_back(c);
+		else if ((int)corners.size() < maxCandidates)
+		{
+			corners.push_back(c);
+			std::push_heap(corners.begin(), corners.end());
+		}
+		else if (c < corners.front())
+		{
+			std::pop_heap(corners.begin(), corners.end());
+			corners.back() = c;
+			std::push_heap(corners.begin(), corners.end());
+		}
+	}
+
+	// Finds the 3x3 local maxima of the corner response in rectangular regions of the image
+	// (horizontal stripes of the whole image by default). Every region computes the response of its
+	// pixels (with a margin for the box filter and the non-maximum suppression) while they are in
+	// cache, suppresses the non-maxima and collects the candidates and the maximum response of the
+	// region, so no full-size float image is made.
+	class GoodFeaturesInvoker : public ParallelLoopBody
+	{
+	public:
+		GoodFeaturesInvoker(const Mat& _image, const Mat& _mask, int _blockSize, int _gradientSize,
+			bool _useHarrisDetector, double _harrisK, int _maxCandidates, const std::vector<Rect>& _regions,
+			std::vector<std::vector<Corner> >& _candidates, std::vector<float>& _maxVals) :
+			image(_image), mask(_mask), blockSize(_blockSize), gradientSize(_gradientSize),
+			useHarrisDetector(_useHarrisDetector), harrisK(_harrisK), maxCandidates(_maxCandidates),
+			regions(_regions), candidates(_candidates), maxVals(_maxVals)
+		{
+		}
+
+		void operator()(const Range& range) const
+		{
+			int width = image.cols, height = image.rows;
+			int margin = blockSize / 2 + 1;
+			Mat eig;
+
+			for (int i = range.start; i < range.end; i++)
+			{
+				const Rect& region = regions[i];
+				int y0 = region.y, y1 = region.y + region.height;
+				int x0 = region.x, x1 = region.x + region.width;
+				int r0 = std::max(y0 - margin, 0), r1 = std::min(y1 + margin, height);
+				int c0 = std::max(x0 - margin, 0), c1 = std::min(x1 + margin, width);
+
+				// the derivative filters read the pixels outside of the region from the image itself
+				Mat src = image(Rect(c0, r0, c1 - c0, r1 - r0));
+				if (useHarrisDetector)
+					cornerHarris(src, eig, blockSize, gradientSize, harrisK);
+				else
+					cornerMinEigenVal(src, eig, blockSize, gradientSize);
+
+				std::vector<Corner>& corners = candidates[i];
+				float maxVal = -FLT_MAX;
+
+				for (int y = y0; y < y1; y++)
+				{
+					const float* row = eig.ptr<float>(y - r0) - c0;
+					const uchar* mrow = mask.data ? mask.ptr(y) : 0;
+					int x = x0;
+
+					if (mrow)
+					{
+						for (; x < x1; x++)
+							if (mrow[x])
+								maxVal = std::max(maxVal, row[x]);
+					}
+					else
+					{
+#if CV_SIMD128
+						v_float32x4 vmax = v_setall_f32(-FLT_MAX);
+						for (; x <= x1 - 4; x += 4)
+							vmax = v_max(vmax, v_load(row + x));
+						maxVal = std::max(maxVal, v_reduce_max(vmax));
+#endif
+						for (; x < x1; x++)
+							maxVal = std::max(maxVal, row[x]);
+					}
+
+					if (y == 0 || y == height - 1)
+						continue;
+
+					const float* prev = eig.ptr<float>(y - r0 - 1) - c0;
+					const float* next = eig.ptr<float>(y - r0 + 1) - c0;
+					int xend = std::min(x1, width - 1);
+
+					x = std::max(x0, 1);
+#if CV_SIMD128
+					for (; x <= xend - 4; x += 4)
+					{
+						v_float32x4 c = v_load(row + x);
+						v_float32x4 m = (c >= v_load(row + x - 1)) & (c >= v_load(row + x + 1)) &
+							(c >= v_load(prev + x - 1)) & (c >= v_load(prev + x)) & (c >= v_load(prev + x + 1)) &
+							(c >= v_load(next + x - 1)) & (c >= v_load(next + x)) & (c >= v_load(next + x + 1));
+						int bits = v_signmask(m);
+						for (int k = 0; bits != 0; k++, bits >>= 1)
+						{
+							if ((bits & 1) && (!mrow || mrow[x + k]))
+							{
+								Corner cn = { row[x + k], (short)y, (short)(x + k) };
+								pushCorner(corners, cn, maxCandidates);
+							}
+						}
+					}
+#endif
+					for (; x < xend; x++)
+					{
+						float val = row[x];
+						if (val >= row[x - 1] && val >= row[x + 1] &&
+							val >= prev[x - 1] && val >= prev[x] && val >= prev[x + 1] &&
+							val >= next[x - 1] && val >= next[x] && val >= next[x + 1] &&
+							(!mrow || mrow[x]))
+						{
+							Corner cn = { val, (short)y, (short)x };
+							pushCorner(corners, cn, maxCandidates);
+						}
+					}
+				}
+				maxVals[i] = maxVal;
+			}
+		}
+
+	private:
+		const Mat& image;
+		const Mat& mask;
+		int blockSize;
+		int gradientSize;
+		bool useHarrisDetector;
+		double harrisK;
+		int maxCandidates;
+		const std::vector<Rect>& regions;
+		std::vector<std::vector<Corner> >& candidates;
+		std::vector<float>& maxVals;
+	};
+
+	// returns the candidates of the legacy path one by one, in the order they have been sorted
+	struct SortedCornerSource
+	{
+		SortedCornerSource(const std::vector<const float*>& _corners, const Mat& _eig) :
+			corners(_corners), eig(_eig), i(0)
+		{
+		}
+
+		bool operator () (Point& pt)
+		{
+			if (i >= corners.size())
+				return false;
+			int ofs = (int)((const uchar*)corners[i++] - eig.ptr());
+			pt.y = (int)(ofs / eig.step);
+			pt.x = (int)((ofs - pt.y * eig.step) / sizeof(float));
+			return true;
+		}
+
+		const std::vector<const float*>& corners;
+		const Mat& eig;
+		size_t i;
+	};
+
+	// pops the candidates from a heap built with CornerWorse, so that only the corners actually
+	// examined by selectCorners get sorted
+	struct HeapCornerSource
+	{
+		HeapCornerSource(std::vector<Corner>& _heap) : heap(_heap), end(_heap.size())
+		{
+		}
+
+		bool operator () (Point& pt)
+		{
+			if (end == 0)
+				return false;
+			std::pop_heap(heap.begin(), heap.begin() + end, CornerWorse());
+			const Corner& c = heap[--end];
+			pt = Point(c.x, c.y);
+			return true;
+		}
+
+		std::vector<Corner>& heap;
+		size_t end;
+	};
+
+	// takes the corners from the source, strongest first, and keeps those that are not closer than
+	// minDistance to an already selected corner or to one of the existing corners
+	template<typename CornerSource> static void
+		selectCorners(CornerSource& source, Size imgsize, int maxCorners, double minDistance,
+			std::vector<Point2f>& corners, const std::vector<Point2f>& existing = std::vector<Point2f>())
+	{
+		size_t j, ncorners = 0;
+		Point pt;
+
+		if (minDistance >= 1)
+		{
+			// Partition the image into larger grids
+			int w = imgsize.width;
+			int h = imgsize.height;
+
+			const int cell_size = cvRound(minDistance);
+			const int grid_width = (w + cell_size - 1) / cell_size;
+			const int grid_height = (h + cell_size - 1) / cell_size;
+
+			std::vector<std::vector<Point2f> > grid(grid_width*grid_height);
+
+			for (j = 0; j < existing.size(); j++)
+			{
+				int x_cell = std::min(std::max(cvFloor(existing[j].x), 0), w - 1) / cell_size;
+				int y_cell = std::min(std::max(cvFloor(existing[j].y), 0), h - 1) / cell_size;
+				grid[y_cell*grid_width + x_cell].push_back(existing[j]);
+			}
+
+			minDistance *= minDistance;
+
+			while (source(pt))
+			{
+				int y = pt.y;
+				int x = pt.x;
+
+				bool good = true;
+
+				int x_cell = x / cell_size;
+				int y_cell = y / cell_size;
+
+				int x1 = x_cell - 1;
+				int y1 = y_cell - 1;
+				int x2 = x_cell + 1;
+				int y2 = y_cell + 1;
+
+				// boundary check
+				x1 = std::max(0, x1);
+				y1 = std::max(0, y1);
+				x2 = std::min(grid_width - 1, x2);
+				y2 = std::min(grid_height - 1, y2);
+
+				for (int yy = y1; yy <= y2; yy++)
+				{
+					for (int xx = x1; xx <= x2; xx++)
+					{
+						std::vector <Point2f> &m = grid[yy*grid_width + xx];
+
+						if (m.size())
+						{
+							for (j = 0; j < m.size(); j++)
+							{
+								float dx = x - m[j].x;
+								float dy = y - m[j].y;
+
+								if (dx*dx + dy * dy < minDistance)
+								{
+									good = false;
+									goto break_out;
+								}
+							}
+						}
+					}
+				}
+
+			break_out:
+
+				if (good)
+				{
+					grid[y_cell*grid_width + x_cell].push_back(Point2f((float)x, (float)y));
+
+					corners.push_back(Point2f((float)x, (float)y));
+					++ncorners;
+
+					if (maxCorners > 0 && (int)ncorners == maxCorners)
+						break;
+				}
+			}
+		}
+		else
+		{
+			while (source(pt))
+			{
+				corners.push_back(Point2f((float)pt.x, (float)pt.y));
+				++ncorners;
+				if (maxCorners > 0 && (int)ncorners == maxCorners)
+					break;
+			}
+		}
+	}
+
+	// the number of rows processed by one task of GoodFeaturesInvoker
+	static const int GFTT_STRIPE_ROWS = 64;
+
+	static void wholeImageRegions(Size size, std::vector<Rect>& regions)
+	{
+		regions.clear();
+		for (int y = 0; y < size.height; y += GFTT_STRIPE_ROWS)
+			regions.push_back(Rect(0, y, size.width, std::min(GFTT_STRIPE_ROWS, size.height - y)));
+	}
+
+	// splits the image into square cells, marks the cells whose pixels are all closer than
+	// minDistance to one of the existing corners (no new corner can be selected there) and returns
+	// the bounding rectangles of the runs of cells with uncovered pixels in every band of cells
+	static void uncoveredRegions(Size size, const std::vector<Point2f>& existing, double minDistance,
+		std::vector<Rect>& regions)
+	{
+		// cells of half the distance: a cell is covered when a corner is near its middle
+		int cell = cvFloor(minDistance / 2);
+		if (existing.empty() || cell < 4)
+		{
+			wholeImageRegions(size, regions);
+			return;
+		}
+
+		int gw = (size.width + cell - 1) / cell, gh = (size.height + cell - 1) / cell;
+		int r = cvCeil(minDistance / cell);
+		float minDist2 = (float)(minDistance*minDistance);
+		std::vector<uchar> covered(gw*gh, (uchar)0);
+
+		for (size_t i = 0; i < existing.size(); i++)
+		{
+			Point2f p = existing[i];
+			int cx = cvFloor(p.x) / cell, cy = cvFloor(p.y) / cell;
+
+			for (int yy = std::max(cy - r, 0); yy <= std::min(cy + r, gh - 1); yy++)
+			{
+				float dy0 = yy*cell - p.y, dy1 = std::min((yy + 1)*cell, size.height) - 1 - p.y;
+				float dy = std::max(dy0*dy0, dy1*dy1);
+
+				for (int xx = std::max(cx - r, 0); xx <= std::min(cx + r, gw - 1); xx++)
+				{
+					float dx0 = xx*cell - p.x, dx1 = std::min((xx + 1)*cell, size.width) - 1 - p.x;
+					if (std::max(dx0*dx0, dx1*dx1) + dy < minDist2)
+						covered[yy*gw + xx] = 1;
+				}
+			}
+		}
+
+		// small regions cost more in the per-call overhead of the response than they save, so the
+		// runs in a band are merged across gaps of up to 32 pixels
+		int bandCells = std::max(32 / cell, 1), maxGap = 32 / cell;
+		std::vector<uchar> needed(gw);
+
+		regions.clear();
+		for (int by = 0; by < gh; by += bandCells)
+		{
+			int ey = std::min(by + bandCells, gh);
+			for (int xx = 0; xx < gw; xx++)
+			{
+				needed[xx] = 0;
+				for (int yy = by; yy < ey; yy++)
+					needed[xx] |= !covered[yy*gw + xx];
+			}
+
+			for (int xx = 0; xx < gw; )
+			{
+				if (!needed[xx])
+				{
+					xx++;
+					continue;
+				}
+				int x0 = xx, x1 = xx + 1;
+				for (xx++; xx < gw; xx++)
+				{
+					if (needed[xx])
+						x1 = xx + 1;
+					else if (xx - x1 >= maxGap)
+						break;
+				}
+				int y0 = by*cell, y1 = std::min(ey*cell, size.height);
+				regions.push_back(Rect(x0*cell, y0, std::min(x1*cell, size.width) - x0*cell, y1 - y0));
+			}
+		}
+	}
+
+	// the fused detection; returns false when the threshold is negative, which happens only for the
+	// Harris response of degenerate images, as the candidates are then not the maxima of the
+	// thresholded response
+	static bool goodFeaturesToTrackRegions(const Mat& image, const Mat& mask, const std::vector<Rect>& regions,
+		int maxCorners, double qualityLevel, double minDistance, int blockSize, int gradientSize,
+		bool useHarrisDetector, double harrisK, const std::vector<Point2f>& existing,
+		std::vector<Point2f>& corners)
+	{
+		int nregions = (int)regions.size();
+		if (nregions == 0)
+			return true;
+		std::vector<std::vector<Corner> > candidates(nregions);
+		std::vector<float> maxVals(nregions, -FLT_MAX);
+
+		// without the distance check, no more than maxCorners corners of a region can be selected
+		int maxCandidates = minDistance < 1 ? maxCorners : 0;
+		parallel_for_(Range(0, nregions), GoodFeaturesInvoker(image, mask, blockSize, gradientSize,
+			useHarrisDetector, harrisK, maxCandidates, regions, candidates, maxVals), nregions);
+
+		float maxVal = *std::max_element(maxVals.begin(), maxVals.end());
+		if (maxVal == -FLT_MAX)
+			maxVal = 0; // empty mask
+		float thresh = (float)(maxVal*qualityLevel);
+		if (thresh < 0)
+			return false;
+
+		std::vector<Corner> heap;
+		for (int i = 0; i < nregions; i++)
+			for (size_t j = 0; j < candidates[i].size(); j++)
+				if (candidates[i][j].val > thresh)
+					heap.push_back(candidates[i][j]);
+
+		std::make_heap(heap.begin(), heap.end(), CornerWorse());
+		HeapCornerSource source(heap);
+		selectCorners(source, image.size(), maxCorners, minDistance, corners, existing);
+		return true;
+	}
+
 }
 
 
@@ -331,6 +750,26 @@ void cv::goodFeaturesToTrack(InputArray _image, OutputArray _corners,
 		return;
 	}
 
+	Mat mask = _mask.getMat();
+	CV_Assert(mask.empty() || (mask.type() == CV_8UC1 && mask.size() == image.size()));
+
+	std::vector<Point2f> corners;
+
+	std::vector<Rect> regions;
+	if (image.rows <= SHRT_MAX && image.cols <= SHRT_MAX)
+		wholeImageRegions(image.size(), regions);
+
+	if (!regions.empty() &&
+		goodFeaturesToTrackRegions(image, mask, regions, maxCorners, qualityLevel, minDistance,
+			blockSize, gradientSize, useHarrisDetector, harrisK, std::vector<Point2f>(), corners))
+	{
+		if (corners.empty())
+			_corners.release();
+		else
+			Mat(corners).convertTo(_corners, _corners.fixedType() ? _corners.type() : CV_32F);
+		return;
+	}
+
 	if (useHarrisDetector)
 		cornerHarris(image, eig, blockSize, gradientSize, harrisK);
 	else
@@ -345,7 +784,6 @@ void cv::goodFeaturesToTrack(InputArray _image, OutputArray _corners,
 	std::vector<const float*> tmpCorners;
 
 	// collect list of pointers to features - put them into temporary image
-	Mat mask = _mask.getMat();
 	for (int y = 1; y < imgsize.height - 1; y++)
 	{
 		const float* eig_data = (const float*)eig.ptr(y);
@@ -360,10 +798,7 @@ void cv::goodFeaturesToTrack(InputArray _image, OutputArray _corners,
 		}
 	}
 
-	std::vector<Point2f> corners;
-	size_t i, j, total = tmpCorners.size(), ncorners = 0;
-
-	if (total == 0)
+	if (tmpCorners.empty())
 	{
 		_corners.release();
 		return;
@@ -371,93 +806,114 @@ void cv::goodFeaturesToTrack(InputArray _image, OutputArray _corners,
 
 	std::sort(tmpCorners.begin(), tmpCorners.end(), greaterThanPtr());
 
-	if (minDistance >= 1)
-	{
-		// Partition the image into larger grids
-		int w = image.cols;
-		int h = image.rows;
+	SortedCornerSource source(tmpCorners, eig);
+	selectCorners(source, imgsize, maxCorners, minDistance, corners);
 
-		const int cell_size = cvRound(minDistance);
-		const int grid_width = (w + cell_size - 1) / cell_size;
-		const int grid_height = (h + cell_size - 1) / cell_size;
+	Mat(corners).convertTo(_corners, _corners.fixedType() ? _corners.type() : CV_32F);
+}
 
-		std::vector<std::vector<Point2f> > grid(grid_width*grid_height);
+void cv::goodFeaturesToTrackIncremental(InputArray _image, InputArray _existingCorners,
+	OutputArray _corners, int maxCorners, double qualityLevel, double minDistance,
+	InputArray _mask, int blockSize, int gradientSize,
+	bool useHarrisDetector, double harrisK)
+{
+	Mat image = _image.getMat();
+	Mat mask = _mask.getMat();
+	CV_Assert(image.type() == CV_8UC1 || image.type() == CV_32FC1);
+	CV_Assert(mask.empty() || (mask.type() == CV_8UC1 && mask.size() == image.size()));
+	CV_Assert(image.rows <= SHRT_MAX && image.cols <= SHRT_MAX);
 
-		minDistance *= minDistance;
+	std::vector<Point2f> existing;
+	if (!_existingCorners.empty())
+	{
+		Mat pts = _existingCorners.getMat();
+		CV_Assert(pts.checkVector(2) >= 0);
+		pts.reshape(2, pts.checkVector(2)).convertTo(existing, CV_32F);
 
-		for (i = 0; i < total; i++)
+		size_t i, j = 0;
+		for (i = 0; i < existing.size(); i++)
 		{
-			int ofs = (int)((const uchar*)tmpCorners[i] - eig.ptr());
-			int y = (int)(ofs / eig.step);
-			int x = (int)((ofs - y * eig.step) / sizeof(float));
-
-			bool good = true;
-
-			int x_cell = x / cell_size;
-			int y_cell = y / cell_size;
-
-			int x1 = x_cell - 1;
-			int y1 = y_cell - 1;
-			int x2 = x_cell + 1;
-			int y2 = y_cell + 1;
-
-			// boundary check
-			x1 = std::max(0, x1);
-			y1 = std::max(0, y1);
-			x2 = std::min(grid_width - 1, x2);
-			y2 = std::min(grid_height - 1, y2);
-
-			for (int yy = y1; yy <= y2; yy++)
-			{
-				for (int xx = x1; xx <= x2; xx++)
-				{
-					std::vector <Point2f> &m = grid[yy*grid_width + xx];
-
-					if (m.size())
-					{
-						for (j = 0; j < m.size(); j++)
-						{
-							float dx = x - m[j].x;
-							float dy = y - m[j].y;
-
-							if (dx*dx + dy * dy < minDistance)
-							{
-								good = false;
-								goto break_out;
-							}
-						}
-					}
-				}
-			}
-
-		break_out:
-
-			if (good)
-			{
-				grid[y_cell*grid_width + x_cell].push_back(Point2f((float)x, (float)y));
-
-				corners.push_back(Point2f((float)x, (float)y));
-				++ncorners;
-
-				if (maxCorners > 0 && (int)ncorners == maxCorners)
-					break;
-			}
+			Point2f p = existing[i];
+			if (p.x >= 0 && p.y >= 0 && p.x < image.cols && p.y < image.rows)
+				existing[j++] = p;
 		}
+		existing.resize(j);
 	}
-	else
+
+	std::vector<Point2f> corners;
+	std::vector<Rect> regions;
+	if (!image.empty())
 	{
-		for (i = 0; i < total; i++)
+		uncoveredRegions(image.size(), existing, minDistance, regions);
+		if (!goodFeaturesToTrackRegions(image, mask, regions, maxCorners, qualityLevel, minDistance,
+			blockSize, gradientSize, useHarrisDetector, harrisK, existing, corners))
 		{
-			int ofs = (int)((const uchar*)tmpCorners[i] - eig.ptr());
-			int y = (int)(ofs / eig.step);
-			int x = (int)((ofs - y * eig.step) / sizeof(float));
-
-			corners.push_back(Point2f((float)x, (float)y));
-			++ncorners;
-			if (maxCorners > 0 && (int)ncorners == maxCorners)
-				break;
+			// the degenerate Harris response: a negative threshold selects no corners either
+			corners.clear();
 		}
 	}
 
-	Mat(corners).convertTo(_corners, _corners.fixedType() ? _corners.type() : CV_32F);
+	if (corners.empty())
+		_corners.release();
+	else
+		Mat(corners).convertTo(_corners, _corners.fixedType() ? _corners.type() : CV_32F);
+}
+
+void cv::goodFeaturesToTrackGrid(InputArray _image, OutputArray _corners, Size gridSize,
+	int maxPerCell, double qualityLevel, double minDistance,
+	InputArray _mask, int blockSize, int gradientSize,
+	bool useHarrisDetector, double harrisK)
+{
+	Mat image = _image.getMat();
+	Mat mask = _mask.getMat();
+	CV_Assert(image.type() == CV_8UC1 || image.type() == CV_32FC1);
+	CV_Assert(mask.empty() || (mask.type() == CV_8UC1 && mask.size() == image.size()));
+	CV_Assert(image.rows <= SHRT_MAX && image.cols <= SHRT_MAX);
+	CV_Assert(gridSize.width > 0 && gridSize.height > 0 &&
+		gridSize.width <= image.cols && gridSize.height <= image.rows);
+
+	int ncells = gridSize.area();
+	std::vector<Rect> cells(ncells);
+	for (int i = 0; i < ncells; i++)
+	{
+		int cx = i % gridSize.width, cy = i / gridSize.width;
+		int x0 = cx * image.cols / gridSize.width, x1 = (cx + 1) * image.cols / gridSize.width;
+		int y0 = cy * image.rows / gridSize.height, y1 = (cy + 1) * image.rows / gridSize.height;
+		cells[i] = Rect(x0, y0, x1 - x0, y1 - y0);
+	}
+
+	std::vector<std::vector<Corner> > candidates(ncells);
+	std::vector<float> maxVals(ncells, -FLT_MAX);
+	int maxCandidates = minDistance < 1 ? maxPerCell : 0;
+	parallel_for_(Range(0, ncells), GoodFeaturesInvoker(image, mask, blockSize, gradientSize,
+		useHarrisDetector, harrisK, maxCandidates, cells, candidates, maxVals), ncells);
+
+	// the selection is sequential, so that the corners of a cell keep minDistance from the corners
+	// of the cells selected before it
+	std::vector<Point2f> corners, cellCorners;
+	std::vector<Corner> heap;
+	for (int i = 0; i < ncells; i++)
+	{
+		// the quality level is relative to the best corner of the cell; a cell without a positive
+		// response (masked out or flat for Harris) has no corners
+		float thresh = (float)(maxVals[i]*qualityLevel);
+		if (maxVals[i] <= 0)
+			continue;
+
+		heap.clear();
+		for (size_t j = 0; j < candidates[i].size(); j++)
+			if (candidates[i][j].val > thresh)
+				heap.push_back(candidates[i][j]);
+
+		std::make_heap(heap.begin(), heap.end(), CornerWorse());
+		HeapCornerSource source(heap);
+		cellCorners.clear();
+		selectCorners(source, image.size(), maxPerCell, minDistance, cellCorners, corners);
+		corners.insert(corners.end(), cellCorners.begin(), cellCorners.end());
+	}
+
+	if (corners.empty())
+		_corners.release();
+	else
+		Mat(corners).convertTo(_corners, _corners.fixedType() ? _corners.type() : CV_32F);
 }
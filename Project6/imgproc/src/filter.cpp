@@ -339,6 +339,58 @@ namespace cv
 			(int)dst.step);
 	}
 
+	// a stripe holds at least this many rows, and twice the kernel height, so the rows buffered
+	// before its first output row stay a small overhead
+	static const int FILTER_STRIPE_MIN_ROWS = 32;
+
+	class FilterStripeInvoker : public ParallelLoopBody
+	{
+	public:
+		FilterStripeInvoker(const FilterEngineFactory& _factory, const Mat& _src, Mat& _dst,
+			const Size& _wsz, const Point& _ofs, int _stripeRows) :
+			factory(_factory), src(_src), dst(_dst), wsz(_wsz), ofs(_ofs), stripeRows(_stripeRows)
+		{}
+
+		void operator()(const Range& range) const
+		{
+			int y0 = range.start*stripeRows, y1 = std::min(range.end*stripeRows, src.rows);
+			Mat srcStripe = src.rowRange(y0, y1), dstStripe = dst.rowRange(y0, y1);
+
+			factory.create()->apply(srcStripe, dstStripe, wsz, Point(ofs.x, ofs.y + y0));
+		}
+
+	private:
+		const FilterEngineFactory& factory;
+		const Mat& src;
+		Mat& dst;
+		Size wsz;
+		Point ofs;
+		int stripeRows;
+	};
+
+	void applyFilterEngine(const FilterEngineFactory& factory, const Mat& src, Mat& dst,
+		const Size& wsz, const Point& ofs)
+	{
+		CV_INSTRUMENT_REGION()
+
+		Ptr<FilterEngine> f = factory.create();
+
+		// in-place filtering relies on the sequential order of the rows
+		bool overlap = src.datastart < dst.dataend && dst.datastart < src.dataend;
+		int stripeRows = std::max(FILTER_STRIPE_MIN_ROWS, f->ksize.height * 2);
+		int nstripes = std::min(src.rows / stripeRows, cvRound(dst.total() / (double)(1 << 16)));
+
+		if (overlap || nstripes <= 1 || getNumThreads() <= 1)
+		{
+			f->apply(src, dst, wsz, ofs);
+			return;
+		}
+
+		stripeRows = (src.rows + nstripes - 1) / nstripes;
+		nstripes = (src.rows + stripeRows - 1) / stripeRows;
+		parallel_for_(Range(0, nstripes), FilterStripeInvoker(factory, src, dst, wsz, ofs, stripeRows), nstripes);
+	}
+
 }
 
 /****************************************************************************************\
@@ -4658,6 +4710,52 @@ static bool dftFilter2D(int stype, int dtype, int kernel_type,
 	return true;
 }
 
+namespace cv
+{
+	class LinearFilterEngineFactory : public FilterEngineFactory
+	{
+	public:
+		LinearFilterEngineFactory(int _stype, int _dtype, const Mat& _kernel, Point _anchor, double _delta,
+			int _borderType) :
+			stype(_stype), dtype(_dtype), kernel(_kernel), anchor(_anchor), delta(_delta), borderType(_borderType)
+		{}
+
+		Ptr<FilterEngine> create() const
+		{
+			return createLinearFilter(stype, dtype, kernel, anchor, delta, borderType);
+		}
+
+	private:
+		int stype, dtype;
+		Mat kernel;
+		Point anchor;
+		double delta;
+		int borderType;
+	};
+
+	class SepFilterEngineFactory : public FilterEngineFactory
+	{
+	public:
+		SepFilterEngineFactory(int _stype, int _dtype, const Mat& _kernelX, const Mat& _kernelY, Point _anchor,
+			double _delta, int _borderType) :
+			stype(_stype), dtype(_dtype), kernelX(_kernelX), kernelY(_kernelY), anchor(_anchor), delta(_delta),
+			borderType(_borderType)
+		{}
+
+		Ptr<FilterEngine> create() const
+		{
+			return createSeparableLinearFilter(stype, dtype, kernelX, kernelY, anchor, delta, borderType);
+		}
+
+	private:
+		int stype, dtype;
+		Mat kernelX, kernelY;
+		Point anchor;
+		double delta;
+		int borderType;
+	};
+}
+
 static void ocvFilter2D(int stype, int dtype, int kernel_type,
 	uchar * src_data, size_t src_step,
 	uchar * dst_data, size_t dst_step,
@@ -4671,11 +4769,10 @@ static void ocvFilter2D(int stype, int dtype, int kernel_type,
 {
 	int borderTypeValue = borderType & ~BORDER_ISOLATED;
 	Mat kernel = Mat(Size(kernel_width, kernel_height), kernel_type, kernel_data, kernel_step);
-	Ptr<FilterEngine> f = createLinearFilter(stype, dtype, kernel, Point(anchor_x, anchor_y), delta,
-		borderTypeValue);
 	Mat src(Size(width, height), stype, src_data, src_step);
 	Mat dst(Size(width, height), dtype, dst_data, dst_step);
-	f->apply(src, dst, Size(full_width, full_height), Point(offset_x, offset_y));
+	applyFilterEngine(LinearFilterEngineFactory(stype, dtype, kernel, Point(anchor_x, anchor_y), delta,
+		borderTypeValue), src, dst, Size(full_width, full_height), Point(offset_x, offset_y));
 }
 
 static bool replacementSepFilter(int stype, int dtype, int ktype,
@@ -4711,12 +4808,10 @@ static void ocvSepFilter(int stype, int dtype, int ktype,
 {
 	Mat kernelX(Size(kernelx_len, 1), ktype, kernelx_data);
 	Mat kernelY(Size(kernely_len, 1), ktype, kernely_data);
-	Ptr<FilterEngine> f = createSeparableLinearFilter(stype, dtype, kernelX, kernelY,
-		Point(anchor_x, anchor_y),
-		delta, borderType & ~BORDER_ISOLATED);
 	Mat src(Size(width, height), stype, src_data, src_step);
 	Mat dst(Size(width, height), dtype, dst_data, dst_step);
-	f->apply(src, dst, Size(full_width, full_height), Point(offset_x, offset_y));
+	applyFilterEngine(SepFilterEngineFactory(stype, dtype, kernelX, kernelY, Point(anchor_x, anchor_y),
+		delta, borderType & ~BORDER_ISOLATED), src, dst, Size(full_width, full_height), Point(offset_x, offset_y));
 };
 
 //===================================================================
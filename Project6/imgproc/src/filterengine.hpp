@@ -130,6 +130,20 @@ namespace cv
 		Ptr<BaseRowFilter> rowFilter;
 		Ptr<BaseColumnFilter> columnFilter;
 	};
+
+	//! creates the engines of the row stripes filtered in parallel by applyFilterEngine
+	class FilterEngineFactory
+	{
+	public:
+		virtual ~FilterEngineFactory() {}
+		virtual Ptr<FilterEngine> create() const = 0;
+	};
+
+	//! filters the ROI like FilterEngine::apply. Large frames are split into row stripes filtered in
+	//! parallel, each by its own engine since the engines and some filters keep state between rows;
+	//! a stripe reads the rows around it from the source or, outside wsz, from the border.
+	void applyFilterEngine(const FilterEngineFactory& factory, const Mat& src, Mat& dst,
+		const Size& wsz, const Point& ofs);
 	//! returns type (one of KERNEL_*) of 1D or 2D kernel specified by its coefficients.
 	int getKernelType(InputArray kernel, Point anchor);
 
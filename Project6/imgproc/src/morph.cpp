@@ -2,6 +2,7 @@
 #include <limits.h>
 #include <iostream>
 #include "hal_replacement.hpp"
+#include "../../core/include/opencv2/core/hal/intrin.hpp"
 
 /****************************************************************************************\
 Basic Morphological Operations: Erosion & Dilation
@@ -591,6 +592,73 @@ namespace cv
 	typedef MorphNoVec ErodeVec64f;
 	typedef MorphNoVec DilateVec64f;
 
+	// Element-wise min/max of whole rows, shared by the van Herk/Gil-Werman and 3x3 filters below.
+	// The generic versions process nothing; the overloads process as many full vectors as fit.
+	template<class Op> static inline int vecMorphRows(const Op&, const typename Op::rtype*,
+		const typename Op::rtype*, typename Op::rtype*, int)
+	{
+		return 0;
+	}
+
+	template<class Op> static inline int vecMorphRows(const Op&, const typename Op::rtype*,
+		const typename Op::rtype*, const typename Op::rtype*, typename Op::rtype*, int)
+	{
+		return 0;
+	}
+
+#if CV_SIMD128
+
+#define CV_MORPH_ROWS_VEC(Op, T, vop) \
+	static inline int vecMorphRows(const Op<T>&, const T* a, const T* b, T* d, int n) \
+	{ \
+		const int nlanes = V_RegTrait128<T>::reg::nlanes; \
+		int i = 0; \
+		for (; i <= n - nlanes; i += nlanes) \
+			v_store(d + i, vop(v_load(a + i), v_load(b + i))); \
+		return i; \
+	} \
+	static inline int vecMorphRows(const Op<T>&, const T* a, const T* b, const T* c, T* d, int n) \
+	{ \
+		const int nlanes = V_RegTrait128<T>::reg::nlanes; \
+		int i = 0; \
+		for (; i <= n - nlanes; i += nlanes) \
+			v_store(d + i, vop(vop(v_load(a + i), v_load(b + i)), v_load(c + i))); \
+		return i; \
+	}
+
+	CV_MORPH_ROWS_VEC(MinOp, uchar, v_min)
+	CV_MORPH_ROWS_VEC(MaxOp, uchar, v_max)
+	CV_MORPH_ROWS_VEC(MinOp, ushort, v_min)
+	CV_MORPH_ROWS_VEC(MaxOp, ushort, v_max)
+	CV_MORPH_ROWS_VEC(MinOp, short, v_min)
+	CV_MORPH_ROWS_VEC(MaxOp, short, v_max)
+	CV_MORPH_ROWS_VEC(MinOp, float, v_min)
+	CV_MORPH_ROWS_VEC(MaxOp, float, v_max)
+#if CV_SIMD128_64F
+	CV_MORPH_ROWS_VEC(MinOp, double, v_min)
+	CV_MORPH_ROWS_VEC(MaxOp, double, v_max)
+#endif
+
+#undef CV_MORPH_ROWS_VEC
+
+#endif
+
+	template<class Op> static inline void morphRows(const Op& op, const typename Op::rtype* a,
+		const typename Op::rtype* b, typename Op::rtype* d, int n)
+	{
+		int i = vecMorphRows(op, a, b, d, n);
+		for (; i < n; i++)
+			d[i] = op(a[i], b[i]);
+	}
+
+	template<class Op> static inline void morphRows(const Op& op, const typename Op::rtype* a,
+		const typename Op::rtype* b, const typename Op::rtype* c, typename Op::rtype* d, int n)
+	{
+		int i = vecMorphRows(op, a, b, c, d, n);
+		for (; i < n; i++)
+			d[i] = op(op(a[i], b[i]), c[i]);
+	}
+
 
 	template<class Op, class VecOp> struct MorphRowFilter : public BaseRowFilter
 	{
@@ -805,6 +873,262 @@ namespace cv
 		VecOp vecOp;
 	};
 
+
+	/*
+	 van Herk/Gil-Werman filters for long rectangular kernels. The input is split into
+	 blocks of ksize elements; the window of an output that starts inside a block is the
+	 suffix of that block followed by a prefix of the next one, so with the block suffixes
+	 and a running prefix every output costs about three min/max operations whatever the
+	 kernel size is.
+	*/
+	template<class Op> struct MorphRowFilterVHGW : public BaseRowFilter
+	{
+		typedef typename Op::rtype T;
+
+		MorphRowFilterVHGW(int _ksize, int _anchor)
+		{
+			ksize = _ksize;
+			anchor = _anchor;
+		}
+
+		void operator()(const uchar* src, uchar* dst, int width, int cn)
+		{
+			int i, j, k, n, _ksize = ksize * cn;
+			const T* S = (const T*)src;
+			T* D = (T*)dst;
+			Op op;
+
+			buf.resize(ksize);
+			T* H = &buf[0];
+
+			for (k = 0; k < cn; k++, S++, D++)
+			{
+				for (i = 0; i < width; i += ksize)
+				{
+					const T* s = S + i * cn;
+					T* d = D + i * cn;
+					n = std::min(ksize, width - i);
+
+					T m = s[_ksize - cn];
+					H[ksize - 1] = m;
+					for (j = ksize - 2; j >= 0; j--)
+						H[j] = m = op(s[j*cn], m);
+
+					// s[j*cn] enters the window of output j, growing the prefix of the next block
+					d[0] = m;
+					s += _ksize - cn;
+					m = s[cn];
+					for (j = 1; j < n; j++)
+					{
+						m = op(m, s[j*cn]);
+						d[j*cn] = op(H[j], m);
+					}
+				}
+			}
+		}
+
+		std::vector<T> buf;
+	};
+
+
+	template<class Op> struct MorphColumnFilterVHGW : public BaseColumnFilter
+	{
+		typedef typename Op::rtype T;
+
+		MorphColumnFilterVHGW(int _ksize, int _anchor)
+		{
+			ksize = _ksize;
+			anchor = _anchor;
+			phase = 0;
+		}
+
+		virtual void reset() { phase = 0; }
+
+		// Output rows arrive in order, so the suffixes of the current block are kept
+		// between calls together with the running prefix of the next block.
+		void operator()(const uchar** _src, uchar* dst, int dststep, int count, int width)
+		{
+			const T** src = (const T**)_src;
+			Op op;
+
+			if ((int)buf.size() != ksize * width)
+			{
+				buf.resize(ksize * width);
+				phase = 0;
+			}
+
+			T* H = &buf[0];
+			T* G = H + (ksize - 1)*width;
+
+			for (; count > 0; count--, dst += dststep, src++)
+			{
+				T* D = (T*)dst;
+				const T* S = src[ksize - 1];
+
+				if (phase == 0)
+				{
+					// H[k] is the min/max of the block rows k..ksize-1; H[0] goes straight
+					// to the output and the last slot then holds the next block's prefix
+					memcpy(H + (ksize - 2)*width, S, width * sizeof(T));
+					for (int k = ksize - 2; k > 0; k--)
+						morphRows(op, src[k], H + k * width, H + (k - 1)*width, width);
+					morphRows(op, src[0], H, D, width);
+				}
+				else
+				{
+					if (phase == 1)
+						memcpy(G, S, width * sizeof(T));
+					else
+						morphRows(op, G, S, G, width);
+					morphRows(op, H + (phase - 1)*width, G, D, width);
+				}
+
+				if (++phase == ksize)
+					phase = 0;
+			}
+		}
+
+		std::vector<T> buf;
+		int phase;
+	};
+
+
+	// Dedicated 3x3 rectangle: a vertical min/max of the three rows followed by a
+	// horizontal one, both done on whole rows with SIMD.
+	template<class Op> struct MorphFilter3x3 : public BaseFilter
+	{
+		typedef typename Op::rtype T;
+
+		MorphFilter3x3(Point _anchor)
+		{
+			anchor = _anchor;
+			ksize = Size(3, 3);
+		}
+
+		void operator()(const uchar** _src, uchar* dst, int dststep, int count, int width, int cn)
+		{
+			const T** src = (const T**)_src;
+			int width1 = (width + 2)*cn;
+			Op op;
+
+			width *= cn;
+			buf.resize(width1);
+			T* V = &buf[0];
+
+			for (; count > 0; count--, dst += dststep, src++)
+			{
+				morphRows(op, src[0], src[1], src[2], V, width1);
+				morphRows(op, V, V + cn, V + cn * 2, (T*)dst, width);
+			}
+		}
+
+		std::vector<T> buf;
+	};
+
+
+	// kernel sizes from which the van Herk/Gil-Werman filters beat the direct SIMD ones.
+	// The row filter is scalar, so for 8-bit data the 16-lane direct filter always wins.
+	enum { MORPH_VHGW_MIN_COLUMN_KSIZE = 9 };
+
+	static int morphVHGWMinRowKsize(int depth)
+	{
+		return depth == CV_8U ? INT_MAX : depth == CV_16U || depth == CV_16S ? 31 :
+			depth == CV_32F ? 21 : 11;
+	}
+
+	static Ptr<BaseRowFilter> getMorphologyRowFilterVHGW(int op, int depth, int ksize, int anchor)
+	{
+		if (op == MORPH_ERODE)
+		{
+			if (depth == CV_8U)
+				return makePtr<MorphRowFilterVHGW<MinOp<uchar> > >(ksize, anchor);
+			if (depth == CV_16U)
+				return makePtr<MorphRowFilterVHGW<MinOp<ushort> > >(ksize, anchor);
+			if (depth == CV_16S)
+				return makePtr<MorphRowFilterVHGW<MinOp<short> > >(ksize, anchor);
+			if (depth == CV_32F)
+				return makePtr<MorphRowFilterVHGW<MinOp<float> > >(ksize, anchor);
+			if (depth == CV_64F)
+				return makePtr<MorphRowFilterVHGW<MinOp<double> > >(ksize, anchor);
+		}
+		else
+		{
+			if (depth == CV_8U)
+				return makePtr<MorphRowFilterVHGW<MaxOp<uchar> > >(ksize, anchor);
+			if (depth == CV_16U)
+				return makePtr<MorphRowFilterVHGW<MaxOp<ushort> > >(ksize, anchor);
+			if (depth == CV_16S)
+				return makePtr<MorphRowFilterVHGW<MaxOp<short> > >(ksize, anchor);
+			if (depth == CV_32F)
+				return makePtr<MorphRowFilterVHGW<MaxOp<float> > >(ksize, anchor);
+			if (depth == CV_64F)
+				return makePtr<MorphRowFilterVHGW<MaxOp<double> > >(ksize, anchor);
+		}
+		return Ptr<BaseRowFilter>();
+	}
+
+	static Ptr<BaseColumnFilter> getMorphologyColumnFilterVHGW(int op, int depth, int ksize, int anchor)
+	{
+		if (op == MORPH_ERODE)
+		{
+			if (depth == CV_8U)
+				return makePtr<MorphColumnFilterVHGW<MinOp<uchar> > >(ksize, anchor);
+			if (depth == CV_16U)
+				return makePtr<MorphColumnFilterVHGW<MinOp<ushort> > >(ksize, anchor);
+			if (depth == CV_16S)
+				return makePtr<MorphColumnFilterVHGW<MinOp<short> > >(ksize, anchor);
+			if (depth == CV_32F)
+				return makePtr<MorphColumnFilterVHGW<MinOp<float> > >(ksize, anchor);
+			if (depth == CV_64F)
+				return makePtr<MorphColumnFilterVHGW<MinOp<double> > >(ksize, anchor);
+		}
+		else
+		{
+			if (depth == CV_8U)
+				return makePtr<MorphColumnFilterVHGW<MaxOp<uchar> > >(ksize, anchor);
+			if (depth == CV_16U)
+				return makePtr<MorphColumnFilterVHGW<MaxOp<ushort> > >(ksize, anchor);
+			if (depth == CV_16S)
+				return makePtr<MorphColumnFilterVHGW<MaxOp<short> > >(ksize, anchor);
+			if (depth == CV_32F)
+				return makePtr<MorphColumnFilterVHGW<MaxOp<float> > >(ksize, anchor);
+			if (depth == CV_64F)
+				return makePtr<MorphColumnFilterVHGW<MaxOp<double> > >(ksize, anchor);
+		}
+		return Ptr<BaseColumnFilter>();
+	}
+
+	static Ptr<BaseFilter> getMorphologyFilter3x3(int op, int depth, Point anchor)
+	{
+		if (op == MORPH_ERODE)
+		{
+			if (depth == CV_8U)
+				return makePtr<MorphFilter3x3<MinOp<uchar> > >(anchor);
+			if (depth == CV_16U)
+				return makePtr<MorphFilter3x3<MinOp<ushort> > >(anchor);
+			if (depth == CV_16S)
+				return makePtr<MorphFilter3x3<MinOp<short> > >(anchor);
+			if (depth == CV_32F)
+				return makePtr<MorphFilter3x3<MinOp<float> > >(anchor);
+			if (depth == CV_64F)
+				return makePtr<MorphFilter3x3<MinOp<double> > >(anchor);
+		}
+		else
+		{
+			if (depth == CV_8U)
+				return makePtr<MorphFilter3x3<MaxOp<uchar> > >(anchor);
+			if (depth == CV_16U)
+				return makePtr<MorphFilter3x3<MaxOp<ushort> > >(anchor);
+			if (depth == CV_16S)
+				return makePtr<MorphFilter3x3<MaxOp<short> > >(anchor);
+			if (depth == CV_32F)
+				return makePtr<MorphFilter3x3<MaxOp<float> > >(anchor);
+			if (depth == CV_64F)
+				return makePtr<MorphFilter3x3<MaxOp<double> > >(anchor);
+		}
+		return Ptr<BaseFilter>();
+	}
+
 }
 
 /////////////////////////////////// External Interface /////////////////////////////////////
@@ -815,6 +1139,12 @@ cv::Ptr<cv::BaseRowFilter> cv::getMorphologyRowFilter(int op, int type, int ksiz
 	if (anchor < 0)
 		anchor = ksize / 2;
 	CV_Assert(op == MORPH_ERODE || op == MORPH_DILATE);
+	if (ksize >= morphVHGWMinRowKsize(depth))
+	{
+		Ptr<BaseRowFilter> f = getMorphologyRowFilterVHGW(op, depth, ksize, anchor);
+		if (f)
+			return f;
+	}
 	if (op == MORPH_ERODE)
 	{
 		if (depth == CV_8U)
@@ -862,6 +1192,12 @@ cv::Ptr<cv::BaseColumnFilter> cv::getMorphologyColumnFilter(int op, int type, in
 	if (anchor < 0)
 		anchor = ksize / 2;
 	CV_Assert(op == MORPH_ERODE || op == MORPH_DILATE);
+	if (ksize >= MORPH_VHGW_MIN_COLUMN_KSIZE)
+	{
+		Ptr<BaseColumnFilter> f = getMorphologyColumnFilterVHGW(op, depth, ksize, anchor);
+		if (f)
+			return f;
+	}
 	if (op == MORPH_ERODE)
 	{
 		if (depth == CV_8U)
@@ -910,6 +1246,12 @@ cv::Ptr<cv::BaseFilter> cv::getMorphologyFilter(int op, int type, InputArray _ke
 	int depth = CV_MAT_DEPTH(type);
 	anchor = normalizeAnchor(anchor, kernel.size());
 	CV_Assert(op == MORPH_ERODE || op == MORPH_DILATE);
+	if (kernel.size() == Size(3, 3) && countNonZero(kernel) == 9)
+	{
+		Ptr<BaseFilter> f = getMorphologyFilter3x3(op, depth, anchor);
+		if (f)
+			return f;
+	}
 	if (op == MORPH_ERODE)
 	{
 		if (depth == CV_8U)
@@ -953,7 +1295,7 @@ cv::Ptr<cv::FilterEngine> cv::createMorphologyFilter(int op, int type, InputArra
 	Ptr<BaseColumnFilter> columnFilter;
 	Ptr<BaseFilter> filter2D;
 
-	if (countNonZero(kernel) == kernel.rows*kernel.cols)
+	if (countNonZero(kernel) == kernel.rows*kernel.cols && kernel.size() != Size(3, 3))
 	{
 		// rectangular structuring element
 		rowFilter = getMorphologyRowFilter(op, type, kernel.cols, anchor.x);
@@ -1283,6 +1625,27 @@ namespace cv
 
 	// ===== 3. Fallback implementation
 
+	class MorphologyFilterEngineFactory : public FilterEngineFactory
+	{
+	public:
+		MorphologyFilterEngineFactory(int _op, int _type, const Mat& _kernel, Point _anchor, int _borderType,
+			const Scalar& _borderValue) :
+			op(_op), type(_type), kernel(_kernel), anchor(_anchor), borderType(_borderType), borderValue(_borderValue)
+		{}
+
+		Ptr<FilterEngine> create() const
+		{
+			return createMorphologyFilter(op, type, kernel, anchor, borderType, borderType, borderValue);
+		}
+
+	private:
+		int op, type;
+		Mat kernel;
+		Point anchor;
+		int borderType;
+		Scalar borderValue;
+	};
+
 	static void ocvMorph(int op, int src_type, int dst_type,
 		uchar * src_data, size_t src_step,
 		uchar * dst_data, size_t dst_step,
@@ -1296,19 +1659,30 @@ namespace cv
 		Mat kernel(Size(kernel_width, kernel_height), kernel_type, kernel_data, kernel_step);
 		Point anchor(anchor_x, anchor_y);
 		Vec<double, 4> borderVal(borderValue);
-		Ptr<FilterEngine> f = createMorphologyFilter(op, src_type, kernel, anchor, borderType, borderType, borderVal);
+		MorphologyFilterEngineFactory factory(op, src_type, kernel, anchor, borderType, borderVal);
 		Mat src(Size(width, height), src_type, src_data, src_step);
 		Mat dst(Size(width, height), dst_type, dst_data, dst_step);
 		{
 			Point ofs(roi_x, roi_y);
 			Size wsz(roi_width, roi_height);
-			f->apply(src, dst, wsz, ofs);
+			applyFilterEngine(factory, src, dst, wsz, ofs);
 		}
 		{
 			Point ofs(roi_x2, roi_y2);
 			Size wsz(roi_width2, roi_height2);
+			// the next iterations work in place; when dst is not a part of a bigger image the
+			// previous result is copied aside so that every iteration can be split into stripes
+			Mat buf;
 			for (int i = 1; i < iterations; i++)
-				f->apply(dst, dst, wsz, ofs);
+			{
+				if (getNumThreads() > 1 && ofs == Point() && wsz == dst.size())
+				{
+					dst.copyTo(buf);
+					applyFilterEngine(factory, buf, dst, wsz, ofs);
+				}
+				else
+					applyFilterEngine(factory, dst, dst, wsz, ofs);
+			}
 		}
 	}
 
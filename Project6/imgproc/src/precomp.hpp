@@ -7,6 +7,7 @@
 #include "../include/opencv2/imgproc/imgproc_c.h"
 #include "../../core/include/opencv2/core/private.hpp"
 #include "../../core/include/opencv2/core/hal/hal.hpp"
+#include "../../core/include/opencv2/core/sse_utils.hpp"
 #include "../include/opencv2/imgproc/hal/hal.hpp"
 #include "hal_replacement.hpp"
 
@@ -1,4 +1,5 @@
 #include "precomp.hpp"
+#include "../../core/include/opencv2/core/hal/intrin.hpp"
 //#include "opencl_kernels_imgproc.hpp"
 
 //#include "opencv2/core/openvx/ovx_defs.hpp"
@@ -805,60 +806,129 @@ namespace cv
 
 #endif
 
-	template<class CastOp, class VecOp> void
-		pyrDown_(const Mat& _src, Mat& _dst, int borderType)
+	// Horizontal convolution and decimation of a single-channel row for pyrDown, from output x
+	// (at least 1) up to width - 1; the source row must hold at least 2*width + 2 elements.
+	template<typename T, typename WT> static inline int pyrDownVecH(const T*, WT*, int x, int)
 	{
-		const int PD_SZ = 5;
-		typedef typename CastOp::type1 WT;
-		typedef typename CastOp::rtype T;
+		return x;
+	}
 
-		CV_Assert(!_src.empty());
-		Size ssize = _src.size(), dsize = _dst.size();
-		int cn = _src.channels();
-		int bufstep = (int)alignSize(dsize.width*cn, 16);
-		AutoBuffer<WT> _buf(bufstep*PD_SZ + 16);
-		WT* buf = alignPtr((WT*)_buf, 16);
-		int tabL[CV_CN_MAX*(PD_SZ + 2)], tabR[CV_CN_MAX*(PD_SZ + 2)];
-		AutoBuffer<int> _tabM(dsize.width*cn);
-		int* tabM = _tabM;
-		WT* rows[PD_SZ];
-		CastOp castOp;
-		VecOp vecOp;
+#if CV_SIMD128
 
-		CV_Assert(ssize.width > 0 && ssize.height > 0 &&
-			std::abs(dsize.width * 2 - ssize.width) <= 2 &&
-			std::abs(dsize.height * 2 - ssize.height) <= 2);
-		int k, x, sy0 = -PD_SZ / 2, sy = sy0, width0 = std::min((ssize.width - PD_SZ / 2 - 1) / 2 + 1, dsize.width);
+	static inline int pyrDownVecH(const uchar* src, int* row, int x, int width)
+	{
+		v_uint16x8 v_6 = v_setall_u16(6);
+
+		for (; x <= width - 16; x += 16)
+		{
+			v_uint8x16 s0, s1, s2, s3, s4, s5;
+			v_load_deinterleave(src + x * 2 - 2, s0, s1);
+			v_load_deinterleave(src + x * 2, s2, s3);
+			v_load_deinterleave(src + x * 2 + 2, s4, s5);
+
+			v_uint16x8 a0, a1, b0, b1, c0, c1, d0, d1, e0, e1;
+			v_expand(s0, a0, a1);
+			v_expand(s1, b0, b1);
+			v_expand(s2, c0, c1);
+			v_expand(s3, d0, d1);
+			v_expand(s4, e0, e1);
+
+			v_uint16x8 t0 = c0 * v_6 + ((b0 + d0) << 2) + a0 + e0;
+			v_uint16x8 t1 = c1 * v_6 + ((b1 + d1) << 2) + a1 + e1;
+			v_uint32x4 r0, r1, r2, r3;
+			v_expand(t0, r0, r1);
+			v_expand(t1, r2, r3);
+			v_store(row + x, v_reinterpret_as_s32(r0));
+			v_store(row + x + 4, v_reinterpret_as_s32(r1));
+			v_store(row + x + 8, v_reinterpret_as_s32(r2));
+			v_store(row + x + 12, v_reinterpret_as_s32(r3));
+		}
+
+		return x;
+	}
+
+	static inline int pyrDownVecH(const float* src, float* row, int x, int width)
+	{
+		v_float32x4 v_6 = v_setall_f32(6.f), v_4 = v_setall_f32(4.f);
+
+		for (; x <= width - 4; x += 4)
+		{
+			v_float32x4 s0, s1, s2, s3, s4, s5;
+			v_load_deinterleave(src + x * 2 - 2, s0, s1);
+			v_load_deinterleave(src + x * 2, s2, s3);
+			v_load_deinterleave(src + x * 2 + 2, s4, s5);
+			v_store(row + x, s2 * v_6 + (s1 + s3) * v_4 + s0 + s4);
+		}
+
+		return x;
+	}
+
+#endif
+
+	// Streams one pyrDown level: the destination rows are computed in order, every one from a ring
+	// buffer of horizontally convolved and decimated source rows.
+	template<class CastOp, class VecOp> class PyrDownLevel
+	{
+	public:
+		typedef typename CastOp::type1 WT;
+		typedef typename CastOp::rtype T;
+		enum { PD_SZ = 5 };
 
-		for (x = 0; x <= PD_SZ + 1; x++)
+		// y0 is the first destination row that will be computed
+		PyrDownLevel(const Mat& _src, const Mat& _dst, int _borderType, int y0) :
+			src(_src), dst(_dst), borderType(_borderType)
 		{
-			int sx0 = borderInterpolate(x - PD_SZ / 2, ssize.width, borderType)*cn;
-			int sx1 = borderInterpolate(x + width0 * 2 - PD_SZ / 2, ssize.width, borderType)*cn;
-			for (k = 0; k < cn; k++)
+			CV_Assert(!src.empty());
+			ssize = src.size();
+			dsize = dst.size();
+			cn = src.channels();
+			bufstep = (int)alignSize(dsize.width*cn, 16);
+			_buf.allocate(bufstep*PD_SZ + 16);
+			buf = alignPtr((WT*)_buf, 16);
+			_tabM.allocate(dsize.width*cn);
+			tabM = _tabM;
+
+			CV_Assert(ssize.width > 0 && ssize.height > 0 &&
+				std::abs(dsize.width * 2 - ssize.width) <= 2 &&
+				std::abs(dsize.height * 2 - ssize.height) <= 2);
+			int k, x;
+			sy0 = y0 * 2 - PD_SZ / 2;
+			sy = sy0;
+			width0 = std::min((ssize.width - PD_SZ / 2 - 1) / 2 + 1, dsize.width);
+
+			for (x = 0; x <= PD_SZ + 1; x++)
 			{
-				tabL[x*cn + k] = sx0 + k;
-				tabR[x*cn + k] = sx1 + k;
+				int sx0 = borderInterpolate(x - PD_SZ / 2, ssize.width, borderType)*cn;
+				int sx1 = borderInterpolate(x + width0 * 2 - PD_SZ / 2, ssize.width, borderType)*cn;
+				for (k = 0; k < cn; k++)
+				{
+					tabL[x*cn + k] = sx0 + k;
+					tabR[x*cn + k] = sx1 + k;
+				}
 			}
-		}
 
-		ssize.width *= cn;
-		dsize.width *= cn;
-		width0 *= cn;
+			ssize.width *= cn;
+			dsize.width *= cn;
+			width0 *= cn;
 
-		for (x = 0; x < dsize.width; x++)
-			tabM[x] = (x / cn) * 2 * cn + x % cn;
+			for (x = 0; x < dsize.width; x++)
+				tabM[x] = (x / cn) * 2 * cn + x % cn;
+		}
 
-		for (int y = 0; y < dsize.height; y++)
+		// computes the destination row y, the one after the previously computed row
+		void processRow(int y)
 		{
-			T* dst = _dst.ptr<T>(y);
+			T* D = dst.ptr<T>(y);
+			WT* rows[PD_SZ];
 			WT *row0, *row1, *row2, *row3, *row4;
+			int k, x;
 
 			// fill the ring buffer (horizontal convolution and decimation)
 			for (; sy <= y * 2 + 2; sy++)
 			{
 				WT* row = buf + ((sy - sy0) % PD_SZ)*bufstep;
 				int _sy = borderInterpolate(sy, ssize.height, borderType);
-				const T* src = _src.ptr<T>(_sy);
+				const T* S = src.ptr<T>(_sy);
 				int limit = cn;
 				const int* tab = tabL;
 
@@ -866,8 +936,8 @@ namespace cv
 				{
 					for (; x < limit; x++)
 					{
-						row[x] = src[tab[x + cn * 2]] * 6 + (src[tab[x + cn]] + src[tab[x + cn * 3]]) * 4 +
-							src[tab[x]] + src[tab[x + cn * 4]];
+						row[x] = S[tab[x + cn * 2]] * 6 + (S[tab[x + cn]] + S[tab[x + cn * 3]]) * 4 +
+							S[tab[x]] + S[tab[x + cn * 4]];
 					}
 
 					if (x == dsize.width)
@@ -875,15 +945,17 @@ namespace cv
 
 					if (cn == 1)
 					{
+						// the vector loads also read the element after the last one used
+						x = pyrDownVecH(S, row, x, width0 - 1);
 						for (; x < width0; x++)
-							row[x] = src[x * 2] * 6 + (src[x * 2 - 1] + src[x * 2 + 1]) * 4 +
-							src[x * 2 - 2] + src[x * 2 + 2];
+							row[x] = S[x * 2] * 6 + (S[x * 2 - 1] + S[x * 2 + 1]) * 4 +
+							S[x * 2 - 2] + S[x * 2 + 2];
 					}
 					else if (cn == 3)
 					{
 						for (; x < width0; x += 3)
 						{
-							const T* s = src + x * 2;
+							const T* s = S + x * 2;
 							WT t0 = s[0] * 6 + (s[-3] + s[3]) * 4 + s[-6] + s[6];
 							WT t1 = s[1] * 6 + (s[-2] + s[4]) * 4 + s[-5] + s[7];
 							WT t2 = s[2] * 6 + (s[-1] + s[5]) * 4 + s[-4] + s[8];
@@ -894,7 +966,7 @@ namespace cv
 					{
 						for (; x < width0; x += 4)
 						{
-							const T* s = src + x * 2;
+							const T* s = S + x * 2;
 							WT t0 = s[0] * 6 + (s[-4] + s[4]) * 4 + s[-8] + s[8];
 							WT t1 = s[1] * 6 + (s[-3] + s[5]) * 4 + s[-7] + s[9];
 							row[x] = t0; row[x + 1] = t1;
@@ -908,8 +980,8 @@ namespace cv
 						for (; x < width0; x++)
 						{
 							int sx = tabM[x];
-							row[x] = src[sx] * 6 + (src[sx - cn] + src[sx + cn]) * 4 +
-								src[sx - cn * 2] + src[sx + cn * 2];
+							row[x] = S[sx] * 6 + (S[sx - cn] + S[sx + cn]) * 4 +
+								S[sx - cn * 2] + S[sx + cn * 2];
 						}
 					}
 
@@ -923,15 +995,72 @@ namespace cv
 				rows[k] = buf + ((y * 2 - PD_SZ / 2 + k - sy0) % PD_SZ)*bufstep;
 			row0 = rows[0]; row1 = rows[1]; row2 = rows[2]; row3 = rows[3]; row4 = rows[4];
 
-			x = vecOp(rows, dst, (int)_dst.step, dsize.width);
+			x = vecOp(rows, D, (int)dst.step, dsize.width);
 			for (; x < dsize.width; x++)
-				dst[x] = castOp(row2[x] * 6 + (row1[x] + row3[x]) * 4 + row0[x] + row4[x]);
+				D[x] = castOp(row2[x] * 6 + (row1[x] + row3[x]) * 4 + row0[x] + row4[x]);
 		}
+
+	private:
+		Mat src, dst;
+		int borderType;
+		Size ssize, dsize;
+		int cn, bufstep, width0, sy0, sy;
+		AutoBuffer<WT> _buf;
+		WT* buf;
+		int tabL[CV_CN_MAX*(PD_SZ + 2)], tabR[CV_CN_MAX*(PD_SZ + 2)];
+		AutoBuffer<int> _tabM;
+		int* tabM;
+		CastOp castOp;
+		VecOp vecOp;
+	};
+
+	// computes the destination rows range.start..range.end-1
+	template<class CastOp, class VecOp> void
+		pyrDown_(const Mat& _src, Mat& _dst, int borderType, const Range& range)
+	{
+		PyrDownLevel<CastOp, VecOp> level(_src, _dst, borderType, range.start);
+		for (int y = range.start; y < range.end; y++)
+			level.processRow(y);
 	}
 
+	// the number of rows of a pyrDown level that can be computed from the first srcDone rows of
+	// its source: the destination row y reads the source rows up to 2*y + 2
+	static inline int pyrDownReadyRows(int srcDone, int srcRows, int dstRows)
+	{
+		return srcDone == srcRows ? dstRows : srcDone >= 3 ? (srcDone - 3) / 2 + 1 : 0;
+	}
+
+	// Builds the levels 1..pyr.size()-1 in a single pass over pyr[0]: a row of a level is computed
+	// as soon as the rows of the previous level it reads exist, so the levels are read back while
+	// they are still in cache and only the source image is streamed from memory.
+	template<class CastOp, class VecOp> void
+		pyrDownFused_(const std::vector<Mat>& pyr, int borderType)
+	{
+		typedef PyrDownLevel<CastOp, VecOp> Level;
+		int k, maxlevel = (int)pyr.size() - 1;
+		std::vector<Ptr<Level> > levels(maxlevel + 1);
+		std::vector<int> done(maxlevel + 1, 0);
+
+		for (k = 1; k <= maxlevel; k++)
+			levels[k] = makePtr<Level>(pyr[k - 1], pyr[k], borderType, 0);
+
+		for (int y = 0; y < pyr[1].rows; y++)
+		{
+			levels[1]->processRow(y);
+			done[1] = y + 1;
 
+			for (k = 2; k <= maxlevel; k++)
+			{
+				int ready = pyrDownReadyRows(done[k - 1], pyr[k - 1].rows, pyr[k].rows);
+				for (; done[k] < ready; done[k]++)
+					levels[k]->processRow(done[k]);
+			}
+		}
+	}
+
+	// computes the destination rows produced by the source rows range.start..range.end-1
 	template<class CastOp, class VecOp> void
-		pyrUp_(const Mat& _src, Mat& _dst, int)
+		pyrUp_(const Mat& _src, Mat& _dst, int, const Range& range)
 	{
 		const int PU_SZ = 3;
 		typedef typename CastOp::type1 WT;
@@ -951,7 +1080,7 @@ namespace cv
 
 		CV_Assert(std::abs(dsize.width - ssize.width * 2) == dsize.width % 2 &&
 			std::abs(dsize.height - ssize.height * 2) == dsize.height % 2);
-		int k, x, sy0 = -PU_SZ / 2, sy = sy0;
+		int k, x, sy0 = range.start - PU_SZ / 2, sy = sy0;
 
 		ssize.width *= cn;
 		dsize.width *= cn;
@@ -959,7 +1088,7 @@ namespace cv
 		for (x = 0; x < ssize.width; x++)
 			dtab[x] = (x / cn) * 2 * cn + x % cn;
 
-		for (int y = 0; y < ssize.height; y++)
+		for (int y = range.start; y < range.end; y++)
 		{
 			T* dst0 = _dst.ptr<T>(y * 2);
 			T* dst1 = _dst.ptr<T>(std::min(y * 2 + 1, dsize.height - 1));
@@ -1022,7 +1151,7 @@ namespace cv
 			}
 		}
 
-		if (dsize.height > ssize.height * 2)
+		if (dsize.height > ssize.height * 2 && range.end == ssize.height)
 		{
 			T* dst0 = _dst.ptr<T>(ssize.height * 2 - 2);
 			T* dst2 = _dst.ptr<T>(ssize.height * 2);
@@ -1034,7 +1163,79 @@ namespace cv
 		}
 	}
 
-	typedef void(*PyrFunc)(const Mat&, Mat&, int);
+	typedef void(*PyrFunc)(const Mat&, Mat&, int, const Range&);
+
+	// every stripe refills its own ring buffer, so stripes are kept reasonably tall
+	static const int PYR_STRIPE_MIN_ROWS = 16;
+
+	class PyrInvoker : public ParallelLoopBody
+	{
+	public:
+		PyrInvoker(PyrFunc _func, const Mat& _src, Mat& _dst, int _borderType) :
+			func(_func), src(&_src), dst(&_dst), borderType(_borderType)
+		{}
+
+		void operator()(const Range& range) const
+		{
+			func(*src, *dst, borderType, range);
+		}
+
+	private:
+		PyrFunc func;
+		const Mat* src;
+		Mat* dst;
+		int borderType;
+	};
+
+	// runs func over the given rows in stripes of at least PYR_STRIPE_MIN_ROWS rows and about 64K
+	// destination pixels each
+	static void parallelPyr(PyrFunc func, const Mat& src, Mat& dst, int borderType, int rows)
+	{
+		int nstripes = std::min(rows / PYR_STRIPE_MIN_ROWS, cvRound(dst.total() / (double)(1 << 16)));
+		parallel_for_(Range(0, rows), PyrInvoker(func, src, dst, borderType), std::max(nstripes, 1));
+	}
+
+	static PyrFunc getPyrDownFunc(int depth)
+	{
+		if (depth == CV_8U)
+			return pyrDown_<FixPtCast<uchar, 8>, PyrDownVec_32s8u>;
+		if (depth == CV_16S)
+			return pyrDown_<FixPtCast<short, 8>, PyrDownVec_32s16s >;
+		if (depth == CV_16U)
+			return pyrDown_<FixPtCast<ushort, 8>, PyrDownVec_32s16u >;
+		if (depth == CV_32F)
+			return pyrDown_<FltCast<float, 8>, PyrDownVec_32f>;
+		if (depth == CV_64F)
+			return pyrDown_<FltCast<double, 8>, PyrDownNoVec<double, double> >;
+		CV_Error(CV_StsUnsupportedFormat, "");
+		return 0;
+	}
+
+	typedef void(*PyrFusedFunc)(const std::vector<Mat>&, int);
+
+	static PyrFusedFunc getPyrDownFusedFunc(int depth)
+	{
+		if (depth == CV_8U)
+			return pyrDownFused_<FixPtCast<uchar, 8>, PyrDownVec_32s8u>;
+		if (depth == CV_16S)
+			return pyrDownFused_<FixPtCast<short, 8>, PyrDownVec_32s16s >;
+		if (depth == CV_16U)
+			return pyrDownFused_<FixPtCast<ushort, 8>, PyrDownVec_32s16u >;
+		if (depth == CV_32F)
+			return pyrDownFused_<FltCast<float, 8>, PyrDownVec_32f>;
+		if (depth == CV_64F)
+			return pyrDownFused_<FltCast<double, 8>, PyrDownNoVec<double, double> >;
+		CV_Error(CV_StsUnsupportedFormat, "");
+		return 0;
+	}
+
+	// whether the rows of a level only depend on the nearby rows of the previous level, which is
+	// not the case for BORDER_WRAP
+	static bool isPyrStreamable(int borderType)
+	{
+		borderType &= ~BORDER_ISOLATED;
+		return borderType == BORDER_REPLICATE || borderType == BORDER_REFLECT || borderType == BORDER_REFLECT_101;
+	}
 
 #ifdef HAVE_OPENCL
 
@@ -1325,21 +1526,7 @@ void cv::pyrDown(InputArray _src, OutputArray _dst, const Size& _dsz, int border
 		ipp_pyrdown(_src, _dst, _dsz, borderType));
 
 
-	PyrFunc func = 0;
-	if (depth == CV_8U)
-		func = pyrDown_<FixPtCast<uchar, 8>, PyrDownVec_32s8u>;
-	else if (depth == CV_16S)
-		func = pyrDown_<FixPtCast<short, 8>, PyrDownVec_32s16s >;
-	else if (depth == CV_16U)
-		func = pyrDown_<FixPtCast<ushort, 8>, PyrDownVec_32s16u >;
-	else if (depth == CV_32F)
-		func = pyrDown_<FltCast<float, 8>, PyrDownVec_32f>;
-	else if (depth == CV_64F)
-		func = pyrDown_<FltCast<double, 8>, PyrDownNoVec<double, double> >;
-	else
-		CV_Error(CV_StsUnsupportedFormat, "");
-
-	func(src, dst, borderType);
+	parallelPyr(getPyrDownFunc(depth), src, dst, borderType, dst.rows);
 }
 
 
@@ -1447,7 +1634,7 @@ void cv::pyrUp(InputArray _src, OutputArray _dst, const Size& _dsz, int borderTy
 	else
 		CV_Error(CV_StsUnsupportedFormat, "");
 
-	func(src, dst, borderType);
+	parallelPyr(func, src, dst, borderType, src.rows);
 }
 
 
@@ -1566,6 +1753,82 @@ namespace cv
 }
 #endif
 
+namespace cv
+{
+	struct PyrDownTask
+	{
+		int level;
+		Range rows;
+	};
+
+	class PyrDownTasksInvoker : public ParallelLoopBody
+	{
+	public:
+		PyrDownTasksInvoker(PyrFunc _func, const std::vector<Mat>& _pyr, const std::vector<PyrDownTask>& _tasks,
+			int _borderType) :
+			func(_func), pyr(&_pyr), tasks(&_tasks), borderType(_borderType)
+		{}
+
+		void operator()(const Range& range) const
+		{
+			for (int i = range.start; i < range.end; i++)
+			{
+				const PyrDownTask& task = (*tasks)[i];
+				Mat dst = (*pyr)[task.level];
+				func((*pyr)[task.level - 1], dst, borderType, task.rows);
+			}
+		}
+
+	private:
+		PyrFunc func;
+		const std::vector<Mat>* pyr;
+		const std::vector<PyrDownTask>* tasks;
+		int borderType;
+	};
+
+	// number of steps the first level is produced in by the pipelined buildPyramid
+	static const int PYR_PIPELINE_STEPS = 8;
+
+	/*
+	 Builds the levels 1..pyr.size()-1 as a wavefront: in every step each level gets the next
+	 chunk of the rows whose source rows have been completed by the previous steps, so the
+	 level k+1 starts as soon as the first rows of the level k exist and all levels are
+	 processed concurrently instead of one after another.
+	*/
+	static void buildPyramidPipelined(PyrFunc func, const std::vector<Mat>& pyr, int borderType)
+	{
+		int k, maxlevel = (int)pyr.size() - 1;
+		std::vector<int> done(maxlevel + 1, 0), next(maxlevel + 1, 0);
+		std::vector<PyrDownTask> tasks;
+		int chunk = std::max(pyr[1].rows / PYR_PIPELINE_STEPS, PYR_STRIPE_MIN_ROWS);
+
+		done[0] = next[0] = pyr[0].rows;
+		while (done[maxlevel] < pyr[maxlevel].rows)
+		{
+			tasks.clear();
+			for (k = 1; k <= maxlevel; k++)
+			{
+				int ready = pyrDownReadyRows(done[k - 1], pyr[k - 1].rows, pyr[k].rows);
+				int y = done[k], y1 = std::min(ready, y + std::max(chunk >> (k - 1), PYR_STRIPE_MIN_ROWS));
+
+				for (; y < y1; )
+				{
+					PyrDownTask task;
+					task.level = k;
+					task.rows = Range(y, y1 - y < PYR_STRIPE_MIN_ROWS * 2 ? y1 : y + PYR_STRIPE_MIN_ROWS);
+					tasks.push_back(task);
+					y = task.rows.end;
+				}
+				next[k] = y;
+			}
+
+			parallel_for_(Range(0, (int)tasks.size()), PyrDownTasksInvoker(func, pyr, tasks, borderType),
+				(double)tasks.size());
+			done = next;
+		}
+	}
+}
+
 void cv::buildPyramid(InputArray _src, OutputArrayOfArrays _dst, int maxlevel, int borderType)
 {
 	CV_INSTRUMENT_REGION()
@@ -1591,6 +1854,23 @@ void cv::buildPyramid(InputArray _src, OutputArrayOfArrays _dst, int maxlevel, i
 	CV_IPP_RUN(((IPP_VERSION_X100 >= 810) && ((borderType & ~BORDER_ISOLATED) == BORDER_DEFAULT && (!_src.isSubmatrix() || ((borderType & BORDER_ISOLATED) != 0)))),
 		ipp_buildpyramid(_src, _dst, maxlevel, borderType));
 
+	if (i == 1 && maxlevel > 1 && isPyrStreamable(borderType))
+	{
+		std::vector<Mat> pyr(maxlevel + 1);
+		pyr[0] = src;
+		for (; i <= maxlevel; i++)
+		{
+			Mat& level = _dst.getMatRef(i);
+			level.create((pyr[i - 1].rows + 1) / 2, (pyr[i - 1].cols + 1) / 2, src.type());
+			pyr[i] = level;
+		}
+		if (getNumThreads() > 1 && src.total() >= (size_t)(1 << 18))
+			buildPyramidPipelined(getPyrDownFunc(src.depth()), pyr, borderType);
+		else
+			getPyrDownFusedFunc(src.depth())(pyr, borderType);
+		return;
+	}
+
 	for (; i <= maxlevel; i++)
 		pyrDown(_dst.getMatRef(i - 1), _dst.getMatRef(i), Size(), borderType);
 }
@@ -1341,6 +1341,31 @@ cv::Ptr<cv::FilterEngine> cv::createBoxFilter(int srcType, int dstType, Size ksi
 		srcType, dstType, sumType, borderType);
 }
 
+namespace cv
+{
+	class BoxFilterEngineFactory : public FilterEngineFactory
+	{
+	public:
+		BoxFilterEngineFactory(int _srcType, int _dstType, Size _ksize, Point _anchor, bool _normalize,
+			int _borderType) :
+			srcType(_srcType), dstType(_dstType), ksize(_ksize), anchor(_anchor), normalize(_normalize),
+			borderType(_borderType)
+		{}
+
+		Ptr<FilterEngine> create() const
+		{
+			return createBoxFilter(srcType, dstType, ksize, anchor, normalize, borderType);
+		}
+
+	private:
+		int srcType, dstType;
+		Size ksize;
+		Point anchor;
+		bool normalize;
+		int borderType;
+	};
+}
+
 #ifdef HAVE_OPENVX
 namespace cv
 {
@@ -1512,10 +1537,8 @@ void cv::boxFilter(InputArray _src, OutputArray _dst, int ddepth,
 
 	borderType = (borderType&~BORDER_ISOLATED);
 
-	Ptr<FilterEngine> f = createBoxFilter(src.type(), dst.type(),
-		ksize, anchor, normalize, borderType);
-
-	f->apply(src, dst, wsz, ofs);
+	applyFilterEngine(BoxFilterEngineFactory(src.type(), dst.type(), ksize, anchor, normalize, borderType),
+		src, dst, wsz, ofs);
 }
 
 
@@ -1600,6 +1623,34 @@ namespace cv
 		return Ptr<BaseRowFilter>();
 	}
 
+	class SqrBoxFilterEngineFactory : public FilterEngineFactory
+	{
+	public:
+		SqrBoxFilterEngineFactory(int _srcType, int _dstType, int _sumType, Size _ksize, Point _anchor,
+			bool _normalize, int _borderType) :
+			srcType(_srcType), dstType(_dstType), sumType(_sumType), ksize(_ksize), anchor(_anchor),
+			normalize(_normalize), borderType(_borderType)
+		{}
+
+		Ptr<FilterEngine> create() const
+		{
+			Ptr<BaseRowFilter> rowFilter = getSqrRowSumFilter(srcType, sumType, ksize.width, anchor.x);
+			Ptr<BaseColumnFilter> columnFilter = getColumnSumFilter(sumType,
+				dstType, ksize.height, anchor.y,
+				normalize ? 1. / (ksize.width*ksize.height) : 1);
+
+			return makePtr<FilterEngine>(Ptr<BaseFilter>(), rowFilter, columnFilter,
+				srcType, dstType, sumType, borderType);
+		}
+
+	private:
+		int srcType, dstType, sumType;
+		Size ksize;
+		Point anchor;
+		bool normalize;
+		int borderType;
+	};
+
 }
 
 void cv::sqrBoxFilter(InputArray _src, OutputArray _dst, int ddepth,
@@ -1634,18 +1685,12 @@ void cv::sqrBoxFilter(InputArray _src, OutputArray _dst, int ddepth,
 	_dst.create(size, dstType);
 	Mat dst = _dst.getMat();
 
-	Ptr<BaseRowFilter> rowFilter = getSqrRowSumFilter(srcType, sumType, ksize.width, anchor.x);
-	Ptr<BaseColumnFilter> columnFilter = getColumnSumFilter(sumType,
-		dstType, ksize.height, anchor.y,
-		normalize ? 1. / (ksize.width*ksize.height) : 1);
-
-	Ptr<FilterEngine> f = makePtr<FilterEngine>(Ptr<BaseFilter>(), rowFilter, columnFilter,
-		srcType, dstType, sumType, borderType);
 	Point ofs;
 	Size wsz(src.cols, src.rows);
 	src.locateROI(wsz, ofs);
 
-	f->apply(src, dst, wsz, ofs);
+	applyFilterEngine(SqrBoxFilterEngineFactory(srcType, dstType, sumType, ksize, anchor, normalize, borderType),
+		src, dst, wsz, ofs);
 }
 
 
@@ -524,76 +524,41 @@ namespace cv
 
 #include "../../core/include/opencv2/core/hal/hal.hpp"
 
-	void crossCorr(const Mat& img, const Mat& _templ, Mat& corr,
-		Size corrsize, int ctype,
-		Point anchor, double delta, int borderType)
+	// picks the correlation block size and the DFT size used to process each block
+	static void getCrossCorrBlockSize(Size templSize, Size corrSize, Size& blocksize, Size& dftsize)
 	{
 		const double blockScale = 4.5;
 		const int minBlockSize = 256;
-		std::vector<uchar> buf;
-
-		Mat templ = _templ;
-		int depth = img.depth(), cn = img.channels();
-		int tdepth = templ.depth(), tcn = templ.channels();
-		int cdepth = CV_MAT_DEPTH(ctype), ccn = CV_MAT_CN(ctype);
-
-		CV_Assert(img.dims <= 2 && templ.dims <= 2 && corr.dims <= 2);
-
-		if (depth != tdepth && tdepth != std::max(CV_32F, depth))
-		{
-			_templ.convertTo(templ, std::max(CV_32F, depth));
-			tdepth = templ.depth();
-		}
-
-		CV_Assert(depth == tdepth || tdepth == CV_32F);
-		CV_Assert(corrsize.height <= img.rows + templ.rows - 1 &&
-			corrsize.width <= img.cols + templ.cols - 1);
-
-		CV_Assert(ccn == 1 || delta == 0);
-
-		corr.create(corrsize, ctype);
-
-		int maxDepth = depth > CV_8S ? CV_64F : std::max(std::max(CV_32F, tdepth), cdepth);
-		Size blocksize, dftsize;
 
-		blocksize.width = cvRound(templ.cols*blockScale);
-		blocksize.width = std::max(blocksize.width, minBlockSize - templ.cols + 1);
-		blocksize.width = std::min(blocksize.width, corr.cols);
-		blocksize.height = cvRound(templ.rows*blockScale);
-		blocksize.height = std::max(blocksize.height, minBlockSize - templ.rows + 1);
-		blocksize.height = std::min(blocksize.height, corr.rows);
+		blocksize.width = cvRound(templSize.width*blockScale);
+		blocksize.width = std::max(blocksize.width, minBlockSize - templSize.width + 1);
+		blocksize.width = std::min(blocksize.width, corrSize.width);
+		blocksize.height = cvRound(templSize.height*blockScale);
+		blocksize.height = std::max(blocksize.height, minBlockSize - templSize.height + 1);
+		blocksize.height = std::min(blocksize.height, corrSize.height);
 
-		dftsize.width = std::max(getOptimalDFTSize(blocksize.width + templ.cols - 1), 2);
-		dftsize.height = getOptimalDFTSize(blocksize.height + templ.rows - 1);
+		dftsize.width = std::max(getOptimalDFTSize(blocksize.width + templSize.width - 1), 2);
+		dftsize.height = getOptimalDFTSize(blocksize.height + templSize.height - 1);
 		if (dftsize.width <= 0 || dftsize.height <= 0)
 			CV_Error(CV_StsOutOfRange, "the input arrays are too big");
 
 		// recompute block size
-		blocksize.width = dftsize.width - templ.cols + 1;
-		blocksize.width = MIN(blocksize.width, corr.cols);
-		blocksize.height = dftsize.height - templ.rows + 1;
-		blocksize.height = MIN(blocksize.height, corr.rows);
-
-		Mat dftTempl(dftsize.height*tcn, dftsize.width, maxDepth);
-		Mat dftImg(dftsize, maxDepth);
-
-		int i, k, bufSize = 0;
-		if (tcn > 1 && tdepth != maxDepth)
-			bufSize = templ.cols*templ.rows*CV_ELEM_SIZE(tdepth);
-
-		if (cn > 1 && depth != maxDepth)
-			bufSize = std::max(bufSize, (blocksize.width + templ.cols - 1)*
-			(blocksize.height + templ.rows - 1)*CV_ELEM_SIZE(depth));
+		blocksize.width = dftsize.width - templSize.width + 1;
+		blocksize.width = MIN(blocksize.width, corrSize.width);
+		blocksize.height = dftsize.height - templSize.height + 1;
+		blocksize.height = MIN(blocksize.height, corrSize.height);
+	}
 
-		if ((ccn > 1 || cn > 1) && cdepth != maxDepth)
-			bufSize = std::max(bufSize, blocksize.width*blocksize.height*CV_ELEM_SIZE(cdepth));
+	// stores the DFT of every template plane into dftTempl, one dftsize.height-row band per plane
+	static void getTemplateSpectrum(const Mat& templ, Size dftsize, int maxDepth, Mat& dftTempl, uchar* buf)
+	{
+		int tdepth = templ.depth(), tcn = templ.channels();
 
-		buf.resize(bufSize);
+		dftTempl.create(dftsize.height*tcn, dftsize.width, maxDepth);
 
-		Ptr<hal::DFT2D> c = hal::DFT2D::create(dftsize.width, dftsize.height, dftTempl.depth(), 1, 1, CV_HAL_DFT_IS_INPLACE, templ.rows);
+		Ptr<hal::DFT2D> c = hal::DFT2D::create(dftsize.width, dftsize.height, maxDepth, 1, 1, CV_HAL_DFT_IS_INPLACE, templ.rows);
 
-		// compute DFT of each template plane
-		for (k = 0; k < tcn; k++)
+		for (int k = 0; k < tcn; k++)
 		{
 			int yofs = k * dftsize.height;
 			Mat src = templ;
@@ -602,7 +567,7 @@ namespace cv
 
 			if (tcn > 1)
 			{
-				src = tdepth == maxDepth ? dst1 : Mat(templ.size(), tdepth, &buf[0]);
+				src = tdepth == maxDepth ? dst1 : Mat(templ.size(), tdepth, buf);
 				int pairs[] = { k, 0 };
 				mixChannels(&templ, 1, &src, 1, pairs, 1);
 			}
@@ -617,110 +582,205 @@ namespace cv
 			}
 			c->apply(dst.data, (int)dst.step, dst.data, (int)dst.step);
 		}
+	}
 
-		int tileCountX = (corr.cols + blocksize.width - 1) / blocksize.width;
-		int tileCountY = (corr.rows + blocksize.height - 1) / blocksize.height;
-		int tileCount = tileCountX * tileCountY;
-
-		Size wholeSize = img.size();
-		Point roiofs(0, 0);
-		Mat img0 = img;
-
-		if (!(borderType & BORDER_ISOLATED))
+	// correlates the image blocks [range.start, range.end) with the template spectrum.
+	// The blocks write disjoint parts of corr, so each stripe only needs its own
+	// DFT plans (they keep internal buffers) and scratch memory.
+	class CrossCorrInvoker : public ParallelLoopBody
+	{
+	public:
+		CrossCorrInvoker(const Mat& _img0, Point _roiofs, const Mat& _dftTempl, Size _templSize, int _tcn,
+			Mat& _corr, Size _blocksize, Size _dftsize, int _maxDepth, int _bufSize,
+			Point _anchor, double _delta, int _borderType)
+			: img0(_img0), roiofs(_roiofs), dftTempl(_dftTempl), templSize(_templSize), tcn(_tcn),
+			corr(_corr), blocksize(_blocksize), dftsize(_dftsize), maxDepth(_maxDepth), bufSize(_bufSize),
+			anchor(_anchor), delta(_delta), borderType(_borderType)
 		{
-			img.locateROI(wholeSize, roiofs);
-			img0.adjustROI(roiofs.y, wholeSize.height - img.rows - roiofs.y,
-				roiofs.x, wholeSize.width - img.cols - roiofs.x);
+			tileCountX = (corr.cols + blocksize.width - 1) / blocksize.width;
 		}
-		borderType |= BORDER_ISOLATED;
-
-		Ptr<hal::DFT2D> cF, cR;
-		int f = CV_HAL_DFT_IS_INPLACE;
-		int f_inv = f | CV_HAL_DFT_INVERSE | CV_HAL_DFT_SCALE;
-		cF = hal::DFT2D::create(dftsize.width, dftsize.height, maxDepth, 1, 1, f, blocksize.height + templ.rows - 1);
-		cR = hal::DFT2D::create(dftsize.width, dftsize.height, maxDepth, 1, 1, f_inv, blocksize.height);
 
-		// calculate correlation by blocks
-		for (i = 0; i < tileCount; i++)
+		void operator()(const Range& range) const
 		{
-			int x = (i%tileCountX)*blocksize.width;
-			int y = (i / tileCountX)*blocksize.height;
-
-			Size bsz(std::min(blocksize.width, corr.cols - x),
-				std::min(blocksize.height, corr.rows - y));
-			Size dsz(bsz.width + templ.cols - 1, bsz.height + templ.rows - 1);
-			int x0 = x - anchor.x + roiofs.x, y0 = y - anchor.y + roiofs.y;
-			int x1 = std::max(0, x0), y1 = std::max(0, y0);
-			int x2 = std::min(img0.cols, x0 + dsz.width);
-			int y2 = std::min(img0.rows, y0 + dsz.height);
-			Mat src0(img0, Range(y1, y2), Range(x1, x2));
-			Mat dst(dftImg, Rect(0, 0, dsz.width, dsz.height));
-			Mat dst1(dftImg, Rect(x1 - x0, y1 - y0, x2 - x1, y2 - y1));
-			Mat cdst(corr, Rect(x, y, bsz.width, bsz.height));
-
-			for (k = 0; k < cn; k++)
-			{
-				Mat src = src0;
-				dftImg = Scalar::all(0);
+			int depth = img0.depth(), cn = img0.channels();
+			int cdepth = corr.depth(), ccn = corr.channels();
+
+			std::vector<uchar> buf(bufSize);
+			Mat dftImg(dftsize, maxDepth);
 
-				if (cn > 1)
+			int f = CV_HAL_DFT_IS_INPLACE;
+			int f_inv = f | CV_HAL_DFT_INVERSE | CV_HAL_DFT_SCALE;
+			Ptr<hal::DFT2D> cF = hal::DFT2D::create(dftsize.width, dftsize.height, maxDepth, 1, 1, f, blocksize.height + templSize.height - 1);
+			Ptr<hal::DFT2D> cR = hal::DFT2D::create(dftsize.width, dftsize.height, maxDepth, 1, 1, f_inv, blocksize.height);
+
+			for (int i = range.start; i < range.end; i++)
+			{
+				int x = (i%tileCountX)*blocksize.width;
+				int y = (i / tileCountX)*blocksize.height;
+
+				Size bsz(std::min(blocksize.width, corr.cols - x),
+					std::min(blocksize.height, corr.rows - y));
+				Size dsz(bsz.width + templSize.width - 1, bsz.height + templSize.height - 1);
+				int x0 = x - anchor.x + roiofs.x, y0 = y - anchor.y + roiofs.y;
+				int x1 = std::max(0, x0), y1 = std::max(0, y0);
+				int x2 = std::min(img0.cols, x0 + dsz.width);
+				int y2 = std::min(img0.rows, y0 + dsz.height);
+				Mat src0(img0, Range(y1, y2), Range(x1, x2));
+				Mat dst(dftImg, Rect(0, 0, dsz.width, dsz.height));
+				Mat dst1(dftImg, Rect(x1 - x0, y1 - y0, x2 - x1, y2 - y1));
+				Mat cdst(corr, Rect(x, y, bsz.width, bsz.height));
+
+				for (int k = 0; k < cn; k++)
 				{
-					src = depth == maxDepth ? dst1 : Mat(y2 - y1, x2 - x1, depth, &buf[0]);
-					int pairs[] = { k, 0 };
-					mixChannels(&src0, 1, &src, 1, pairs, 1);
-				}
+					Mat src = src0;
+					dftImg = Scalar::all(0);
 
-				if (dst1.data != src.data)
-					src.convertTo(dst1, dst1.depth());
+					if (cn > 1)
+					{
+						src = depth == maxDepth ? dst1 : Mat(y2 - y1, x2 - x1, depth, &buf[0]);
+						int pairs[] = { k, 0 };
+						mixChannels(&src0, 1, &src, 1, pairs, 1);
+					}
 
-				if (x2 - x1 < dsz.width || y2 - y1 < dsz.height)
-					copyMakeBorder(dst1, dst, y1 - y0, dst.rows - dst1.rows - (y1 - y0),
-						x1 - x0, dst.cols - dst1.cols - (x1 - x0), borderType);
+					if (dst1.data != src.data)
+						src.convertTo(dst1, dst1.depth());
 
-				if (bsz.height == blocksize.height)
-					cF->apply(dftImg.data, (int)dftImg.step, dftImg.data, (int)dftImg.step);
-				else
-					dft(dftImg, dftImg, 0, dsz.height);
+					if (x2 - x1 < dsz.width || y2 - y1 < dsz.height)
+						copyMakeBorder(dst1, dst, y1 - y0, dst.rows - dst1.rows - (y1 - y0),
+							x1 - x0, dst.cols - dst1.cols - (x1 - x0), borderType);
 
-				Mat dftTempl1(dftTempl, Rect(0, tcn > 1 ? k * dftsize.height : 0,
-					dftsize.width, dftsize.height));
-				mulSpectrums(dftImg, dftTempl1, dftImg, 0, true);
+					if (bsz.height == blocksize.height)
+						cF->apply(dftImg.data, (int)dftImg.step, dftImg.data, (int)dftImg.step);
+					else
+						dft(dftImg, dftImg, 0, dsz.height);
 
-				if (bsz.height == blocksize.height)
-					cR->apply(dftImg.data, (int)dftImg.step, dftImg.data, (int)dftImg.step);
-				else
-					dft(dftImg, dftImg, DFT_INVERSE + DFT_SCALE, bsz.height);
+					Mat dftTempl1(dftTempl, Rect(0, tcn > 1 ? k * dftsize.height : 0,
+						dftsize.width, dftsize.height));
+					mulSpectrums(dftImg, dftTempl1, dftImg, 0, true);
+
+					if (bsz.height == blocksize.height)
+						cR->apply(dftImg.data, (int)dftImg.step, dftImg.data, (int)dftImg.step);
+					else
+						dft(dftImg, dftImg, DFT_INVERSE + DFT_SCALE, bsz.height);
 
-				src = dftImg(Rect(0, 0, bsz.width, bsz.height));
+					src = dftImg(Rect(0, 0, bsz.width, bsz.height));
 
-				if (ccn > 1)
-				{
-					if (cdepth != maxDepth)
+					if (ccn > 1)
 					{
-						Mat plane(bsz, cdepth, &buf[0]);
-						src.convertTo(plane, cdepth, 1, delta);
-						src = plane;
+						if (cdepth != maxDepth)
+						{
+							Mat plane(bsz, cdepth, &buf[0]);
+							src.convertTo(plane, cdepth, 1, delta);
+							src = plane;
+						}
+						int pairs[] = { 0, k };
+						mixChannels(&src, 1, &cdst, 1, pairs, 1);
 					}
-					int pairs[] = { 0, k };
-					mixChannels(&src, 1, &cdst, 1, pairs, 1);
-				}
-				else
-				{
-					if (k == 0)
-						src.convertTo(cdst, cdepth, 1, delta);
 					else
 					{
-						if (maxDepth != cdepth)
+						if (k == 0)
+							src.convertTo(cdst, cdepth, 1, delta);
+						else
 						{
-							Mat plane(bsz, cdepth, &buf[0]);
-							src.convertTo(plane, cdepth);
-							src = plane;
+							if (maxDepth != cdepth)
+							{
+								Mat plane(bsz, cdepth, &buf[0]);
+								src.convertTo(plane, cdepth);
+								src = plane;
+							}
+							add(src, cdst, cdst);
 						}
-						add(src, cdst, cdst);
 					}
 				}
 			}
 		}
+
+	private:
+		Mat img0;
+		Point roiofs;
+		Mat dftTempl;
+		Size templSize;
+		int tcn;
+		Mat corr;
+		Size blocksize, dftsize;
+		int maxDepth, bufSize;
+		Point anchor;
+		double delta;
+		int borderType;
+		int tileCountX;
+	};
+
+	void crossCorr(const Mat& img, const Mat& _templ, Mat& corr,
+		Size corrsize, int ctype,
+		Point anchor, double delta, int borderType)
+	{
+		std::vector<uchar> buf;
+
+		Mat templ = _templ;
+		int depth = img.depth(), cn = img.channels();
+		int tdepth = templ.depth(), tcn = templ.channels();
+		int cdepth = CV_MAT_DEPTH(ctype), ccn = CV_MAT_CN(ctype);
+
+		CV_Assert(img.dims <= 2 && templ.dims <= 2 && corr.dims <= 2);
+
+		if (depth != tdepth && tdepth != std::max(CV_32F, depth))
+		{
+			_templ.convertTo(templ, std::max(CV_32F, depth));
+			tdepth = templ.depth();
+		}
+
+		CV_Assert(depth == tdepth || tdepth == CV_32F);
+		CV_Assert(corrsize.height <= img.rows + templ.rows - 1 &&
+			corrsize.width <= img.cols + templ.cols - 1);
+
+		CV_Assert(ccn == 1 || delta == 0);
+
+		corr.create(corrsize, ctype);
+
+		int maxDepth = depth > CV_8S ? CV_64F : std::max(std::max(CV_32F, tdepth), cdepth);
+		Size blocksize, dftsize;
+		getCrossCorrBlockSize(templ.size(), corr.size(), blocksize, dftsize);
+
+		int bufSize = 0;
+		if (tcn > 1 && tdepth != maxDepth)
+			bufSize = templ.cols*templ.rows*CV_ELEM_SIZE(tdepth);
+
+		buf.resize(bufSize);
+
+		// compute DFT of each template plane
+		Mat dftTempl;
+		getTemplateSpectrum(templ, dftsize, maxDepth, dftTempl, buf.empty() ? 0 : &buf[0]);
+
+		// per-block scratch size
+		bufSize = 0;
+		if (cn > 1 && depth != maxDepth)
+			bufSize = (blocksize.width + templ.cols - 1)*
+			(blocksize.height + templ.rows - 1)*CV_ELEM_SIZE(depth);
+
+		if ((ccn > 1 || cn > 1) && cdepth != maxDepth)
+			bufSize = std::max(bufSize, blocksize.width*blocksize.height*CV_ELEM_SIZE(cdepth));
+
+		int tileCountX = (corr.cols + blocksize.width - 1) / blocksize.width;
+		int tileCountY = (corr.rows + blocksize.height - 1) / blocksize.height;
+		int tileCount = tileCountX * tileCountY;
+
+		Size wholeSize = img.size();
+		Point roiofs(0, 0);
+		Mat img0 = img;
+
+		if (!(borderType & BORDER_ISOLATED))
+		{
+			img.locateROI(wholeSize, roiofs);
+			img0.adjustROI(roiofs.y, wholeSize.height - img.rows - roiofs.y,
+				roiofs.x, wholeSize.width - img.cols - roiofs.x);
+		}
+		borderType |= BORDER_ISOLATED;
+
+		// calculate correlation by blocks
+		parallel_for_(Range(0, tileCount),
+			CrossCorrInvoker(img0, roiofs, dftTempl, templ.size(), tcn, corr, blocksize, dftsize,
+				maxDepth, bufSize, anchor, delta, borderType),
+			tileCount);
 	}
 
 	static void matchTemplateMask(InputArray _img, InputArray _templ, OutputArray _result, int method, InputArray _mask)
@@ -802,66 +862,74 @@ namespace cv
 			CV_Error(Error::StsNotImplemented, "");
 	}
 
-	static void common_matchTemplate(Mat& img, Mat& templ, Mat& result, int method, int cn)
+	// computes the template mean and norm used by common_matchTemplate. Returns false when
+	// the template is flat and the CV_TM_CCOEFF_NORMED map is all ones.
+	static bool getTemplateStats(const Mat& templ, int method, Scalar& templMean, double& templNorm, double& templSum2)
 	{
-		if (method == CV_TM_CCORR)
-			return;
-
 		int numType = method == CV_TM_CCORR || method == CV_TM_CCORR_NORMED ? 0 :
 			method == CV_TM_CCOEFF || method == CV_TM_CCOEFF_NORMED ? 1 : 2;
-		bool isNormed = method == CV_TM_CCORR_NORMED ||
-			method == CV_TM_SQDIFF_NORMED ||
-			method == CV_TM_CCOEFF_NORMED;
 
 		double invArea = 1. / ((double)templ.rows * templ.cols);
 
-		Mat sum, sqsum;
-		Scalar templMean, templSdv;
-		double *q0 = 0, *q1 = 0, *q2 = 0, *q3 = 0;
-		double templNorm = 0, templSum2 = 0;
+		Scalar templSdv;
+		templNorm = templSum2 = 0;
 
 		if (method == CV_TM_CCOEFF)
 		{
-			integral(img, sum, CV_64F);
 			templMean = mean(templ);
+			return true;
 		}
-		else
-		{
-			integral(img, sum, sqsum, CV_64F);
-			meanStdDev(templ, templMean, templSdv);
 
-			templNorm = templSdv[0] * templSdv[0] + templSdv[1] * templSdv[1] + templSdv[2] * templSdv[2] + templSdv[3] * templSdv[3];
+		meanStdDev(templ, templMean, templSdv);
 
-			if (templNorm < DBL_EPSILON && method == CV_TM_CCOEFF_NORMED)
-			{
-				result = Scalar::all(1);
-				return;
-			}
+		templNorm = templSdv[0] * templSdv[0] + templSdv[1] * templSdv[1] + templSdv[2] * templSdv[2] + templSdv[3] * templSdv[3];
 
-			templSum2 = templNorm + templMean[0] * templMean[0] + templMean[1] * templMean[1] + templMean[2] * templMean[2] + templMean[3] * templMean[3];
+		if (templNorm < DBL_EPSILON && method == CV_TM_CCOEFF_NORMED)
+			return false;
 
-			if (numType != 1)
-			{
-				templMean = Scalar::all(0);
-				templNorm = templSum2;
-			}
+		templSum2 = templNorm + templMean[0] * templMean[0] + templMean[1] * templMean[1] + templMean[2] * templMean[2] + templMean[3] * templMean[3];
+
+		if (numType != 1)
+		{
+			templMean = Scalar::all(0);
+			templNorm = templSum2;
+		}
+
+		templSum2 /= invArea;
+		templNorm = std::sqrt(templNorm);
+		templNorm /= std::sqrt(invArea); // care of accuracy here
+		return true;
+	}
+
+	// turns the raw cross-correlation in result into the requested comparison, using the
+	// image integrals (sqsum is only needed by the methods other than CV_TM_CCOEFF)
+	static void normalizeMatchResult(const Mat& sum, const Mat& sqsum, Size templSize, int cn, int method,
+		const Scalar& templMean, double templNorm, double templSum2, Mat& result)
+	{
+		int numType = method == CV_TM_CCORR || method == CV_TM_CCORR_NORMED ? 0 :
+			method == CV_TM_CCOEFF || method == CV_TM_CCOEFF_NORMED ? 1 : 2;
+		bool isNormed = method == CV_TM_CCORR_NORMED ||
+			method == CV_TM_SQDIFF_NORMED ||
+			method == CV_TM_CCOEFF_NORMED;
 
-			templSum2 /= invArea;
-			templNorm = std::sqrt(templNorm);
-			templNorm /= std::sqrt(invArea); // care of accuracy here
+		double invArea = 1. / ((double)templSize.height * templSize.width);
 
+		const double *q0 = 0, *q1 = 0, *q2 = 0, *q3 = 0;
+
+		if (method != CV_TM_CCOEFF)
+		{
 			CV_Assert(sqsum.data != NULL);
-			q0 = (double*)sqsum.data;
-			q1 = q0 + templ.cols*cn;
-			q2 = (double*)(sqsum.data + templ.rows*sqsum.step);
-			q3 = q2 + templ.cols*cn;
+			q0 = (const double*)sqsum.data;
+			q1 = q0 + templSize.width*cn;
+			q2 = (const double*)(sqsum.data + templSize.height*sqsum.step);
+			q3 = q2 + templSize.width*cn;
 		}
 
 		CV_Assert(sum.data != NULL);
-		double* p0 = (double*)sum.data;
-		double* p1 = p0 + templ.cols*cn;
-		double* p2 = (double*)(sum.data + templ.rows*sum.step);
-		double* p3 = p2 + templ.cols*cn;
+		const double* p0 = (const double*)sum.data;
+		const double* p1 = p0 + templSize.width*cn;
+		const double* p2 = (const double*)(sum.data + templSize.height*sum.step);
+		const double* p3 = p2 + templSize.width*cn;
 
 		int sumstep = sum.data ? (int)(sum.step / sizeof(double)) : 0;
 		int sqstep = sqsum.data ? (int)(sqsum.step / sizeof(double)) : 0;
@@ -921,6 +989,292 @@ namespace cv
 			}
 		}
 	}
+
+	static void common_matchTemplate(Mat& img, Mat& templ, Mat& result, int method, int cn)
+	{
+		if (method == CV_TM_CCORR)
+			return;
+
+		Mat sum, sqsum;
+		Scalar templMean;
+		double templNorm = 0, templSum2 = 0;
+
+		if (method == CV_TM_CCOEFF)
+			integral(img, sum, CV_64F);
+		else
+			integral(img, sum, sqsum, CV_64F);
+
+		if (!getTemplateStats(templ, method, templMean, templNorm, templSum2))
+		{
+			result = Scalar::all(1);
+			return;
+		}
+
+		normalizeMatchResult(sum, sqsum, templ.size(), cn, method, templMean, templNorm, templSum2, result);
+	}
+
+	//////////////////////////////////////////////// TemplateMatcher ////////////////////////////////////////////////
+
+	// correlates the image blocks [range.start, range.end) with every cached template.
+	// The DFT of each image block plane is computed once; the products with the template
+	// spectra are summed over the channels so that every template needs a single inverse DFT.
+	class MultiTemplateCorrInvoker : public ParallelLoopBody
+	{
+	public:
+		MultiTemplateCorrInvoker(const Mat& _img, const std::vector<Mat>& _spectra, std::vector<Mat>& _corrs,
+			Size _maxTemplSize, Size _blocksize, Size _dftsize, int _maxDepth, int _tileCountX)
+			: img(_img), spectra(&_spectra), corrs(&_corrs), maxTemplSize(_maxTemplSize),
+			blocksize(_blocksize), dftsize(_dftsize), maxDepth(_maxDepth), tileCountX(_tileCountX)
+		{
+		}
+
+		void operator()(const Range& range) const
+		{
+			int depth = img.depth(), cn = img.channels();
+			size_t t, ntempl = corrs->size();
+			Size isz0(blocksize.width + maxTemplSize.width - 1, blocksize.height + maxTemplSize.height - 1);
+
+			std::vector<uchar> buf(cn > 1 && depth != maxDepth ? isz0.area()*CV_ELEM_SIZE(depth) : 0);
+			Mat dftImg(dftsize.height*cn, dftsize.width, maxDepth);
+			Mat dftCorr(dftsize, maxDepth), dftProd;
+			if (cn > 1)
+				dftProd.create(dftsize, maxDepth);
+
+			int f = CV_HAL_DFT_IS_INPLACE;
+			int f_inv = f | CV_HAL_DFT_INVERSE | CV_HAL_DFT_SCALE;
+			Ptr<hal::DFT2D> cF = hal::DFT2D::create(dftsize.width, dftsize.height, maxDepth, 1, 1, f, isz0.height);
+			Ptr<hal::DFT2D> cR = hal::DFT2D::create(dftsize.width, dftsize.height, maxDepth, 1, 1, f_inv, blocksize.height);
+
+			for (int i = range.start; i < range.end; i++)
+			{
+				int x = (i%tileCountX)*blocksize.width;
+				int y = (i / tileCountX)*blocksize.height;
+
+				// the block covers the outputs of the smallest template; the zero padding past
+				// the image edge only reaches the outputs that lie outside the larger templates' maps
+				Size isz(std::min(isz0.width, img.cols - x), std::min(isz0.height, img.rows - y));
+				Mat src0(img, Rect(x, y, isz.width, isz.height));
+
+				dftImg = Scalar::all(0);
+				for (int k = 0; k < cn; k++)
+				{
+					Mat plane(dftImg, Rect(0, k*dftsize.height, dftsize.width, dftsize.height));
+					Mat dst1(plane, Rect(0, 0, isz.width, isz.height));
+					Mat src = src0;
+
+					if (cn > 1)
+					{
+						src = depth == maxDepth ? dst1 : Mat(isz, depth, &buf[0]);
+						int pairs[] = { k, 0 };
+						mixChannels(&src0, 1, &src, 1, pairs, 1);
+					}
+
+					if (dst1.data != src.data)
+						src.convertTo(dst1, maxDepth);
+
+					cF->apply(plane.data, (int)plane.step, plane.data, (int)plane.step);
+				}
+
+				for (t = 0; t < ntempl; t++)
+				{
+					Mat& corr = (*corrs)[t];
+					Size bsz(std::min(blocksize.width, corr.cols - x),
+						std::min(blocksize.height, corr.rows - y));
+					if (bsz.width <= 0 || bsz.height <= 0)
+						continue;
+
+					const Mat& dftTempl = (*spectra)[t];
+					for (int k = 0; k < cn; k++)
+					{
+						Mat plane(dftImg, Rect(0, k*dftsize.height, dftsize.width, dftsize.height));
+						Mat tplane(dftTempl, Rect(0, k*dftsize.height, dftsize.width, dftsize.height));
+						if (k == 0)
+							mulSpectrums(plane, tplane, dftCorr, 0, true);
+						else
+						{
+							mulSpectrums(plane, tplane, dftProd, 0, true);
+							dftCorr += dftProd;
+						}
+					}
+
+					cR->apply(dftCorr.data, (int)dftCorr.step, dftCorr.data, (int)dftCorr.step);
+
+					Mat cdst(corr, Rect(x, y, bsz.width, bsz.height));
+					dftCorr(Rect(0, 0, bsz.width, bsz.height)).convertTo(cdst, CV_32F);
+				}
+			}
+		}
+
+	private:
+		Mat img;
+		const std::vector<Mat>* spectra;
+		std::vector<Mat>* corrs;
+		Size maxTemplSize, blocksize, dftsize;
+		int maxDepth, tileCountX;
+	};
+
+	class TemplateMatcherImpl : public TemplateMatcher
+	{
+	public:
+		TemplateMatcherImpl(int _method)
+		{
+			setMethod(_method);
+			spectraDftSize = Size();
+			spectraDepth = -1;
+			statsMethod = -1;
+		}
+
+		void add(InputArrayOfArrays _templs)
+		{
+			// a single Mat is one template, not a set of one-row templates
+			std::vector<Mat> newTempls;
+			if (_templs.isMat() || _templs.isUMat())
+				newTempls.push_back(_templs.getMat());
+			else
+				_templs.getMatVector(newTempls);
+
+			for (size_t i = 0; i < newTempls.size(); i++)
+			{
+				const Mat& templ = newTempls[i];
+				int depth = templ.depth();
+				CV_Assert((depth == CV_8U || depth == CV_32F) && templ.dims <= 2 && !templ.empty());
+				CV_Assert(templs.empty() || templ.type() == templs[0].type());
+				templs.push_back(templ.clone());
+			}
+
+			// the spectra and statistics are rebuilt for the whole set on the next match
+			spectraDftSize = Size();
+			statsMethod = -1;
+		}
+
+		void match(InputArray _image, OutputArrayOfArrays _results)
+		{
+			CV_INSTRUMENT_REGION()
+
+			CV_Assert(!templs.empty());
+
+			Mat img = _image.getMat();
+			int type = img.type(), depth = CV_MAT_DEPTH(type), cn = CV_MAT_CN(type);
+			CV_Assert(type == templs[0].type() && img.dims <= 2);
+
+			size_t t, ntempl = templs.size();
+			Size maxTemplSize(0, 0), minTemplSize(INT_MAX, INT_MAX);
+			for (t = 0; t < ntempl; t++)
+			{
+				maxTemplSize.width = std::max(maxTemplSize.width, templs[t].cols);
+				maxTemplSize.height = std::max(maxTemplSize.height, templs[t].rows);
+				minTemplSize.width = std::min(minTemplSize.width, templs[t].cols);
+				minTemplSize.height = std::min(minTemplSize.height, templs[t].rows);
+			}
+			CV_Assert(maxTemplSize.width <= img.cols && maxTemplSize.height <= img.rows);
+
+			// one block grid for all the templates: the block leaves room for the largest
+			// template and the grid covers the map of the smallest one
+			Size corrSize(img.cols - minTemplSize.width + 1, img.rows - minTemplSize.height + 1);
+			Size blocksize, dftsize;
+			getCrossCorrBlockSize(maxTemplSize, corrSize, blocksize, dftsize);
+
+			int maxDepth = depth == CV_8U ? CV_32F : CV_64F;
+			if (dftsize != spectraDftSize || maxDepth != spectraDepth)
+			{
+				std::vector<uchar> buf;
+				if (cn > 1 && depth != maxDepth)
+					buf.resize(maxTemplSize.area()*CV_ELEM_SIZE(depth));
+
+				spectra.resize(ntempl);
+				for (t = 0; t < ntempl; t++)
+					getTemplateSpectrum(templs[t], dftsize, maxDepth, spectra[t], buf.empty() ? 0 : &buf[0]);
+				spectraDftSize = dftsize;
+				spectraDepth = maxDepth;
+			}
+
+			if (statsMethod != method)
+			{
+				templMeans.resize(ntempl);
+				templNorms.resize(ntempl);
+				templSums2.resize(ntempl);
+				templFlat.resize(ntempl);
+				for (t = 0; t < ntempl; t++)
+					templFlat[t] = method != CV_TM_CCORR &&
+						!getTemplateStats(templs[t], method, templMeans[t], templNorms[t], templSums2[t]);
+				statsMethod = method;
+			}
+
+			_results.create((int)ntempl, 1, CV_32F);
+			std::vector<Mat> corrs(ntempl);
+			for (t = 0; t < ntempl; t++)
+			{
+				_results.create(img.rows - templs[t].rows + 1, img.cols - templs[t].cols + 1, CV_32F, (int)t);
+				corrs[t] = _results.getMat((int)t);
+			}
+
+			int tileCountX = (corrSize.width + blocksize.width - 1) / blocksize.width;
+			int tileCountY = (corrSize.height + blocksize.height - 1) / blocksize.height;
+			int tileCount = tileCountX * tileCountY;
+
+			parallel_for_(Range(0, tileCount),
+				MultiTemplateCorrInvoker(img, spectra, corrs, maxTemplSize, blocksize, dftsize, maxDepth, tileCountX),
+				tileCount);
+
+			if (method == CV_TM_CCORR)
+				return;
+
+			// the image integrals are shared by all the templates
+			Mat sum, sqsum;
+			if (method == CV_TM_CCOEFF)
+				integral(img, sum, CV_64F);
+			else
+				integral(img, sum, sqsum, CV_64F);
+
+			for (t = 0; t < ntempl; t++)
+			{
+				if (templFlat[t])
+					corrs[t] = Scalar::all(1);
+				else
+					normalizeMatchResult(sum, sqsum, templs[t].size(), cn, method,
+						templMeans[t], templNorms[t], templSums2[t], corrs[t]);
+			}
+		}
+
+		int getTemplatesCount() const { return (int)templs.size(); }
+
+		void setMethod(int _method)
+		{
+			CV_Assert(CV_TM_SQDIFF <= _method && _method <= CV_TM_CCOEFF_NORMED);
+			method = _method;
+		}
+		int getMethod() const { return method; }
+
+		void clear()
+		{
+			templs.clear();
+			spectra.clear();
+			spectraDftSize = Size();
+			statsMethod = -1;
+		}
+
+		bool empty() const { return templs.empty(); }
+
+	private:
+		int method;
+		std::vector<Mat> templs;
+
+		//! template spectra for the DFT size of the last image size
+		std::vector<Mat> spectra;
+		Size spectraDftSize;
+		int spectraDepth;
+
+		//! template statistics for statsMethod
+		std::vector<Scalar> templMeans;
+		std::vector<double> templNorms, templSums2;
+		std::vector<uchar> templFlat;
+		int statsMethod;
+	};
+}
+
+cv::Ptr<cv::TemplateMatcher> cv::createTemplateMatcher(int method)
+{
+	return makePtr<TemplateMatcherImpl>(method);
 }
 
 
@@ -13,6 +13,7 @@ namespace cv
 	enum {
 		OPTFLOW_USE_INITIAL_FLOW = 4,
 		OPTFLOW_LK_GET_MIN_EIGENVALS = 8,
+		OPTFLOW_LK_FORWARD_BACKWARD = 16,
 		OPTFLOW_FARNEBACK_GAUSSIAN = 256
 	};
 
@@ -62,7 +63,7 @@ namespace cv
 
 	/** @brief Constructs the image pyramid which can be passed to calcOpticalFlowPyrLK.
 
-	@param img 8-bit input image.
+	@param img 8-bit, 16-bit unsigned or 32-bit floating-point input image.
 	@param pyramid output pyramid.
 	@param winSize window size of optical flow algorithm. Must be not less than winSize argument of
 	calcOpticalFlowPyrLK. It is needed to calculate required padding for pyramid levels.
@@ -87,7 +88,8 @@ namespace cv
 	/** @brief Calculates an optical flow for a sparse feature set using the iterative Lucas-Kanade method with
 	pyramids.
 
-	@param prevImg first 8-bit input image or pyramid constructed by buildOpticalFlowPyramid.
+	@param prevImg first 8-bit, 16-bit unsigned or 32-bit floating-point input image or pyramid
+	constructed by buildOpticalFlowPyramid.
 	@param nextImg second input image or pyramid of the same size and the same type as prevImg.
 	@param prevPts vector of 2D points for which the flow needs to be found; point coordinates must be
 	single-precision floating-point numbers.
@@ -113,11 +115,17 @@ namespace cv
 	minEigThreshold description); if the flag is not set, then L1 distance between patches
 	around the original and a moved point, divided by number of pixels in a window, is used as a
 	error measure.
+	-   **OPTFLOW_LK_FORWARD_BACKWARD** tracks the found points back to the first image, reusing
+	the pyramids, and filters out the points that do not return within 1 pixel of their origin
+	(see SparsePyrLKOpticalFlow::setMaxFBError); err then holds the distance between the original and
+	the back-tracked point for every point instead of the measures above, FLT_MAX for the points lost
+	either way.
 	@param minEigThreshold the algorithm calculates the minimum eigen value of a 2x2 normal matrix of
 	optical flow equations (this matrix is called a spatial gradient matrix in @cite Bouguet00), divided
 	by number of pixels in a window; if this value is less than minEigThreshold, then a corresponding
 	feature is filtered out and its flow is not processed, so it allows to remove bad points and get a
-	performance boost.
+	performance boost. Both minEigThreshold and the error measures are expressed in the intensity units
+	of the input images, so they scale with the range of 16-bit and floating-point images.
 
 	The function implements a sparse iterative version of the Lucas-Kanade optical flow in pyramids. See
 	@cite Bouguet00 . The function is parallelized with the TBB library.
@@ -341,6 +349,69 @@ namespace cv
 		Mat temp5;
 	};
 
+	/** @brief Kalman filter with a fixed-size state, for tracking many objects at once.
+
+	The class implements the same filter as KalmanFilter (without the control input) on Matx and Vec,
+	so predict and correct do not allocate memory and the small matrix products are unrolled by the
+	compiler. Besides the filter state stored in the class, the model matrices can be applied to arrays
+	of states, e.g. to smooth all the tracks of a frame with one call of the batch predict and correct.
+
+	@tparam _Tp type of the matrices, float or double.
+	@tparam DP dimensionality of the state.
+	@tparam MP dimensionality of the measurement.
+	*/
+	template<typename _Tp, int DP, int MP> class KalmanFilter_
+	{
+	public:
+		typedef Vec<_Tp, DP> StateVec;
+		typedef Vec<_Tp, MP> MeasurementVec;
+		typedef Matx<_Tp, DP, DP> StateCov;
+
+		//! initializes the matrices like KalmanFilter::init does
+		KalmanFilter_();
+
+		//! computes a predicted state
+		const StateVec& predict();
+
+		//! updates the predicted state from the measurement
+		const StateVec& correct(const MeasurementVec& measurement);
+
+		/** @brief Predicts the states of count filters that share the model of this one.
+
+		@param states posteriori states, replaced by the predicted ones.
+		@param errorCovs posteriori error covariance matrices, replaced by the priori ones.
+		@param count number of the filters.
+		*/
+		void predict(StateVec* states, StateCov* errorCovs, int count) const;
+
+		/** @brief Corrects the states of count filters that share the model of this one.
+
+		@param states predicted states, replaced by the corrected ones.
+		@param errorCovs priori error covariance matrices, replaced by the posteriori ones.
+		@param measurements measurements of the filters.
+		@param count number of the filters.
+		@param mask optional mask; the filters with zero mask element have no measurement and keep
+		their predicted state, e.g. pass the status vector of calcOpticalFlowPyrLK.
+		*/
+		void correct(StateVec* states, StateCov* errorCovs, const MeasurementVec* measurements,
+			int count, const uchar* mask = 0) const;
+
+		StateVec statePre;                        //!< predicted state (x'(k)): x(k)=A*x(k-1)
+		StateVec statePost;                       //!< corrected state (x(k)): x(k)=x'(k)+K(k)*(z(k)-H*x'(k))
+		Matx<_Tp, DP, DP> transitionMatrix;       //!< state transition matrix (A)
+		Matx<_Tp, MP, DP> measurementMatrix;      //!< measurement matrix (H)
+		Matx<_Tp, DP, DP> processNoiseCov;        //!< process noise covariance matrix (Q)
+		Matx<_Tp, MP, MP> measurementNoiseCov;    //!< measurement noise covariance matrix (R)
+		Matx<_Tp, DP, DP> errorCovPre;            //!< priori error estimate covariance matrix (P'(k)): P'(k)=A*P(k-1)*At + Q
+		Matx<_Tp, DP, MP> gain;                   //!< Kalman gain matrix (K(k)): K(k)=P'(k)*Ht*inv(H*P'(k)*Ht+R)
+		Matx<_Tp, DP, DP> errorCovPost;           //!< posteriori error estimate covariance matrix (P(k)): P(k)=(I-K(k)*H)*P'(k)
+
+	private:
+		void predict_(StateVec& state, StateCov& errorCov) const;
+		void correct_(StateVec& state, StateCov& errorCov, const MeasurementVec& measurement,
+			Matx<_Tp, DP, MP>& K) const;
+	};
+
 
 	class CV_EXPORTS_W DenseOpticalFlow : public Algorithm
 	{
@@ -571,6 +642,94 @@ namespace cv
 		CV_WRAP virtual double getMinEigThreshold() const = 0;
 		CV_WRAP virtual void setMinEigThreshold(double minEigThreshold) = 0;
 
+		/** @brief Appends a frame to the streaming tracker.
+
+		The pyramid of the previously pushed frame (together with its Scharr derivatives) is kept and
+		becomes the "previous" pyramid, so every frame pushed into the tracker is downsampled and
+		differentiated exactly once, instead of twice as with calc().
+
+		@param img next 8-bit, 16-bit unsigned or 32-bit floating-point input image of the stream. All frames of a stream must have the same
+		size and type; a frame of a different size or type restarts the stream.
+		*/
+		CV_WRAP virtual void pushFrame(InputArray img) = 0;
+
+		/** @brief Tracks points from the previously pushed frame to the last pushed one.
+
+		The cached pyramids are used, see pushFrame. If only one frame has been pushed so far, it is
+		tracked against itself. The parameters have the same meaning as in calc.
+		*/
+		CV_WRAP virtual void track(InputArray prevPts, InputOutputArray nextPts,
+			OutputArray status,
+			OutputArray err = cv::noArray()) = 0;
+
+		/** @brief Drops the cached pyramids, so the next pushed frame starts a new stream.
+		*/
+		CV_WRAP virtual void resetFrames() = 0;
+
+		/** @brief Tracks points in several independent image pairs at once.
+
+		Each stream i is described by a pair of pyramids constructed by buildOpticalFlowPyramid and by
+		its own point set. The points of all the streams are split into small chunks, and every chunk is
+		tracked through all the pyramid levels within a single parallel loop, so many streams with few
+		points each still keep all the threads busy.
+
+		@param prevPyramids pyramids of the first images, one per stream.
+		@param nextPyramids pyramids of the second images, one per stream, with the same sizes and
+		types as the corresponding prevPyramids.
+		@param prevPts vector of point vectors, one per stream.
+		@param nextPts output vector of point vectors, one per stream; see calc.
+		@param status output vector of status vectors, one per stream; see calc.
+		@param err optional output vector of error vectors, one per stream; see calc.
+		*/
+		virtual void calcBatch(const std::vector<std::vector<Mat> >& prevPyramids,
+			const std::vector<std::vector<Mat> >& nextPyramids,
+			InputArrayOfArrays prevPts, InputOutputArrayOfArrays nextPts,
+			OutputArrayOfArrays status,
+			OutputArrayOfArrays err = cv::noArray()) = 0;
+
+		/** @brief Returns the convergence statistics of the last calc or track call.
+
+		@param iterations output matrix of type CV_32S with one row per point and one column per pyramid
+		level; element (i, l) is the number of iterations done for the i-th point at level l, or 0 if the
+		point has not been refined at that level.
+		@param residuals optional output matrix of type CV_32F and the same size; element (i, l) is the
+		length of the last update of the i-th point at level l, in pixels of that level.
+		*/
+		CV_WRAP virtual void getLastStatistics(OutputArray iterations, OutputArray residuals = cv::noArray()) const = 0;
+
+		/** @brief Limits the total number of iterations spent by a single calc, track or calcBatch call.
+
+		When a budget is set, the points are tracked in small chunks, every chunk going through all the
+		pyramid levels at once. The threads take the chunks one by one in the order of the points (for
+		calcBatch, in the order of the streams first), so the earlier points have the higher priority.
+		Once the budget is exhausted, no further chunk is started and the points of the skipped chunks
+		get zero status, i.e. the refined points are always the first ones. The budget is checked when a
+		chunk starts, so it may be exceeded by the chunks already running; with several threads the
+		number of such chunks, and therefore the exact cut-off point, depends on the timing.
+
+		@param maxIterations total number of iterations over all the points and levels; 0 means no limit.
+		*/
+		CV_WRAP virtual void setIterationBudget(int maxIterations) = 0;
+		CV_WRAP virtual int getIterationBudget() const = 0;
+
+		/** @brief Limits the tracking time of a single calc, track or calcBatch call.
+
+		The budget works the same way as the one of setIterationBudget, both can be combined.
+
+		@param maxTimeMs time in milliseconds, measured from the start of tracking, i.e. pyramid
+		construction is not included; 0 means no limit.
+		*/
+		CV_WRAP virtual void setTimeBudget(double maxTimeMs) = 0;
+		CV_WRAP virtual double getTimeBudget() const = 0;
+
+		/** @brief Maximal forward-backward error of the OPTFLOW_LK_FORWARD_BACKWARD flag.
+
+		A point keeps a non-zero status only if tracking it back from its new position ends within
+		maxFBError pixels of the original position. The default value is 1.
+		*/
+		CV_WRAP virtual void setMaxFBError(double maxFBError) = 0;
+		CV_WRAP virtual double getMaxFBError() const = 0;
+
 		CV_WRAP static Ptr<SparsePyrLKOpticalFlow> create(
 			Size winSize = Size(21, 21),
 			int maxLevel = 3, TermCriteria crit =
@@ -581,6 +740,84 @@ namespace cv
 
 	//! @} video_track
 
+	//! @cond IGNORED
+
+	template<typename _Tp, int DP, int MP> inline
+		KalmanFilter_<_Tp, DP, MP>::KalmanFilter_()
+		: transitionMatrix(Matx<_Tp, DP, DP>::eye()), processNoiseCov(Matx<_Tp, DP, DP>::eye()),
+		measurementNoiseCov(Matx<_Tp, MP, MP>::eye())
+	{
+	}
+
+	template<typename _Tp, int DP, int MP> inline
+		void KalmanFilter_<_Tp, DP, MP>::predict_(StateVec& state, StateCov& errorCov) const
+	{
+		// x'(k) = A*x(k)
+		state = StateVec(transitionMatrix * state);
+		// P'(k) = A*P(k)*At + Q
+		errorCov = transitionMatrix * errorCov * transitionMatrix.t() + processNoiseCov;
+	}
+
+	template<typename _Tp, int DP, int MP> inline
+		void KalmanFilter_<_Tp, DP, MP>::correct_(StateVec& state, StateCov& errorCov,
+			const MeasurementVec& measurement, Matx<_Tp, DP, MP>& K) const
+	{
+		// H*P'(k) and the innovation covariance H*P'(k)*Ht + R
+		Matx<_Tp, MP, DP> HP = measurementMatrix * errorCov;
+		Matx<_Tp, MP, MP> S = HP * measurementMatrix.t() + measurementNoiseCov;
+
+		// K(k) = P'(k)*Ht*inv(S), S is symmetric
+		K = (S.inv(DECOMP_CHOLESKY) * HP).t();
+
+		// x(k) = x'(k) + K(k)*(z(k) - H*x'(k))
+		MeasurementVec residual = measurement - MeasurementVec(measurementMatrix * state);
+		state += StateVec(K * residual);
+
+		// P(k) = P'(k) - K(k)*H*P'(k)
+		errorCov -= K * HP;
+	}
+
+	template<typename _Tp, int DP, int MP> inline
+		const typename KalmanFilter_<_Tp, DP, MP>::StateVec& KalmanFilter_<_Tp, DP, MP>::predict()
+	{
+		statePre = statePost;
+		errorCovPre = errorCovPost;
+		predict_(statePre, errorCovPre);
+
+		// handle the case when there will be measurement before the next predict.
+		statePost = statePre;
+		errorCovPost = errorCovPre;
+		return statePre;
+	}
+
+	template<typename _Tp, int DP, int MP> inline
+		const typename KalmanFilter_<_Tp, DP, MP>::StateVec& KalmanFilter_<_Tp, DP, MP>::correct(const MeasurementVec& measurement)
+	{
+		statePost = statePre;
+		errorCovPost = errorCovPre;
+		correct_(statePost, errorCovPost, measurement, gain);
+		return statePost;
+	}
+
+	template<typename _Tp, int DP, int MP> inline
+		void KalmanFilter_<_Tp, DP, MP>::predict(StateVec* states, StateCov* errorCovs, int count) const
+	{
+		for (int i = 0; i < count; i++)
+			predict_(states[i], errorCovs[i]);
+	}
+
+	template<typename _Tp, int DP, int MP> inline
+		void KalmanFilter_<_Tp, DP, MP>::correct(StateVec* states, StateCov* errorCovs,
+			const MeasurementVec* measurements, int count, const uchar* mask) const
+	{
+		Matx<_Tp, DP, MP> K;
+		for (int i = 0; i < count; i++)
+			if (!mask || mask[i])
+				correct_(states[i], errorCovs[i], measurements[i], K);
+	}
+
+	//! @endcond
+
 } // cv
 
 #endif
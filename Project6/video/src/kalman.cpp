@@ -0,0 +1,94 @@
+#include "precomp.hpp"
+
+namespace cv
+{
+
+	KalmanFilter::KalmanFilter() {}
+	KalmanFilter::KalmanFilter(int dynamParams, int measureParams, int controlParams, int type)
+	{
+		init(dynamParams, measureParams, controlParams, type);
+	}
+
+	void KalmanFilter::init(int DP, int MP, int CP, int type)
+	{
+		CV_Assert(DP > 0 && MP > 0);
+		CV_Assert(type == CV_32F || type == CV_64F);
+		CP = std::max(CP, 0);
+
+		statePre = Mat::zeros(DP, 1, type);
+		statePost = Mat::zeros(DP, 1, type);
+		transitionMatrix = Mat::eye(DP, DP, type);
+
+		processNoiseCov = Mat::eye(DP, DP, type);
+		measurementMatrix = Mat::zeros(MP, DP, type);
+		measurementNoiseCov = Mat::eye(MP, MP, type);
+
+		errorCovPre = Mat::zeros(DP, DP, type);
+		errorCovPost = Mat::zeros(DP, DP, type);
+		gain = Mat::zeros(DP, MP, type);
+
+		if (CP > 0)
+			controlMatrix = Mat::zeros(DP, CP, type);
+		else
+			controlMatrix.release();
+
+		temp1.create(DP, DP, type);
+		temp2.create(MP, DP, type);
+		temp3.create(MP, MP, type);
+		temp4.create(MP, DP, type);
+		temp5.create(MP, 1, type);
+	}
+
+	const Mat& KalmanFilter::predict(const Mat& control)
+	{
+		CV_INSTRUMENT_REGION()
+
+		// update the state: x'(k) = A*x(k)
+		gemm(transitionMatrix, statePost, 1, noArray(), 0, statePre);
+
+		if (!control.empty())
+			// x'(k) = x'(k) + B*u(k)
+			gemm(controlMatrix, control, 1, statePre, 1, statePre);
+
+		// update error covariance matrices: temp1 = A*P(k)
+		gemm(transitionMatrix, errorCovPost, 1, noArray(), 0, temp1);
+
+		// P'(k) = temp1*At + Q
+		gemm(temp1, transitionMatrix, 1, processNoiseCov, 1, errorCovPre, GEMM_2_T);
+
+		// handle the case when there will be measurement before the next predict.
+		statePre.copyTo(statePost);
+		errorCovPre.copyTo(errorCovPost);
+
+		return statePre;
+	}
+
+	const Mat& KalmanFilter::correct(const Mat& measurement)
+	{
+		CV_INSTRUMENT_REGION()
+
+		// temp2 = H*P'(k)
+		gemm(measurementMatrix, errorCovPre, 1, noArray(), 0, temp2);
+
+		// temp3 = temp2*Ht + R
+		gemm(temp2, measurementMatrix, 1, measurementNoiseCov, 1, temp3, GEMM_2_T);
+
+		// temp4 = inv(temp3)*temp2 = Kt(k)
+		solve(temp3, temp2, temp4, DECOMP_SVD);
+
+		// K(k)
+		transpose(temp4, gain);
+
+		// temp5 = z(k) - H*x'(k)
+		gemm(measurementMatrix, statePre, -1, measurement, 1, temp5);
+
+		// x(k) = x'(k) + K(k)*temp5
+		gemm(gain, temp5, 1, statePre, 1, statePost);
+
+		// P(k) = P'(k) - K(k)*temp2
+		gemm(gain, temp2, -1, errorCovPre, 1, errorCovPost);
+
+		return statePost;
+	}
+
+}
@@ -4,7 +4,7 @@
 #include "lkpyramid.hpp"
 
 //#include "opencl_kernels_video.hpp"
-//#include "opencv2/core/hal/intrin.hpp"
+#include "../../core/include/opencv2/core/hal/intrin.hpp"
 
 //#include "opencv2/core/openvx/ovx_defs.hpp"
 
@@ -12,16 +12,72 @@
 
 namespace
 {
-	static void calcSharrDeriv(const cv::Mat& src, cv::Mat& dst)
+	// Scharr derivatives of 16U and 32F images, WT is the type of the derivatives
+	template<typename T, typename WT> static void calcSharrDeriv_(const cv::Mat& src, cv::Mat& dst, const cv::Range& rowRange)
+	{
+		using namespace cv;
+		int rows = src.rows, cols = src.cols, cn = src.channels(), colsn = cols * cn;
+		dst.create(rows, cols, CV_MAKETYPE(DataType<WT>::depth, cn * 2));
+
+		int x, y;
+		AutoBuffer<WT> _tempBuf((colsn + cn * 2) * 2);
+		WT *trow0 = (WT*)_tempBuf + cn, *trow1 = trow0 + colsn + cn * 2;
+
+		for (y = rowRange.start; y < rowRange.end; y++)
+		{
+			const T* srow0 = src.ptr<T>(y > 0 ? y - 1 : rows > 1 ? 1 : 0);
+			const T* srow1 = src.ptr<T>(y);
+			const T* srow2 = src.ptr<T>(y < rows - 1 ? y + 1 : rows > 1 ? rows - 2 : 0);
+			WT* drow = dst.ptr<WT>(y);
+
+			// do vertical convolution
+			for (x = 0; x < colsn; x++)
+			{
+				trow0[x] = (WT)((srow0[x] + srow2[x]) * 3 + srow1[x] * 10);
+				trow1[x] = (WT)(srow2[x] - srow0[x]);
+			}
+
+			// make border
+			int x0 = (cols > 1 ? 1 : 0)*cn, x1 = (cols > 1 ? cols - 2 : 0)*cn;
+			for (int k = 0; k < cn; k++)
+			{
+				trow0[-cn + k] = trow0[x0 + k]; trow0[colsn + k] = trow0[x1 + k];
+				trow1[-cn + k] = trow1[x0 + k]; trow1[colsn + k] = trow1[x1 + k];
+			}
+
+			// do horizontal convolution, interleave the results and store them to dst
+			for (x = 0; x < colsn; x++)
+			{
+				drow[x * 2] = trow0[x + cn] - trow0[x - cn];
+				drow[x * 2 + 1] = (trow1[x + cn] + trow1[x - cn]) * 3 + trow1[x] * 10;
+			}
+		}
+	}
+
+	// computes the derivatives of src rows from rowRange only (the whole image by default),
+	// the rows around the range are read from src, so bands of an image can be processed in parallel
+	static void calcSharrDeriv(const cv::Mat& src, cv::Mat& dst, const cv::Range& _rowRange = cv::Range::all())
 	{
 		using namespace cv;
 		using cv::detail::deriv_type;
 		int rows = src.rows, cols = src.cols, cn = src.channels(), colsn = cols * cn, depth = src.depth();
+		Range rowRange = _rowRange == Range::all() ? Range(0, rows) : _rowRange;
+		CV_Assert(0 <= rowRange.start && rowRange.start <= rowRange.end && rowRange.end <= rows);
+		if (depth == CV_16U)
+		{
+			calcSharrDeriv_<ushort, int>(src, dst, rowRange);
+			return;
+		}
+		if (depth == CV_32F)
+		{
+			calcSharrDeriv_<float, float>(src, dst, rowRange);
+			return;
+		}
 		CV_Assert(depth == CV_8U);
 		dst.create(rows, cols, CV_MAKETYPE(DataType<deriv_type>::depth, cn * 2));
 
 #ifdef HAVE_TEGRA_OPTIMIZATION
-		if (tegra::useTegra() && tegra::calcSharrDeriv(src, dst))
+		if (_rowRange == Range::all() && tegra::useTegra() && tegra::calcSharrDeriv(src, dst))
 			return;
 #endif
 
@@ -34,7 +90,7 @@ namespace
 		bool haveSIMD = checkHardwareSupport(CV_CPU_SSE2) || checkHardwareSupport(CV_CPU_NEON);
 #endif
 
-		for (y = 0; y < rows; y++)
+		for (y = rowRange.start; y < rowRange.end; y++)
 		{
 			const uchar* srow0 = src.ptr<uchar>(y > 0 ? y - 1 : rows > 1 ? 1 : 0);
 			const uchar* srow1 = src.ptr<uchar>(y);
@@ -106,6 +162,32 @@ namespace
 		}
 	}
 
+#if CV_SIMD128
+	// bilinear interpolation of 8 lanes; qw0/qw1 hold the (w00, w01) and (w10, w11) weight pairs
+	static inline cv::v_int16x8 lkInterpolate(const cv::v_int16x8& v00, const cv::v_int16x8& v01,
+		const cv::v_int16x8& v10, const cv::v_int16x8& v11,
+		const cv::v_int16x8& qw0, const cv::v_int16x8& qw1, const cv::v_int32x4& qdelta, int shift)
+	{
+		using namespace cv;
+		v_int16x8 t00, t01, t10, t11;
+		v_zip(v00, v01, t00, t01);
+		v_zip(v10, v11, t10, t11);
+
+		v_int32x4 t0 = (v_dotprod(t00, qw0) + v_dotprod(t10, qw1) + qdelta) >> shift;
+		v_int32x4 t1 = (v_dotprod(t01, qw0) + v_dotprod(t11, qw1) + qdelta) >> shift;
+		return v_pack(t0, t1);
+	}
+
+	static inline cv::v_int16x8 lkInterpolate(const uchar* src, int cn, int step,
+		const cv::v_int16x8& qw0, const cv::v_int16x8& qw1, const cv::v_int32x4& qdelta, int shift)
+	{
+		using namespace cv;
+		return lkInterpolate(v_reinterpret_as_s16(v_load_expand(src)), v_reinterpret_as_s16(v_load_expand(src + cn)),
+			v_reinterpret_as_s16(v_load_expand(src + step)), v_reinterpret_as_s16(v_load_expand(src + step + cn)),
+			qw0, qw1, qdelta, shift);
+	}
+#endif
+
 }//namespace
 
 cv::detail::LKTrackerInvoker::LKTrackerInvoker(
@@ -113,7 +195,8 @@ cv::detail::LKTrackerInvoker::LKTrackerInvoker(
 	const Point2f* _prevPts, Point2f* _nextPts,
 	uchar* _status, float* _err,
 	Size _winSize, TermCriteria _criteria,
-	int _level, int _maxLevel, int _flags, float _minEigThreshold)
+	int _level, int _maxLevel, int _flags, float _minEigThreshold,
+	int* _iters, float* _residuals)
 {
 	prevImg = &_prevImg;
 	prevDeriv = &_prevDeriv;
@@ -128,6 +211,8 @@ cv::detail::LKTrackerInvoker::LKTrackerInvoker(
 	maxLevel = _maxLevel;
 	flags = _flags;
 	minEigThreshold = _minEigThreshold;
+	iters = _iters;
+	residuals = _residuals;
 }
 
 #if defined __arm__ && !CV_NEON
@@ -142,6 +227,17 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 {
 	CV_INSTRUMENT_REGION()
 
+	if (prevImg->depth() == CV_16U)
+	{
+		trackFloat<ushort, int>(range);
+		return;
+	}
+	if (prevImg->depth() == CV_32F)
+	{
+		trackFloat<float, float>(range);
+		return;
+	}
+
 	Point2f halfWin((winSize.width - 1)*0.5f, (winSize.height - 1)*0.5f);
 	const Mat& I = *prevImg;
 	const Mat& J = *nextImg;
@@ -202,16 +298,13 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 		acctype iA11 = 0, iA12 = 0, iA22 = 0;
 		float A11, A12, A22;
 
-#if CV_SSE2
-		__m128i qw0 = _mm_set1_epi32(iw00 + (iw01 << 16));
-		__m128i qw1 = _mm_set1_epi32(iw10 + (iw11 << 16));
-		__m128i z = _mm_setzero_si128();
-		__m128i qdelta_d = _mm_set1_epi32(1 << (W_BITS1 - 1));
-		__m128i qdelta = _mm_set1_epi32(1 << (W_BITS1 - 5 - 1));
-		__m128 qA11 = _mm_setzero_ps(), qA12 = _mm_setzero_ps(), qA22 = _mm_setzero_ps();
-#endif
-
-#if CV_NEON
+#if CV_SIMD128
+		v_int16x8 qw0((short)iw00, (short)iw01, (short)iw00, (short)iw01, (short)iw00, (short)iw01, (short)iw00, (short)iw01);
+		v_int16x8 qw1((short)iw10, (short)iw11, (short)iw10, (short)iw11, (short)iw10, (short)iw11, (short)iw10, (short)iw11);
+		v_int32x4 qdelta_d = v_setall_s32(1 << (W_BITS1 - 1));
+		v_int32x4 qdelta = v_setall_s32(1 << (W_BITS1 - 5 - 1));
+		v_float32x4 qA11 = v_setzero_f32(), qA12 = v_setzero_f32(), qA22 = v_setzero_f32();
+#elif CV_NEON
 
 		float CV_DECL_ALIGNED(16) nA11[] = { 0, 0, 0, 0 }, nA12[] = { 0, 0, 0, 0 }, nA22[] = { 0, 0, 0, 0 };
 		const int shifter1 = -(W_BITS - 5); //negative so it shifts right
@@ -238,48 +331,26 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 
 			x = 0;
 
-#if CV_SSE2
-			for (; x <= winSize.width*cn - 4; x += 4, dsrc += 4 * 2, dIptr += 4 * 2)
+#if CV_SIMD128
+			for (; x <= winSize.width*cn - 8; x += 8, dsrc += 8 * 2, dIptr += 8 * 2)
 			{
-				__m128i v00, v01, v10, v11, t0, t1;
-
-				v00 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int*)(src + x)), z);
-				v01 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int*)(src + x + cn)), z);
-				v10 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int*)(src + x + stepI)), z);
-				v11 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int*)(src + x + stepI + cn)), z);
-
-				t0 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(v00, v01), qw0),
-					_mm_madd_epi16(_mm_unpacklo_epi16(v10, v11), qw1));
-				t0 = _mm_srai_epi32(_mm_add_epi32(t0, qdelta), W_BITS1 - 5);
-				_mm_storel_epi64((__m128i*)(Iptr + x), _mm_packs_epi32(t0, t0));
-
-				v00 = _mm_loadu_si128((const __m128i*)(dsrc));
-				v01 = _mm_loadu_si128((const __m128i*)(dsrc + cn2));
-				v10 = _mm_loadu_si128((const __m128i*)(dsrc + dstep));
-				v11 = _mm_loadu_si128((const __m128i*)(dsrc + dstep + cn2));
-
-				t0 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(v00, v01), qw0),
-					_mm_madd_epi16(_mm_unpacklo_epi16(v10, v11), qw1));
-				t1 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(v00, v01), qw0),
-					_mm_madd_epi16(_mm_unpackhi_epi16(v10, v11), qw1));
-				t0 = _mm_srai_epi32(_mm_add_epi32(t0, qdelta_d), W_BITS1);
-				t1 = _mm_srai_epi32(_mm_add_epi32(t1, qdelta_d), W_BITS1);
-				v00 = _mm_packs_epi32(t0, t1); // Ix0 Iy0 Ix1 Iy1 ...
-
-				_mm_storeu_si128((__m128i*)dIptr, v00);
-				t0 = _mm_srai_epi32(v00, 16); // Iy0 Iy1 Iy2 Iy3
-				t1 = _mm_srai_epi32(_mm_slli_epi32(v00, 16), 16); // Ix0 Ix1 Ix2 Ix3
-
-				__m128 fy = _mm_cvtepi32_ps(t0);
-				__m128 fx = _mm_cvtepi32_ps(t1);
-
-				qA22 = _mm_add_ps(qA22, _mm_mul_ps(fy, fy));
-				qA12 = _mm_add_ps(qA12, _mm_mul_ps(fx, fy));
-				qA11 = _mm_add_ps(qA11, _mm_mul_ps(fx, fx));
-			}
-#endif
+				v_store(Iptr + x, lkInterpolate(src + x, cn, stepI, qw0, qw1, qdelta, W_BITS1 - 5));
+
+				v_int16x8 ix00, iy00, ix01, iy01, ix10, iy10, ix11, iy11;
+				v_load_deinterleave(dsrc, ix00, iy00);
+				v_load_deinterleave(dsrc + cn2, ix01, iy01);
+				v_load_deinterleave(dsrc + dstep, ix10, iy10);
+				v_load_deinterleave(dsrc + dstep + cn2, ix11, iy11);
+
+				v_int16x8 ix = lkInterpolate(ix00, ix01, ix10, ix11, qw0, qw1, qdelta_d, W_BITS1);
+				v_int16x8 iy = lkInterpolate(iy00, iy01, iy10, iy11, qw0, qw1, qdelta_d, W_BITS1);
+				v_store_interleave(dIptr, ix, iy);
 
-#if CV_NEON
+				qA11 += v_cvt_f32(v_dotprod(ix, ix));
+				qA12 += v_cvt_f32(v_dotprod(ix, iy));
+				qA22 += v_cvt_f32(v_dotprod(iy, iy));
+			}
+#elif CV_NEON
 			for (; x <= winSize.width*cn - 4; x += 4, dsrc += 4 * 2, dIptr += 4 * 2)
 			{
 
@@ -382,17 +453,11 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 			}
 		}
 
-#if CV_SSE2
-		float CV_DECL_ALIGNED(16) A11buf[4], A12buf[4], A22buf[4];
-		_mm_store_ps(A11buf, qA11);
-		_mm_store_ps(A12buf, qA12);
-		_mm_store_ps(A22buf, qA22);
-		iA11 += A11buf[0] + A11buf[1] + A11buf[2] + A11buf[3];
-		iA12 += A12buf[0] + A12buf[1] + A12buf[2] + A12buf[3];
-		iA22 += A22buf[0] + A22buf[1] + A22buf[2] + A22buf[3];
-#endif
-
-#if CV_NEON
+#if CV_SIMD128
+		iA11 += v_reduce_sum(qA11);
+		iA12 += v_reduce_sum(qA12);
+		iA22 += v_reduce_sum(qA22);
+#elif CV_NEON
 		iA11 += nA11[0] + nA11[1] + nA11[2] + nA11[3];
 		iA12 += nA12[0] + nA12[1] + nA12[2] + nA12[3];
 		iA22 += nA22[0] + nA22[1] + nA22[2] + nA22[3];
@@ -420,6 +485,8 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 
 		nextPt -= halfWin;
 		Point2f prevDelta;
+		int niters = 0;
+		float lastStep = 0.f;
 
 		for (j = 0; j < criteria.maxCount; j++)
 		{
@@ -442,13 +509,11 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 			iw11 = (1 << W_BITS) - iw00 - iw01 - iw10;
 			acctype ib1 = 0, ib2 = 0;
 			float b1, b2;
-#if CV_SSE2
-			qw0 = _mm_set1_epi32(iw00 + (iw01 << 16));
-			qw1 = _mm_set1_epi32(iw10 + (iw11 << 16));
-			__m128 qb0 = _mm_setzero_ps(), qb1 = _mm_setzero_ps();
-#endif
-
-#if CV_NEON
+#if CV_SIMD128
+			qw0 = v_int16x8((short)iw00, (short)iw01, (short)iw00, (short)iw01, (short)iw00, (short)iw01, (short)iw00, (short)iw01);
+			qw1 = v_int16x8((short)iw10, (short)iw11, (short)iw10, (short)iw11, (short)iw10, (short)iw11, (short)iw10, (short)iw11);
+			v_float32x4 qb1 = v_setzero_f32(), qb2 = v_setzero_f32();
+#elif CV_NEON
 			float CV_DECL_ALIGNED(16) nB1[] = { 0,0,0,0 }, nB2[] = { 0,0,0,0 };
 
 			const int16x4_t d26_2 = vdup_n_s16((int16_t)iw00);
@@ -466,38 +531,17 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 
 				x = 0;
 
-#if CV_SSE2
+#if CV_SIMD128
 				for (; x <= winSize.width*cn - 8; x += 8, dIptr += 8 * 2)
 				{
-					__m128i diff0 = _mm_loadu_si128((const __m128i*)(Iptr + x)), diff1;
-					__m128i v00 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(Jptr + x)), z);
-					__m128i v01 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(Jptr + x + cn)), z);
-					__m128i v10 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(Jptr + x + stepJ)), z);
-					__m128i v11 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(Jptr + x + stepJ + cn)), z);
-
-					__m128i t0 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(v00, v01), qw0),
-						_mm_madd_epi16(_mm_unpacklo_epi16(v10, v11), qw1));
-					__m128i t1 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(v00, v01), qw0),
-						_mm_madd_epi16(_mm_unpackhi_epi16(v10, v11), qw1));
-					t0 = _mm_srai_epi32(_mm_add_epi32(t0, qdelta), W_BITS1 - 5);
-					t1 = _mm_srai_epi32(_mm_add_epi32(t1, qdelta), W_BITS1 - 5);
-					diff0 = _mm_subs_epi16(_mm_packs_epi32(t0, t1), diff0);
-					diff1 = _mm_unpackhi_epi16(diff0, diff0);
-					diff0 = _mm_unpacklo_epi16(diff0, diff0); // It0 It0 It1 It1 ...
-					v00 = _mm_loadu_si128((const __m128i*)(dIptr)); // Ix0 Iy0 Ix1 Iy1 ...
-					v01 = _mm_loadu_si128((const __m128i*)(dIptr + 8));
-					v10 = _mm_unpacklo_epi16(v00, v01);
-					v11 = _mm_unpackhi_epi16(v00, v01);
-					v00 = _mm_unpacklo_epi16(diff0, diff1);
-					v01 = _mm_unpackhi_epi16(diff0, diff1);
-					v00 = _mm_madd_epi16(v00, v10);
-					v11 = _mm_madd_epi16(v01, v11);
-					qb0 = _mm_add_ps(qb0, _mm_cvtepi32_ps(v00));
-					qb1 = _mm_add_ps(qb1, _mm_cvtepi32_ps(v11));
-				}
-#endif
+					v_int16x8 diff = lkInterpolate(Jptr + x, cn, stepJ, qw0, qw1, qdelta, W_BITS1 - 5) - v_load(Iptr + x);
+					v_int16x8 ix, iy;
+					v_load_deinterleave(dIptr, ix, iy);
 
-#if CV_NEON
+					qb1 += v_cvt_f32(v_dotprod(diff, ix));
+					qb2 += v_cvt_f32(v_dotprod(diff, iy));
+				}
+#elif CV_NEON
 				for (; x <= winSize.width*cn - 8; x += 8, dIptr += 8 * 2)
 				{
 
@@ -579,15 +623,10 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 				}
 			}
 
-#if CV_SSE2
-			float CV_DECL_ALIGNED(16) bbuf[4];
-			_mm_store_ps(bbuf, _mm_add_ps(qb0, qb1));
-			ib1 += bbuf[0] + bbuf[2];
-			ib2 += bbuf[1] + bbuf[3];
-#endif
-
-#if CV_NEON
-
+#if CV_SIMD128
+			ib1 += v_reduce_sum(qb1);
+			ib2 += v_reduce_sum(qb2);
+#elif CV_NEON
 			ib1 += (float)(nB1[0] + nB1[1] + nB1[2] + nB1[3]);
 			ib2 += (float)(nB2[0] + nB2[1] + nB2[2] + nB2[3]);
 #endif
@@ -602,7 +641,11 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 			nextPt += delta;
 			nextPts[ptidx] = nextPt + halfWin;
 
-			if (delta.ddot(delta) <= criteria.epsilon)
+			double step2 = delta.ddot(delta);
+			niters++;
+			lastStep = (float)std::sqrt(step2);
+
+			if (step2 <= criteria.epsilon)
 				break;
 
 			if (j > 0 && std::abs(delta.x + prevDelta.x) < 0.01 &&
@@ -614,6 +657,11 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 			prevDelta = delta;
 		}
 
+		if (iters)
+			iters[ptidx * (maxLevel + 1) + level] = niters;
+		if (residuals)
+			residuals[ptidx * (maxLevel + 1) + level] = lastStep;
+
 		CV_Assert(status != NULL);
 		if (status[ptidx] && err && level == 0 && (flags & OPTFLOW_LK_GET_MIN_EIGENVALS) == 0)
 		{
@@ -638,13 +686,29 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 			iw10 = cvRound((1.f - aa)*bb*(1 << W_BITS));
 			iw11 = (1 << W_BITS) - iw00 - iw01 - iw10;
 			float errval = 0.f;
+#if CV_SIMD128
+			qw0 = v_int16x8((short)iw00, (short)iw01, (short)iw00, (short)iw01, (short)iw00, (short)iw01, (short)iw00, (short)iw01);
+			qw1 = v_int16x8((short)iw10, (short)iw11, (short)iw10, (short)iw11, (short)iw10, (short)iw11, (short)iw10, (short)iw11);
+			v_uint32x4 qerr = v_setzero_u32();
+#endif
 
 			for (y = 0; y < winSize.height; y++)
 			{
 				const uchar* Jptr = J.ptr() + (y + inextPoint.y)*stepJ + inextPoint.x*cn;
 				const deriv_type* Iptr = IWinBuf.ptr<deriv_type>(y);
 
-				for (x = 0; x < winSize.width*cn; x++)
+				x = 0;
+#if CV_SIMD128
+				for (; x <= winSize.width*cn - 8; x += 8)
+				{
+					v_int16x8 diff = lkInterpolate(Jptr + x, cn, stepJ, qw0, qw1, qdelta, W_BITS1 - 5) - v_load(Iptr + x);
+					v_uint32x4 e0, e1;
+					v_expand(v_abs(diff), e0, e1);
+					qerr += e0 + e1;
+				}
+#endif
+
+				for (; x < winSize.width*cn; x++)
 				{
 					int diff = CV_DESCALE(Jptr[x] * iw00 + Jptr[x + cn] * iw01 +
 						Jptr[x + stepJ] * iw10 + Jptr[x + stepJ + cn] * iw11,
@@ -652,23 +716,328 @@ void cv::detail::LKTrackerInvoker::operator()(const Range& range) const
 					errval += std::abs((float)diff);
 				}
 			}
+#if CV_SIMD128
+			errval += (float)v_reduce_sum(qerr);
+#endif
 			err[ptidx] = errval * 1.f / (32 * winSize.width*cn*winSize.height);
 		}
 	}
 }
 
+template<typename T, typename DT>
+void cv::detail::LKTrackerInvoker::trackFloat(const Range& range) const
+{
+	Point2f halfWin((winSize.width - 1)*0.5f, (winSize.height - 1)*0.5f);
+	const Mat& I = *prevImg;
+	const Mat& J = *nextImg;
+	const Mat& derivI = *prevDeriv;
+
+	int j, cn = I.channels(), cn2 = cn * 2;
+	cv::AutoBuffer<float> _buf(winSize.area()*(cn + cn2));
+
+	Mat IWinBuf(winSize, CV_MAKETYPE(CV_32F, cn), (float*)_buf);
+	Mat derivIWinBuf(winSize, CV_MAKETYPE(CV_32F, cn2), (float*)_buf + winSize.area()*cn);
+
+	// the 8-bit path keeps the patch scaled by 32 and the products scaled by 2^20,
+	// use the same scales so that minEigThreshold and err have the same meaning
+	const float FLT_SCALE = 1.f / (1 << 20);
+	const float B_SCALE = FLT_SCALE * 32;
+
+	for (int ptidx = range.start; ptidx < range.end; ptidx++)
+	{
+		Point2f prevPt = prevPts[ptidx] * (float)(1. / (1 << level));
+		Point2f nextPt;
+		if (level == maxLevel)
+		{
+			if (flags & OPTFLOW_USE_INITIAL_FLOW)
+				nextPt = nextPts[ptidx] * (float)(1. / (1 << level));
+			else
+				nextPt = prevPt;
+		}
+		else
+			nextPt = nextPts[ptidx] * 2.f;
+		nextPts[ptidx] = nextPt;
+
+		Point2i iprevPt, inextPt;
+		prevPt -= halfWin;
+		iprevPt.x = cvFloor(prevPt.x);
+		iprevPt.y = cvFloor(prevPt.y);
+
+		if (iprevPt.x < -winSize.width || iprevPt.x >= derivI.cols ||
+			iprevPt.y < -winSize.height || iprevPt.y >= derivI.rows)
+		{
+			if (level == 0)
+			{
+				if (status)
+					status[ptidx] = false;
+				if (err)
+					err[ptidx] = 0;
+			}
+			continue;
+		}
+
+		float a = prevPt.x - iprevPt.x;
+		float b = prevPt.y - iprevPt.y;
+		float w00 = (1.f - a)*(1.f - b), w01 = a * (1.f - b);
+		float w10 = (1.f - a)*b, w11 = a * b;
+
+		int dstep = (int)(derivI.step / derivI.elemSize1());
+		int stepI = (int)(I.step / I.elemSize1());
+		int stepJ = (int)(J.step / J.elemSize1());
+		float A11 = 0, A12 = 0, A22 = 0;
+
+		// extract the patch from the first image, compute covariation matrix of derivatives
+		int x, y;
+		for (y = 0; y < winSize.height; y++)
+		{
+			const T* src = (const T*)I.ptr() + (y + iprevPt.y)*stepI + iprevPt.x*cn;
+			const DT* dsrc = (const DT*)derivI.ptr() + (y + iprevPt.y)*dstep + iprevPt.x*cn2;
+
+			float* Iptr = IWinBuf.ptr<float>(y);
+			float* dIptr = derivIWinBuf.ptr<float>(y);
+
+			for (x = 0; x < winSize.width*cn; x++, dsrc += 2, dIptr += 2)
+			{
+				float ival = src[x] * w00 + src[x + cn] * w01 +
+					src[x + stepI] * w10 + src[x + stepI + cn] * w11;
+				float ixval = dsrc[0] * w00 + dsrc[cn2] * w01 +
+					dsrc[dstep] * w10 + dsrc[dstep + cn2] * w11;
+				float iyval = dsrc[1] * w00 + dsrc[cn2 + 1] * w01 + dsrc[dstep + 1] * w10 +
+					dsrc[dstep + cn2 + 1] * w11;
+
+				Iptr[x] = ival;
+				dIptr[0] = ixval;
+				dIptr[1] = iyval;
+
+				A11 += ixval * ixval;
+				A12 += ixval * iyval;
+				A22 += iyval * iyval;
+			}
+		}
+
+		A11 *= FLT_SCALE;
+		A12 *= FLT_SCALE;
+		A22 *= FLT_SCALE;
+
+		float D = A11 * A22 - A12 * A12;
+		float minEig = (A22 + A11 - std::sqrt((A11 - A22)*(A11 - A22) +
+			4.f*A12*A12)) / (2 * winSize.width*winSize.height);
+
+		if (err && (flags & OPTFLOW_LK_GET_MIN_EIGENVALS) != 0)
+			err[ptidx] = (float)minEig;
+
+		if (minEig < minEigThreshold || D < FLT_EPSILON)
+		{
+			if (level == 0 && status)
+				status[ptidx] = false;
+			continue;
+		}
+
+		D = 1.f / D;
+
+		nextPt -= halfWin;
+		Point2f prevDelta;
+		int niters = 0;
+		float lastStep = 0.f;
+
+		for (j = 0; j < criteria.maxCount; j++)
+		{
+			inextPt.x = cvFloor(nextPt.x);
+			inextPt.y = cvFloor(nextPt.y);
+
+			if (inextPt.x < -winSize.width || inextPt.x >= J.cols ||
+				inextPt.y < -winSize.height || inextPt.y >= J.rows)
+			{
+				if (level == 0 && status)
+					status[ptidx] = false;
+				break;
+			}
+
+			a = nextPt.x - inextPt.x;
+			b = nextPt.y - inextPt.y;
+			w00 = (1.f - a)*(1.f - b); w01 = a * (1.f - b);
+			w10 = (1.f - a)*b; w11 = a * b;
+			float b1 = 0, b2 = 0;
+
+			for (y = 0; y < winSize.height; y++)
+			{
+				const T* Jptr = (const T*)J.ptr() + (y + inextPt.y)*stepJ + inextPt.x*cn;
+				const float* Iptr = IWinBuf.ptr<float>(y);
+				const float* dIptr = derivIWinBuf.ptr<float>(y);
+
+				for (x = 0; x < winSize.width*cn; x++, dIptr += 2)
+				{
+					float diff = Jptr[x] * w00 + Jptr[x + cn] * w01 +
+						Jptr[x + stepJ] * w10 + Jptr[x + stepJ + cn] * w11 - Iptr[x];
+					b1 += diff * dIptr[0];
+					b2 += diff * dIptr[1];
+				}
+			}
+
+			b1 *= B_SCALE;
+			b2 *= B_SCALE;
+
+			Point2f delta((float)((A12*b2 - A22 * b1) * D),
+				(float)((A12*b1 - A11 * b2) * D));
+
+			nextPt += delta;
+			nextPts[ptidx] = nextPt + halfWin;
+
+			double step2 = delta.ddot(delta);
+			niters++;
+			lastStep = (float)std::sqrt(step2);
+
+			if (step2 <= criteria.epsilon)
+				break;
+
+			if (j > 0 && std::abs(delta.x + prevDelta.x) < 0.01 &&
+				std::abs(delta.y + prevDelta.y) < 0.01)
+			{
+				nextPts[ptidx] -= delta * 0.5f;
+				break;
+			}
+			prevDelta = delta;
+		}
+
+		if (iters)
+			iters[ptidx * (maxLevel + 1) + level] = niters;
+		if (residuals)
+			residuals[ptidx * (maxLevel + 1) + level] = lastStep;
+
+		CV_Assert(status != NULL);
+		if (status[ptidx] && err && level == 0 && (flags & OPTFLOW_LK_GET_MIN_EIGENVALS) == 0)
+		{
+			Point2f nextPoint = nextPts[ptidx] - halfWin;
+			Point inextPoint;
+
+			inextPoint.x = cvFloor(nextPoint.x);
+			inextPoint.y = cvFloor(nextPoint.y);
+
+			if (inextPoint.x < -winSize.width || inextPoint.x >= J.cols ||
+				inextPoint.y < -winSize.height || inextPoint.y >= J.rows)
+			{
+				if (status)
+					status[ptidx] = false;
+				continue;
+			}
+
+			float aa = nextPoint.x - inextPoint.x;
+			float bb = nextPoint.y - inextPoint.y;
+			w00 = (1.f - aa)*(1.f - bb); w01 = aa * (1.f - bb);
+			w10 = (1.f - aa)*bb; w11 = aa * bb;
+			float errval = 0.f;
+
+			for (y = 0; y < winSize.height; y++)
+			{
+				const T* Jptr = (const T*)J.ptr() + (y + inextPoint.y)*stepJ + inextPoint.x*cn;
+				const float* Iptr = IWinBuf.ptr<float>(y);
+
+				for (x = 0; x < winSize.width*cn; x++)
+				{
+					float diff = Jptr[x] * w00 + Jptr[x + cn] * w01 +
+						Jptr[x + stepJ] * w10 + Jptr[x + stepJ + cn] * w11 - Iptr[x];
+					errval += std::abs(diff);
+				}
+			}
+			err[ptidx] = errval * 1.f / (winSize.width*cn*winSize.height);
+		}
+	}
+}
+
+namespace
+{
+	// Builds one level of the optical flow pyramid together with its derivatives in horizontal
+	// bands of rows: every band is downsampled from the previous level, differentiated while it is
+	// still in cache and gets its left and right borders. Top and bottom borders are made by the caller.
+	class LKPyramidLevelInvoker : public cv::ParallelLoopBody
+	{
+	public:
+		LKPyramidLevelInvoker(const cv::Mat& _prevLevel, cv::Mat& _paddedLevel, cv::Mat* _paddedDeriv,
+			cv::Size _border, bool _buildLevel, int _pyrBorder, int _derivBorder) :
+			prevLevel(_prevLevel), paddedLevel(_paddedLevel), paddedDeriv(_paddedDeriv),
+			border(_border), buildLevel(_buildLevel), pyrBorder(_pyrBorder), derivBorder(_derivBorder)
+		{
+			level = paddedLevel(cv::Rect(border.width, border.height,
+				paddedLevel.cols - border.width * 2, paddedLevel.rows - border.height * 2));
+		}
+
+		void operator()(const cv::Range& range) const
+		{
+			using namespace cv;
+
+			int rows = level.rows;
+			// rows [b0, b1) of the level available in band, the Scharr filter needs one row around range
+			int b0 = 0, b1 = rows;
+			Mat band = level;
+
+			if (buildLevel)
+			{
+				b0 = std::max(range.start - 1, 0);
+				b1 = std::min(range.end + 1, rows);
+
+				// the 5x5 kernel of pyrDown needs two source rows around every output row;
+				// the image edges are handled by pyrDown itself
+				int s0 = b0 > 0 ? b0 * 2 - 2 : 0;
+				int s1 = b1 < rows ? std::min(b1 * 2 + 1, prevLevel.rows) : prevLevel.rows;
+				Mat temp;
+				pyrDown(prevLevel.rowRange(s0, s1), temp, Size(level.cols, (s1 - s0 + 1) / 2));
+				band = temp.rowRange(b0 - s0 / 2, b1 - s0 / 2);
+
+				band.rowRange(range.start - b0, range.end - b0).copyTo(level.rowRange(range));
+				if (pyrBorder != BORDER_TRANSPARENT)
+					copyMakeBorder(level.rowRange(range), paddedLevel.rowRange(range + border.height),
+						0, 0, border.width, border.width, pyrBorder | BORDER_ISOLATED);
+			}
+
+			if (paddedDeriv)
+			{
+				Mat derivI = (*paddedDeriv)(Rect(border.width, border.height, level.cols, rows));
+				Mat derivBand = derivI.rowRange(b0, b1);
+				calcSharrDeriv(band, derivBand, range - b0);
+
+				if (derivBorder != BORDER_TRANSPARENT)
+					copyMakeBorder(derivI.rowRange(range), paddedDeriv->rowRange(range + border.height),
+						0, 0, border.width, border.width, derivBorder | BORDER_ISOLATED);
+			}
+		}
+
+		// the rows of a band, small enough to keep the band and its derivatives in cache
+		static const int BAND_ROWS = 32;
+
+	private:
+		const cv::Mat& prevLevel;
+		cv::Mat& paddedLevel;
+		cv::Mat* paddedDeriv;
+		cv::Mat level;
+		cv::Size border;
+		bool buildLevel;
+		int pyrBorder;
+		int derivBorder;
+	};
+
+	// adds the top and bottom borders to an image whose left and right borders have already been made
+	static void makeVerticalBorder(cv::Mat& padded, cv::Size border, int borderType)
+	{
+		if (borderType == cv::BORDER_TRANSPARENT)
+			return;
+		cv::Mat inner = padded.rowRange(border.height, padded.rows - border.height);
+		cv::copyMakeBorder(inner, padded, border.height, border.height, 0, 0, borderType | cv::BORDER_ISOLATED);
+	}
+}
+
 int cv::buildOpticalFlowPyramid(InputArray _img, OutputArrayOfArrays pyramid, Size winSize, int maxLevel, bool withDerivatives,
 	int pyrBorder, int derivBorder, bool tryReuseInputImage)
 {
 	CV_INSTRUMENT_REGION()
 
 		Mat img = _img.getMat();
-	CV_Assert(img.depth() == CV_8U && winSize.width > 2 && winSize.height > 2);
+	CV_Assert((img.depth() == CV_8U || img.depth() == CV_16U || img.depth() == CV_32F) &&
+		winSize.width > 2 && winSize.height > 2);
 	int pyrstep = withDerivatives ? 2 : 1;
 
 	pyramid.create(1, (maxLevel + 1) * pyrstep, 0 /*type*/, -1, true, 0);
 
-	int derivType = CV_MAKETYPE(DataType<cv::detail::deriv_type>::depth, img.channels() * 2);
+	int derivType = CV_MAKETYPE(cv::detail::getDerivDepth(img.depth()), img.channels() * 2);
 
 	//level 0
 	bool lvl0IsSet = false;
@@ -702,28 +1071,38 @@ int cv::buildOpticalFlowPyramid(InputArray _img, OutputArrayOfArrays pyramid, Si
 		temp.adjustROI(-winSize.height, -winSize.height, -winSize.width, -winSize.width);
 	}
 
-	Size sz = img.size();
-	Mat prevLevel = pyramid.getMatRef(0);
-	Mat thisLevel = prevLevel;
+	// the number of levels whose size exceeds the window
+	int levels = 0;
+	for (Size lsz = img.size(); levels < maxLevel; levels++)
+	{
+		lsz = Size((lsz.width + 1) / 2, (lsz.height + 1) / 2);
+		if (lsz.width <= winSize.width || lsz.height <= winSize.height)
+			break;
+	}
+	if (levels < maxLevel)
+		pyramid.create(1, (levels + 1) * pyrstep, 0 /*type*/, -1, true, 0);
 
-	for (int level = 0; level <= maxLevel; ++level)
+	// the padded buffers of all the levels are allocated first, so that the levels can be built in one pass
+	std::vector<Mat> paddedLevels(levels + 1), paddedDerivs(levels + 1), pyrLevels(levels + 1);
+	Size sz = img.size();
+	for (int level = 0; level <= levels; ++level)
 	{
+		Mat& temp = pyramid.getMatRef(level * pyrstep);
 		if (level != 0)
 		{
-			Mat& temp = pyramid.getMatRef(level * pyrstep);
-
 			if (!temp.empty())
 				temp.adjustROI(winSize.height, winSize.height, winSize.width, winSize.width);
 			if (temp.type() != img.type() || temp.cols != winSize.width * 2 + sz.width || temp.rows != winSize.height * 2 + sz.height)
 				temp.create(sz.height + winSize.height * 2, sz.width + winSize.width * 2, img.type());
-
-			thisLevel = temp(Rect(winSize.width, winSize.height, sz.width, sz.height));
-			pyrDown(prevLevel, thisLevel, sz);
-
-			if (pyrBorder != BORDER_TRANSPARENT)
-				copyMakeBorder(thisLevel, temp, winSize.height, winSize.height, winSize.width, winSize.width, pyrBorder | BORDER_ISOLATED);
+			paddedLevels[level] = temp;
 			temp.adjustROI(-winSize.height, -winSize.height, -winSize.width, -winSize.width);
 		}
+		else
+		{
+			paddedLevels[level] = temp;
+			paddedLevels[level].adjustROI(winSize.height, winSize.height, winSize.width, winSize.width);
+		}
+		pyrLevels[level] = temp;
 
 		if (withDerivatives)
 		{
@@ -733,32 +1112,200 @@ int cv::buildOpticalFlowPyramid(InputArray _img, OutputArrayOfArrays pyramid, Si
 				deriv.adjustROI(winSize.height, winSize.height, winSize.width, winSize.width);
 			if (deriv.type() != derivType || deriv.cols != winSize.width * 2 + sz.width || deriv.rows != winSize.height * 2 + sz.height)
 				deriv.create(sz.height + winSize.height * 2, sz.width + winSize.width * 2, derivType);
-
-			Mat derivI = deriv(Rect(winSize.width, winSize.height, sz.width, sz.height));
-			calcSharrDeriv(thisLevel, derivI);
-
-			if (derivBorder != BORDER_TRANSPARENT)
-				copyMakeBorder(derivI, deriv, winSize.height, winSize.height, winSize.width, winSize.width, derivBorder | BORDER_ISOLATED);
+			paddedDerivs[level] = deriv;
 			deriv.adjustROI(-winSize.height, -winSize.height, -winSize.width, -winSize.width);
 		}
 
 		sz = Size((sz.width + 1) / 2, (sz.height + 1) / 2);
-		if (sz.width <= winSize.width || sz.height <= winSize.height)
+	}
+
+	// without derivatives, two or more levels are built by the fused pyrDown pass of buildPyramid, which
+	// computes every level while the rows of the previous one are still in cache; the level headers already
+	// have the right size, so buildPyramid writes into the padded buffers. With derivatives, every level is
+	// built in bands together with its derivatives instead, which keeps the band in cache for the Scharr filter.
+	bool fused = levels > 1 && !withDerivatives;
+	if (fused)
+	{
+		std::vector<Mat> built(pyrLevels);
+		buildPyramid(pyrLevels[0], built, levels);
+		for (int level = 1; level <= levels; ++level)
+			CV_Assert(built[level].data == pyrLevels[level].data);
+	}
+
+	for (int level = 0; level <= levels; ++level)
+	{
+		bool buildLevel = level != 0 && !fused;
+		if (buildLevel || withDerivatives)
 		{
-			pyramid.create(1, (level + 1) * pyrstep, 0 /*type*/, -1, true, 0);//check this
-			return level;
+			const Mat& prevLevel = pyrLevels[std::max(level - 1, 0)];
+			LKPyramidLevelInvoker invoker(prevLevel, paddedLevels[level], withDerivatives ? &paddedDerivs[level] : 0,
+				winSize, buildLevel, pyrBorder, derivBorder);
+			int rows = pyrLevels[level].rows;
+			parallel_for_(Range(0, rows), invoker,
+				(rows + LKPyramidLevelInvoker::BAND_ROWS - 1) / LKPyramidLevelInvoker::BAND_ROWS);
 		}
 
-		prevLevel = thisLevel;
+		if (buildLevel)
+			makeVerticalBorder(paddedLevels[level], winSize, pyrBorder);
+		else if (level != 0 && pyrBorder != BORDER_TRANSPARENT)
+			copyMakeBorder(pyrLevels[level], paddedLevels[level], winSize.height, winSize.height,
+				winSize.width, winSize.width, pyrBorder | BORDER_ISOLATED);
+		if (withDerivatives)
+			makeVerticalBorder(paddedDerivs[level], winSize, derivBorder);
 	}
 
-	return maxLevel;
+	return levels;
 }
 
 namespace cv
 {
 	namespace
 	{
+#ifdef HAVE_TEGRA_OPTIMIZATION
+		typedef tegra::LKTrackerInvoker<cv::detail::LKTrackerInvoker> LKTrackerInvoker;
+#else
+		typedef cv::detail::LKTrackerInvoker LKTrackerInvoker;
+#endif
+
+		// one image pair of calcBatch() together with its point set
+		struct LKBatchStream
+		{
+			LKBatchStream() : prevPyr(0), nextPyr(0), lvlStep1(1), lvlStep2(1), levels(0), npoints(0),
+				prevPts(0), nextPts(0), status(0), err(0), iters(0), residuals(0) { }
+
+			const std::vector<Mat>* prevPyr;
+			const std::vector<Mat>* nextPyr;
+			int lvlStep1, lvlStep2;
+			int levels;
+			// derivatives of prevPyr levels, when the pyramid has been built without them
+			std::vector<Mat> derivs;
+			int npoints;
+			const Point2f* prevPts;
+			Point2f* nextPts;
+			uchar* status;
+			float* err;
+			// optional statistics, see LKTrackerInvoker
+			int* iters;
+			float* residuals;
+
+			const Mat& derivI(int level) const
+			{
+				return lvlStep1 == 1 ? derivs[level] : (*prevPyr)[level * lvlStep1 + 1];
+			}
+		};
+
+		// computes the missing Scharr derivatives of the batch pyramids, one (stream, level) pair per job
+		class LKBatchDerivInvoker : public ParallelLoopBody
+		{
+		public:
+			LKBatchDerivInvoker(std::vector<LKBatchStream>& _streams, const std::vector<Point>& _jobs, Size _winSize) :
+				streams(&_streams), jobs(&_jobs), winSize(_winSize)
+			{
+			}
+
+			void operator()(const Range& range) const
+			{
+				for (int i = range.start; i < range.end; i++)
+				{
+					LKBatchStream& st = (*streams)[(*jobs)[i].x];
+					int level = (*jobs)[i].y;
+					Mat& derivI = st.derivs[level];
+					Mat _derivI = derivI;
+					_derivI.adjustROI(winSize.height, winSize.height, winSize.width, winSize.width);
+
+					calcSharrDeriv((*st.prevPyr)[level * st.lvlStep1], derivI);
+					copyMakeBorder(derivI, _derivI, winSize.height, winSize.height, winSize.width, winSize.width, BORDER_CONSTANT | BORDER_ISOLATED);
+				}
+			}
+
+		private:
+			std::vector<LKBatchStream>* streams;
+			const std::vector<Point>* jobs;
+			Size winSize;
+		};
+
+		// work limit of a single tracking call, shared by all the threads
+		struct LKBudget
+		{
+			LKBudget() : remaining(INT_MAX), deadline(0) { }
+
+			bool exhausted() const
+			{
+				// other threads may be decrementing the counter, so it is read atomically too
+				return CV_XADD((int*)&remaining, 0) <= 0 || (deadline != 0 && getTickCount() >= deadline);
+			}
+
+			// iterations left, decremented with CV_XADD when a chunk is done
+			volatile int remaining;
+			// tick count at which no new chunk may start, 0 if the time is not limited
+			int64 deadline;
+		};
+
+		// tracks a chunk of points of one stream through all its pyramid levels
+		class LKBatchInvoker : public ParallelLoopBody
+		{
+		public:
+			LKBatchInvoker(const std::vector<LKBatchStream>& _streams, const std::vector<Point3i>& _chunks,
+				Size _winSize, TermCriteria _criteria, int _flags, float _minEigThreshold, LKBudget* _budget, int* _cursor) :
+				streams(&_streams), chunks(&_chunks), winSize(_winSize), criteria(_criteria),
+				flags(_flags), minEigThreshold(_minEigThreshold), budget(_budget), cursor(_cursor)
+			{
+			}
+
+			void operator()(const Range& range) const
+			{
+				for (int i = range.start; i < range.end; i++)
+				{
+					// with a cursor the chunks are taken in order whatever the range, so the chunks
+					// of the earlier points always start before the later ones
+					const Point3i& chunk = (*chunks)[cursor ? CV_XADD(cursor, 1) : i];
+					const LKBatchStream& st = (*streams)[chunk.x];
+
+					if (budget && budget->exhausted())
+					{
+						for (int ptidx = chunk.y; ptidx < chunk.z; ptidx++)
+						{
+							if (!(flags & OPTFLOW_USE_INITIAL_FLOW))
+								st.nextPts[ptidx] = st.prevPts[ptidx];
+							st.status[ptidx] = 0;
+							if (st.err)
+								st.err[ptidx] = 0.f;
+						}
+						continue;
+					}
+
+					for (int level = st.levels; level >= 0; level--)
+					{
+						LKTrackerInvoker tracker((*st.prevPyr)[level * st.lvlStep1], st.derivI(level),
+							(*st.nextPyr)[level * st.lvlStep2], st.prevPts, st.nextPts,
+							st.status, st.err,
+							winSize, criteria, level, st.levels,
+							flags, minEigThreshold, st.iters, st.residuals);
+						tracker(Range(chunk.y, chunk.z));
+					}
+
+					if (budget)
+					{
+						int used = 0;
+						const int* iters = st.iters + chunk.y * (st.levels + 1);
+						for (int k = 0; k < (chunk.z - chunk.y) * (st.levels + 1); k++)
+							used += iters[k];
+						CV_XADD((int*)&budget->remaining, -used);
+					}
+				}
+			}
+
+		private:
+			const std::vector<LKBatchStream>* streams;
+			const std::vector<Point3i>* chunks;
+			Size winSize;
+			TermCriteria criteria;
+			int flags;
+			float minEigThreshold;
+			LKBudget* budget;
+			int* cursor;
+		};
+
 		class SparsePyrLKOpticalFlowImpl : public SparsePyrLKOpticalFlow
 		{
 			struct dim3
@@ -772,11 +1319,13 @@ namespace cv
 				TermCriteria criteria_ = TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 30, 0.01),
 				int flags_ = 0,
 				double minEigThreshold_ = 1e-4) :
-				winSize(winSize_), maxLevel(maxLevel_), criteria(criteria_), flags(flags_), minEigThreshold(minEigThreshold_)
+				winSize(winSize_), maxLevel(maxLevel_), criteria(criteria_), flags(flags_), minEigThreshold(minEigThreshold_),
+				iterationBudget(0), timeBudget(0), maxFBError(1.), streamFrames(0)
 #ifdef HAVE_OPENCL
 				, iters(criteria_.maxCount), derivLambda(criteria_.epsilon), useInitialFlow(0 != (flags_ & OPTFLOW_LK_GET_MIN_EIGENVALS)), waveSize(0)
 #endif
 			{
+				streamLevels[0] = streamLevels[1] = 0;
 			}
 
 			virtual Size getWinSize() const { return winSize; }
@@ -799,12 +1348,67 @@ namespace cv
 				OutputArray status,
 				OutputArray err = cv::noArray());
 
+			virtual void pushFrame(InputArray img);
+
+			virtual void track(InputArray prevPts, InputOutputArray nextPts,
+				OutputArray status,
+				OutputArray err = cv::noArray());
+
+			virtual void resetFrames();
+
+			virtual void calcBatch(const std::vector<std::vector<Mat> >& prevPyramids,
+				const std::vector<std::vector<Mat> >& nextPyramids,
+				InputArrayOfArrays prevPts, InputOutputArrayOfArrays nextPts,
+				OutputArrayOfArrays status,
+				OutputArrayOfArrays err = cv::noArray());
+
+			virtual void getLastStatistics(OutputArray iterations, OutputArray residuals = cv::noArray()) const;
+
+			virtual void setIterationBudget(int maxIterations) { iterationBudget = std::max(maxIterations, 0); }
+			virtual int getIterationBudget() const { return iterationBudget; }
+
+			virtual void setTimeBudget(double maxTimeMs) { timeBudget = std::max(maxTimeMs, 0.); }
+			virtual double getTimeBudget() const { return timeBudget; }
+
+			virtual void setMaxFBError(double maxFBError_) { maxFBError = maxFBError_; }
+			virtual double getMaxFBError() const { return maxFBError; }
+
 		private:
+			int checkPyramid(const std::vector<Mat>& pyr, int& lvlStep) const;
+
+			int createOutputs(InputArray prevPts, InputOutputArray nextPts,
+				OutputArray status, OutputArray err, int idx,
+				const Point2f*& prevPtsPtr, Point2f*& nextPtsPtr, uchar*& statusPtr, float*& errPtr) const;
+
+			TermCriteria normalizedCriteria() const;
+
+			bool startBudget(LKBudget& budget) const;
+
+			void trackStreams(std::vector<LKBatchStream>& streams, int flags_, LKBudget* budget);
+
+			void checkForwardBackward(const std::vector<LKBatchStream>& streams, LKBudget* budget);
+
+			void calcPyramids(const std::vector<Mat>& prevPyr, int lvlStep1,
+				const std::vector<Mat>& nextPyr, int lvlStep2, int levels,
+				InputArray prevPts, InputOutputArray nextPts,
+				OutputArray status, OutputArray err);
+
 			Size winSize;
 			int maxLevel;
 			TermCriteria criteria;
 			int flags;
 			double minEigThreshold;
+			int iterationBudget;
+			double timeBudget;
+			double maxFBError;
+
+			// statistics of the last calc() or track() call
+			Mat lastIters, lastResiduals;
+
+			// streaming mode state, see pushFrame()
+			std::vector<Mat> streamPyr[2];
+			int streamLevels[2];
+			int streamFrames;
 		};
 
 
@@ -824,132 +1428,438 @@ namespace cv
 			CV_OVX_RUN(false,
 				openvx_pyrlk(_prevImg, _nextImg, _prevPts, _nextPts, _status, _err))
 #endif
-			Mat prevPtsMat = _prevPts.getMat();
-			const int derivDepth = DataType<cv::detail::deriv_type>::depth;
-
 			CV_Assert(maxLevel >= 0 && winSize.width > 2 && winSize.height > 2);
 
-			int level = 0, i, npoints;
-			CV_Assert((npoints = prevPtsMat.checkVector(2, CV_32F, true)) >= 0);
+			std::vector<Mat> prevPyr, nextPyr;
+			int levels1 = -1;
+			int lvlStep1 = 1;
+			int levels2 = -1;
+			int lvlStep2 = 1;
+			// levels of this call only, the maxLevel setting is also used by pushFrame/track
+			int levels = maxLevel;
+
+			if (_prevImg.kind() == _InputArray::STD_VECTOR_MAT)
+			{
+				_prevImg.getMatVector(prevPyr);
+				levels1 = checkPyramid(prevPyr, lvlStep1);
+
+				if (levels1 < levels)
+					levels = levels1;
+			}
 
-			if (npoints == 0)
+			if (_nextImg.kind() == _InputArray::STD_VECTOR_MAT)
 			{
-				_nextPts.release();
-				_status.release();
-				_err.release();
-				return;
+				_nextImg.getMatVector(nextPyr);
+				levels2 = checkPyramid(nextPyr, lvlStep2);
+
+				if (levels2 < levels)
+					levels = levels2;
 			}
 
-			if (!(flags & OPTFLOW_USE_INITIAL_FLOW))
-				_nextPts.create(prevPtsMat.size(), prevPtsMat.type(), -1, true);
+			if (levels1 < 0)
+				levels = buildOpticalFlowPyramid(_prevImg, prevPyr, winSize, levels, false);
 
-			Mat nextPtsMat = _nextPts.getMat();
-			CV_Assert(nextPtsMat.checkVector(2, CV_32F, true) == npoints);
+			if (levels2 < 0)
+				levels = buildOpticalFlowPyramid(_nextImg, nextPyr, winSize, levels, false);
 
-			const Point2f* prevPts = prevPtsMat.ptr<Point2f>();
-			Point2f* nextPts = nextPtsMat.ptr<Point2f>();
+			calcPyramids(prevPyr, lvlStep1, nextPyr, lvlStep2, levels, _prevPts, _nextPts, _status, _err);
+		}
 
-			_status.create((int)npoints, 1, CV_8U, -1, true);
-			Mat statusMat = _status.getMat(), errMat;
-			CV_Assert(statusMat.isContinuous());
-			uchar* status = statusMat.ptr();
-			float* err = 0;
+		void SparsePyrLKOpticalFlowImpl::pushFrame(InputArray _img)
+		{
+			CV_INSTRUMENT_REGION()
 
-			for (i = 0; i < npoints; i++)
-				status[i] = true;
+			CV_Assert(maxLevel >= 0 && winSize.width > 2 && winSize.height > 2);
 
-			if (_err.needed())
+			Mat img = _img.getMat();
+			if (streamFrames > 0)
 			{
-				_err.create((int)npoints, 1, CV_32F, -1, true);
-				errMat = _err.getMat();
-				CV_Assert(errMat.isContinuous());
-				err = errMat.ptr<float>();
+				const Mat& last = streamPyr[1][0];
+				if (last.size() != img.size() || last.type() != img.type())
+					streamFrames = 0;
 			}
 
-			std::vector<Mat> prevPyr, nextPyr;
-			int levels1 = -1;
-			int lvlStep1 = 1;
-			int levels2 = -1;
-			int lvlStep2 = 1;
+			// the older pyramid is not needed any more, its buffers are recycled for the new frame
+			std::swap(streamPyr[0], streamPyr[1]);
+			std::swap(streamLevels[0], streamLevels[1]);
 
-			if (_prevImg.kind() == _InputArray::STD_VECTOR_MAT)
-			{
-				_prevImg.getMatVector(prevPyr);
+			// do not reuse the input image: the caller may overwrite it before the frame is tracked
+			streamLevels[1] = buildOpticalFlowPyramid(img, streamPyr[1], winSize, maxLevel, true,
+				BORDER_REFLECT_101, BORDER_CONSTANT, false);
+			streamFrames = std::min(streamFrames + 1, 2);
+		}
+
+		void SparsePyrLKOpticalFlowImpl::track(InputArray _prevPts, InputOutputArray _nextPts,
+			OutputArray _status, OutputArray _err)
+		{
+			CV_INSTRUMENT_REGION()
+
+			CV_Assert(streamFrames > 0);
+
+			int prevIdx = streamFrames > 1 ? 0 : 1;
+			int levels = std::min(std::min(streamLevels[prevIdx], streamLevels[1]), maxLevel);
+
+			calcPyramids(streamPyr[prevIdx], 2, streamPyr[1], 2, levels, _prevPts, _nextPts, _status, _err);
+		}
+
+		void SparsePyrLKOpticalFlowImpl::resetFrames()
+		{
+			streamPyr[0].clear();
+			streamPyr[1].clear();
+			streamLevels[0] = streamLevels[1] = 0;
+			streamFrames = 0;
+		}
+
+		void SparsePyrLKOpticalFlowImpl::calcBatch(const std::vector<std::vector<Mat> >& prevPyramids,
+			const std::vector<std::vector<Mat> >& nextPyramids,
+			InputArrayOfArrays _prevPts, InputOutputArrayOfArrays _nextPts,
+			OutputArrayOfArrays _status, OutputArrayOfArrays _err)
+		{
+			CV_INSTRUMENT_REGION()
+
+			CV_Assert(maxLevel >= 0 && winSize.width > 2 && winSize.height > 2);
+
+			int i, nstreams = (int)prevPyramids.size();
+			CV_Assert(nextPyramids.size() == prevPyramids.size() && (int)_prevPts.total() == nstreams);
 
-				levels1 = int(prevPyr.size()) - 1;
-				CV_Assert(levels1 >= 0);
+			if (!(flags & OPTFLOW_USE_INITIAL_FLOW))
+				_nextPts.create(nstreams, 1, 0, -1, true);
+			CV_Assert((int)_nextPts.total() == nstreams);
+			_status.create(nstreams, 1, 0, -1, true);
+			if (_err.needed())
+				_err.create(nstreams, 1, 0, -1, true);
 
-				if (levels1 % 2 == 1 && prevPyr[0].channels() * 2 == prevPyr[1].channels() && prevPyr[1].depth() == derivDepth)
+			std::vector<LKBatchStream> streams(nstreams);
+			std::vector<Mat> iterBufs;
+			bool useBudget = iterationBudget > 0 || timeBudget > 0;
+			if (useBudget)
+				iterBufs.resize(nstreams);
+
+			for (i = 0; i < nstreams; i++)
+			{
+				LKBatchStream& st = streams[i];
+				st.prevPyr = &prevPyramids[i];
+				st.nextPyr = &nextPyramids[i];
+				st.levels = std::min(std::min(checkPyramid(prevPyramids[i], st.lvlStep1),
+					checkPyramid(nextPyramids[i], st.lvlStep2)), maxLevel);
+				st.npoints = createOutputs(_prevPts, _nextPts, _status, _err, i,
+					st.prevPts, st.nextPts, st.status, st.err);
+
+				// the budget needs the iteration counts, they are not reported for calcBatch though
+				if (useBudget && st.npoints > 0)
 				{
-					lvlStep1 = 2;
-					levels1 /= 2;
+					iterBufs[i] = Mat::zeros(st.npoints, st.levels + 1, CV_32S);
+					st.iters = iterBufs[i].ptr<int>();
 				}
 
-				// ensure that pyramid has reqired padding
-				if (levels1 > 0)
+				for (int level = 0; level <= st.levels; level++)
 				{
-					Size fullSize;
-					Point ofs;
-					prevPyr[lvlStep1].locateROI(fullSize, ofs);
-					CV_Assert(ofs.x >= winSize.width && ofs.y >= winSize.height
-						&& ofs.x + prevPyr[lvlStep1].cols + winSize.width <= fullSize.width
-						&& ofs.y + prevPyr[lvlStep1].rows + winSize.height <= fullSize.height);
+					CV_Assert(prevPyramids[i][level * st.lvlStep1].size() == nextPyramids[i][level * st.lvlStep2].size());
+					CV_Assert(prevPyramids[i][level * st.lvlStep1].type() == nextPyramids[i][level * st.lvlStep2].type());
 				}
+			}
+
+			LKBudget budget;
+			useBudget = startBudget(budget);
+			trackStreams(streams, flags, useBudget ? &budget : 0);
+
+			if (flags & OPTFLOW_LK_FORWARD_BACKWARD)
+				checkForwardBackward(streams, useBudget ? &budget : 0);
+		}
 
-				if (levels1 < maxLevel)
-					maxLevel = levels1;
+		void SparsePyrLKOpticalFlowImpl::getLastStatistics(OutputArray iterations, OutputArray residuals) const
+		{
+			lastIters.copyTo(iterations);
+			if (residuals.needed())
+				lastResiduals.copyTo(residuals);
+		}
+
+		bool SparsePyrLKOpticalFlowImpl::startBudget(LKBudget& budget) const
+		{
+			if (iterationBudget > 0)
+				budget.remaining = iterationBudget;
+			if (timeBudget > 0)
+				budget.deadline = getTickCount() + std::max((int64)(timeBudget * 1e-3 * getTickFrequency()), (int64)1);
+			return iterationBudget > 0 || timeBudget > 0;
+		}
+
+		void SparsePyrLKOpticalFlowImpl::trackStreams(std::vector<LKBatchStream>& streams, int flags_, LKBudget* budget)
+		{
+			int i, nstreams = (int)streams.size(), totalPoints = 0;
+			bool useBudget = budget != 0;
+
+			std::vector<Point> derivJobs;
+			for (i = 0; i < nstreams; i++)
+			{
+				LKBatchStream& st = streams[i];
+				totalPoints += st.npoints;
+				CV_Assert(!useBudget || st.npoints == 0 || st.iters);
+
+				if (st.npoints == 0 || st.lvlStep1 == 2)
+					continue;
+
+				// dI/dx ~ Ix, dI/dy ~ Iy; all the levels are kept, the buffers are filled in parallel below
+				st.derivs.resize(st.levels + 1);
+				for (int level = 0; level <= st.levels; level++)
+				{
+					const Mat& img = (*st.prevPyr)[level];
+					Mat _derivI(img.rows + winSize.height * 2, img.cols + winSize.width * 2,
+						CV_MAKETYPE(cv::detail::getDerivDepth(img.depth()), img.channels() * 2));
+					st.derivs[level] = _derivI(Rect(winSize.width, winSize.height, img.cols, img.rows));
+					derivJobs.push_back(Point(i, level));
+				}
 			}
 
-			if (_nextImg.kind() == _InputArray::STD_VECTOR_MAT)
+			if (totalPoints == 0)
+				return;
+
+			if (!derivJobs.empty())
+				parallel_for_(Range(0, (int)derivJobs.size()), LKBatchDerivInvoker(streams, derivJobs, winSize));
+
+			// a few chunks per thread balance the load, while keeping chunks large enough to amortize
+			// the per-chunk setup of the tracker; with a budget the smallest chunks give the finest priorities
+			const int minChunkSize = 16;
+			int chunkSize = useBudget ? minChunkSize :
+				std::max(totalPoints / (std::max(getNumThreads(), 1) * 4), minChunkSize);
+			std::vector<Point3i> chunks;
+			for (i = 0; i < nstreams; i++)
+				for (int start = 0; start < streams[i].npoints; start += chunkSize)
+					chunks.push_back(Point3i(i, start, std::min(start + chunkSize, streams[i].npoints)));
+
+			// every index of the range takes exactly one chunk from the cursor
+			int cursor = 0;
+			parallel_for_(Range(0, (int)chunks.size()), LKBatchInvoker(streams, chunks,
+				winSize, normalizedCriteria(), flags_, (float)minEigThreshold, budget, useBudget ? &cursor : 0));
+		}
+
+		void SparsePyrLKOpticalFlowImpl::checkForwardBackward(const std::vector<LKBatchStream>& streams, LKBudget* budget)
+		{
+			int i, k, nstreams = (int)streams.size();
+
+			// the points lost by the forward pass are not tracked back, the others are packed together
+			std::vector<LKBatchStream> back(nstreams);
+			std::vector<std::vector<int> > idx(nstreams);
+			std::vector<Mat> ptsBuf(nstreams), statusBuf(nstreams), itersBuf(nstreams);
+
+			for (i = 0; i < nstreams; i++)
 			{
-				_nextImg.getMatVector(nextPyr);
+				const LKBatchStream& fwd = streams[i];
+				for (k = 0; k < fwd.npoints; k++)
+				{
+					if (fwd.status[k])
+						idx[i].push_back(k);
+					else if (fwd.err)
+						fwd.err[k] = FLT_MAX;
+				}
+
+				LKBatchStream& st = back[i];
+				st.prevPyr = fwd.nextPyr;
+				st.nextPyr = fwd.prevPyr;
+				st.lvlStep1 = fwd.lvlStep2;
+				st.lvlStep2 = fwd.lvlStep1;
+				st.levels = fwd.levels;
+				st.npoints = (int)idx[i].size();
+				if (st.npoints == 0)
+					continue;
 
-				levels2 = int(nextPyr.size()) - 1;
-				CV_Assert(levels2 >= 0);
+				ptsBuf[i].create(st.npoints * 2, 1, CV_32FC2);
+				statusBuf[i] = Mat::ones(st.npoints, 1, CV_8U);
+				Point2f* pts = ptsBuf[i].ptr<Point2f>();
+				for (k = 0; k < st.npoints; k++)
+					pts[k] = fwd.nextPts[idx[i][k]];
 
-				if (levels2 % 2 == 1 && nextPyr[0].channels() * 2 == nextPyr[1].channels() && nextPyr[1].depth() == derivDepth)
+				st.prevPts = pts;
+				st.nextPts = pts + st.npoints;
+				st.status = statusBuf[i].ptr();
+				if (budget)
 				{
-					lvlStep2 = 2;
-					levels2 /= 2;
+					itersBuf[i] = Mat::zeros(st.npoints, st.levels + 1, CV_32S);
+					st.iters = itersBuf[i].ptr<int>();
 				}
+			}
 
-				// ensure that pyramid has reqired padding
-				if (levels2 > 0)
+			trackStreams(back, flags & ~(OPTFLOW_USE_INITIAL_FLOW | OPTFLOW_LK_GET_MIN_EIGENVALS), budget);
+
+			for (i = 0; i < nstreams; i++)
+			{
+				const LKBatchStream& fwd = streams[i];
+				const LKBatchStream& st = back[i];
+				for (k = 0; k < st.npoints; k++)
 				{
-					Size fullSize;
-					Point ofs;
-					nextPyr[lvlStep2].locateROI(fullSize, ofs);
-					CV_Assert(ofs.x >= winSize.width && ofs.y >= winSize.height
-						&& ofs.x + nextPyr[lvlStep2].cols + winSize.width <= fullSize.width
-						&& ofs.y + nextPyr[lvlStep2].rows + winSize.height <= fullSize.height);
+					int ptidx = idx[i][k];
+					float fbErr = st.status[k] ? (float)norm(st.nextPts[k] - fwd.prevPts[ptidx]) : FLT_MAX;
+					if (fbErr > maxFBError)
+						fwd.status[ptidx] = 0;
+					if (fwd.err)
+						fwd.err[ptidx] = fbErr;
 				}
+			}
+		}
 
-				if (levels2 < maxLevel)
-					maxLevel = levels2;
+		int SparsePyrLKOpticalFlowImpl::checkPyramid(const std::vector<Mat>& pyr, int& lvlStep) const
+		{
+			int levels = int(pyr.size()) - 1;
+			CV_Assert(levels >= 0);
+
+			const int derivDepth = cv::detail::getDerivDepth(pyr[0].depth());
+
+			lvlStep = 1;
+			if (levels % 2 == 1 && pyr[0].channels() * 2 == pyr[1].channels() && pyr[1].depth() == derivDepth)
+			{
+				lvlStep = 2;
+				levels /= 2;
 			}
 
-			if (levels1 < 0)
-				maxLevel = buildOpticalFlowPyramid(_prevImg, prevPyr, winSize, maxLevel, false);
+			// ensure that pyramid has reqired padding
+			if (levels > 0)
+			{
+				Size fullSize;
+				Point ofs;
+				pyr[lvlStep].locateROI(fullSize, ofs);
+				CV_Assert(ofs.x >= winSize.width && ofs.y >= winSize.height
+					&& ofs.x + pyr[lvlStep].cols + winSize.width <= fullSize.width
+					&& ofs.y + pyr[lvlStep].rows + winSize.height <= fullSize.height);
+			}
 
-			if (levels2 < 0)
-				maxLevel = buildOpticalFlowPyramid(_nextImg, nextPyr, winSize, maxLevel, false);
+			return levels;
+		}
+
+		int SparsePyrLKOpticalFlowImpl::createOutputs(InputArray _prevPts, InputOutputArray _nextPts,
+			OutputArray _status, OutputArray _err, int idx,
+			const Point2f*& prevPts, Point2f*& nextPts, uchar*& status, float*& err) const
+		{
+			Mat prevPtsMat = _prevPts.getMat(idx);
+
+			// an empty point set is valid, e.g. a stream of calcBatch() that has lost all its features
+			int i, npoints = 0;
+			if (!prevPtsMat.empty())
+				CV_Assert((npoints = prevPtsMat.checkVector(2, CV_32F, true)) >= 0);
+
+			prevPts = 0;
+			nextPts = 0;
+			status = 0;
+			err = 0;
+
+			if (npoints == 0)
+			{
+				if (idx < 0)
+				{
+					_nextPts.release();
+					_status.release();
+					_err.release();
+				}
+				else
+				{
+					if (!(flags & OPTFLOW_USE_INITIAL_FLOW))
+						_nextPts.create(0, 1, CV_32FC2, idx, true);
+					_status.create(0, 1, CV_8U, idx, true);
+					if (_err.needed())
+						_err.create(0, 1, CV_32F, idx, true);
+				}
+				return 0;
+			}
+
+			if (!(flags & OPTFLOW_USE_INITIAL_FLOW))
+				_nextPts.create(prevPtsMat.size(), prevPtsMat.type(), idx, true);
+
+			Mat nextPtsMat = _nextPts.getMat(idx);
+			CV_Assert(nextPtsMat.checkVector(2, CV_32F, true) == npoints);
+
+			prevPts = prevPtsMat.ptr<Point2f>();
+			nextPts = nextPtsMat.ptr<Point2f>();
+
+			_status.create((int)npoints, 1, CV_8U, idx, true);
+			Mat statusMat = _status.getMat(idx);
+			CV_Assert(statusMat.isContinuous());
+			status = statusMat.ptr();
+
+			for (i = 0; i < npoints; i++)
+				status[i] = true;
 
-			if ((criteria.type & TermCriteria::COUNT) == 0)
-				criteria.maxCount = 30;
+			if (_err.needed())
+			{
+				_err.create((int)npoints, 1, CV_32F, idx, true);
+				Mat errMat = _err.getMat(idx);
+				CV_Assert(errMat.isContinuous());
+				err = errMat.ptr<float>();
+			}
+
+			return npoints;
+		}
+
+		TermCriteria SparsePyrLKOpticalFlowImpl::normalizedCriteria() const
+		{
+			// normalize a copy, the stored criteria must survive repeated calls on the same instance
+			TermCriteria crit = criteria;
+			if ((crit.type & TermCriteria::COUNT) == 0)
+				crit.maxCount = 30;
 			else
-				criteria.maxCount = std::min(std::max(criteria.maxCount, 0), 100);
-			if ((criteria.type & TermCriteria::EPS) == 0)
-				criteria.epsilon = 0.01;
+				crit.maxCount = std::min(std::max(crit.maxCount, 0), 100);
+			if ((crit.type & TermCriteria::EPS) == 0)
+				crit.epsilon = 0.01;
 			else
-				criteria.epsilon = std::min(std::max(criteria.epsilon, 0.), 10.);
-			criteria.epsilon *= criteria.epsilon;
+				crit.epsilon = std::min(std::max(crit.epsilon, 0.), 10.);
+			crit.epsilon *= crit.epsilon;
+			return crit;
+		}
+
+		void SparsePyrLKOpticalFlowImpl::calcPyramids(const std::vector<Mat>& prevPyr, int lvlStep1,
+			const std::vector<Mat>& nextPyr, int lvlStep2, int levels,
+			InputArray _prevPts, InputOutputArray _nextPts,
+			OutputArray _status, OutputArray _err)
+		{
+			const int derivDepth = cv::detail::getDerivDepth(prevPyr[0].depth());
+			int level = 0;
+
+			const Point2f* prevPts = 0;
+			Point2f* nextPts = 0;
+			uchar* status = 0;
+			float* err = 0;
+			int npoints = createOutputs(_prevPts, _nextPts, _status, _err, -1, prevPts, nextPts, status, err);
+
+			lastIters = Mat::zeros(npoints, levels + 1, CV_32S);
+			lastResiduals = Mat::zeros(npoints, levels + 1, CV_32F);
+			if (npoints == 0)
+				return;
+
+			std::vector<LKBatchStream> streams(1);
+			LKBatchStream& st = streams[0];
+			st.prevPyr = &prevPyr;
+			st.nextPyr = &nextPyr;
+			st.lvlStep1 = lvlStep1;
+			st.lvlStep2 = lvlStep2;
+			st.levels = levels;
+			st.npoints = npoints;
+			st.prevPts = prevPts;
+			st.nextPts = nextPts;
+			st.status = status;
+			st.err = err;
+			st.iters = lastIters.ptr<int>();
+			st.residuals = lastResiduals.ptr<float>();
+
+			LKBudget budget;
+			if (startBudget(budget))
+			{
+				for (level = 0; level <= levels; level++)
+				{
+					CV_Assert(prevPyr[level * lvlStep1].size() == nextPyr[level * lvlStep2].size());
+					CV_Assert(prevPyr[level * lvlStep1].type() == nextPyr[level * lvlStep2].type());
+				}
+
+				trackStreams(streams, flags, &budget);
+				if (flags & OPTFLOW_LK_FORWARD_BACKWARD)
+					checkForwardBackward(streams, &budget);
+				return;
+			}
+
+			TermCriteria crit = normalizedCriteria();
 
 			// dI/dx ~ Ix, dI/dy ~ Iy
 			Mat derivIBuf;
 			if (lvlStep1 == 1)
 				derivIBuf.create(prevPyr[0].rows + winSize.height * 2, prevPyr[0].cols + winSize.width * 2, CV_MAKETYPE(derivDepth, prevPyr[0].channels() * 2));
 
-			for (level = maxLevel; level >= 0; level--)
+			for (level = levels; level >= 0; level--)
 			{
 				Mat derivI;
 				if (lvlStep1 == 1)
@@ -967,18 +1877,16 @@ namespace cv
 				CV_Assert(prevPyr[level * lvlStep1].size() == nextPyr[level * lvlStep2].size());
 				CV_Assert(prevPyr[level * lvlStep1].type() == nextPyr[level * lvlStep2].type());
 
-#ifdef HAVE_TEGRA_OPTIMIZATION
-				typedef tegra::LKTrackerInvoker<cv::detail::LKTrackerInvoker> LKTrackerInvoker;
-#else
-				typedef cv::detail::LKTrackerInvoker LKTrackerInvoker;
-#endif
-
 				parallel_for_(Range(0, npoints), LKTrackerInvoker(prevPyr[level * lvlStep1], derivI,
 					nextPyr[level * lvlStep2], prevPts, nextPts,
 					status, err,
-					winSize, criteria, level, maxLevel,
-					flags, (float)minEigThreshold));
+					winSize, crit, level, levels,
+					flags, (float)minEigThreshold,
+					lastIters.ptr<int>(), lastResiduals.ptr<float>()));
 			}
+
+			if (flags & OPTFLOW_LK_FORWARD_BACKWARD)
+				checkForwardBackward(streams, 0);
 		}
 
 	} // namespace
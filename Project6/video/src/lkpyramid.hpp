@@ -6,16 +6,27 @@ namespace cv
 
 		typedef short deriv_type;
 
+		// depth of the Scharr derivatives of an image: 16S for 8U images, 32S for 16U and 32F for 32F ones
+		static inline int getDerivDepth(int depth)
+		{
+			CV_Assert(depth == CV_8U || depth == CV_16U || depth == CV_32F);
+			return depth == CV_8U ? DataType<deriv_type>::depth : depth == CV_16U ? CV_32S : CV_32F;
+		}
+
 		struct LKTrackerInvoker : ParallelLoopBody
 		{
 			LKTrackerInvoker(const Mat& _prevImg, const Mat& _prevDeriv, const Mat& _nextImg,
 				const Point2f* _prevPts, Point2f* _nextPts,
 				uchar* _status, float* _err,
 				Size _winSize, TermCriteria _criteria,
-				int _level, int _maxLevel, int _flags, float _minEigThreshold);
+				int _level, int _maxLevel, int _flags, float _minEigThreshold,
+				int* _iters = 0, float* _residuals = 0);
 
 			void operator()(const Range& range) const;
 
+			// floating-point version of operator() for 16U and 32F images
+			template<typename T, typename DT> void trackFloat(const Range& range) const;
+
 			const Mat* prevImg;
 			const Mat* nextImg;
 			const Mat* prevDeriv;
@@ -29,6 +40,9 @@ namespace cv
 			int maxLevel;
 			int flags;
 			float minEigThreshold;
+			// optional per-point statistics, (maxLevel + 1) elements per point indexed by level
+			int* iters;
+			float* residuals;
 		};
 
 	}// namespace detail
@@ -0,0 +1,743 @@
+#include "precomp.hpp"
+#include <float.h>
+#include "../../core/include/opencv2/core/hal/intrin.hpp"
+
+//
+// 2D dense optical flow algorithm from the following paper:
+// Gunnar Farneback. "Two-Frame Motion Estimation Based on Polynomial Expansion".
+// Proceedings of the 13th Scandinavian Conference on Image Analysis, Gothenburg, Sweden
+//
+
+namespace cv
+{
+	namespace
+	{
+		static void
+			FarnebackPrepareGaussian(int n, double sigma, float *g, float *xg, float *xxg,
+				double &ig11, double &ig03, double &ig33, double &ig55)
+		{
+			if (sigma < FLT_EPSILON)
+				sigma = n * 0.3;
+
+			double s = 0.;
+			for (int x = -n; x <= n; x++)
+			{
+				g[x] = (float)std::exp(-x * x / (2 * sigma*sigma));
+				s += g[x];
+			}
+
+			s = 1. / s;
+			for (int x = -n; x <= n; x++)
+			{
+				g[x] = (float)(g[x] * s);
+				xg[x] = (float)(x*g[x]);
+				xxg[x] = (float)(x*x*g[x]);
+			}
+
+			Mat_<double> G(6, 6);
+			G.setTo(0);
+
+			for (int y = -n; y <= n; y++)
+			{
+				for (int x = -n; x <= n; x++)
+				{
+					G(0, 0) += g[y] * g[x];
+					G(1, 1) += g[y] * g[x] * x*x;
+					G(3, 3) += g[y] * g[x] * x*x*x*x;
+					G(5, 5) += g[y] * g[x] * x*x*y*y;
+				}
+			}
+
+			//G[0][0] = 1.;
+			G(2, 2) = G(0, 3) = G(0, 4) = G(3, 0) = G(4, 0) = G(1, 1);
+			G(4, 4) = G(3, 3);
+			G(3, 4) = G(4, 3) = G(5, 5);
+
+			// invG:
+			// [ x        e  e    ]
+			// [    y             ]
+			// [       y          ]
+			// [ e        z       ]
+			// [ e           z    ]
+			// [                u ]
+			Mat_<double> invG = G.inv(DECOMP_CHOLESKY);
+
+			ig11 = invG(1, 1);
+			ig03 = invG(0, 3);
+			ig33 = invG(3, 3);
+			ig55 = invG(5, 5);
+		}
+
+		// Polynomial expansion of the rows of a CV_32FC1 image. The separable convolutions are done on
+		// planar row buffers, so that both passes can be vectorized, and the rows are processed in parallel.
+		class FarnebackPolyExpInvoker : public ParallelLoopBody
+		{
+		public:
+			FarnebackPolyExpInvoker(const Mat& _src, Mat& _dst, int _n, double _sigma) :
+				src(_src), dst(_dst), n(_n)
+			{
+				kbuf.allocate(n * 6 + 3);
+				g = (float*)kbuf + n;
+				xg = g + n * 2 + 1;
+				xxg = xg + n * 2 + 1;
+				FarnebackPrepareGaussian(n, _sigma, g, xg, xxg, ig11, ig03, ig33, ig55);
+			}
+
+			void operator()(const Range& range) const
+			{
+				int k, x, y, width = src.cols, height = src.rows;
+				int rstep = (int)alignSize(width + n * 2, 4);
+				AutoBuffer<float> _row(rstep * 3 + 4);
+				AutoBuffer<const float*> _srow(n * 2 + 1);
+				float* row0 = alignPtr((float*)_row, 16) + n;
+				float* row1 = row0 + rstep;
+				float* row2 = row1 + rstep;
+				const float** srow = (const float**)_srow + n;
+				float fig11 = (float)ig11, fig03 = (float)ig03, fig33 = (float)ig33, fig55 = (float)ig55;
+
+				for (y = range.start; y < range.end; y++)
+				{
+					float* drow = dst.ptr<float>(y);
+					for (k = -n; k <= n; k++)
+						srow[k] = src.ptr<float>(std::min(std::max(y + k, 0), height - 1));
+
+					// vertical part of convolution:
+					// row0 ~ sum(g*I), row1 ~ sum(y*g*I), row2 ~ sum(y^2*g*I)
+					x = 0;
+#if CV_SIMD128
+					for (; x <= width - 4; x += 4)
+					{
+						v_float32x4 t0 = v_load(srow[0] + x) * v_setall_f32(g[0]);
+						v_float32x4 t1 = v_setzero_f32(), t2 = v_setzero_f32();
+						for (k = 1; k <= n; k++)
+						{
+							v_float32x4 s0 = v_load(srow[-k] + x), s1 = v_load(srow[k] + x);
+							v_float32x4 p = s0 + s1;
+							t0 = v_muladd(p, v_setall_f32(g[k]), t0);
+							t1 = v_muladd(s1 - s0, v_setall_f32(xg[k]), t1);
+							t2 = v_muladd(p, v_setall_f32(xxg[k]), t2);
+						}
+						v_store(row0 + x, t0);
+						v_store(row1 + x, t1);
+						v_store(row2 + x, t2);
+					}
+#endif
+					for (; x < width; x++)
+					{
+						float t0 = srow[0][x] * g[0], t1 = 0.f, t2 = 0.f;
+						for (k = 1; k <= n; k++)
+						{
+							float p = srow[-k][x] + srow[k][x];
+							t0 += g[k] * p;
+							t1 += xg[k] * (srow[k][x] - srow[-k][x]);
+							t2 += xxg[k] * p;
+						}
+						row0[x] = t0;
+						row1[x] = t1;
+						row2[x] = t2;
+					}
+
+					// replicate the border
+					for (x = 1; x <= n; x++)
+					{
+						row0[-x] = row0[0]; row0[width - 1 + x] = row0[width - 1];
+						row1[-x] = row1[0]; row1[width - 1 + x] = row1[width - 1];
+						row2[-x] = row2[0]; row2[width - 1 + x] = row2[width - 1];
+					}
+
+					// horizontal part of convolution;
+					// b1 ~ 1, b2 ~ x, b3 ~ y, b4 ~ x^2, b5 ~ y^2, b6 ~ xy
+					x = 0;
+#if CV_SIMD128
+					for (; x <= width - 4; x += 4)
+					{
+						v_float32x4 g0 = v_setall_f32(g[0]);
+						v_float32x4 b1 = v_load(row0 + x) * g0, b3 = v_load(row1 + x) * g0, b5 = v_load(row2 + x) * g0;
+						v_float32x4 b2 = v_setzero_f32(), b4 = v_setzero_f32(), b6 = v_setzero_f32();
+						for (k = 1; k <= n; k++)
+						{
+							v_float32x4 gk = v_setall_f32(g[k]), xgk = v_setall_f32(xg[k]);
+							v_float32x4 r0p = v_load(row0 + x + k), r0m = v_load(row0 + x - k);
+							v_float32x4 r1p = v_load(row1 + x + k), r1m = v_load(row1 + x - k);
+							v_float32x4 tg = r0p + r0m;
+							b1 = v_muladd(tg, gk, b1);
+							b4 = v_muladd(tg, v_setall_f32(xxg[k]), b4);
+							b2 = v_muladd(r0p - r0m, xgk, b2);
+							b3 = v_muladd(r1p + r1m, gk, b3);
+							b6 = v_muladd(r1p - r1m, xgk, b6);
+							b5 = v_muladd(v_load(row2 + x + k) + v_load(row2 + x - k), gk, b5);
+						}
+
+						float CV_DECL_ALIGNED(16) buf[5][4];
+						v_store_aligned(buf[0], b3 * v_setall_f32(fig11));
+						v_store_aligned(buf[1], b2 * v_setall_f32(fig11));
+						v_store_aligned(buf[2], v_muladd(b5, v_setall_f32(fig33), b1 * v_setall_f32(fig03)));
+						v_store_aligned(buf[3], v_muladd(b4, v_setall_f32(fig33), b1 * v_setall_f32(fig03)));
+						v_store_aligned(buf[4], b6 * v_setall_f32(fig55));
+						for (k = 0; k < 4; k++)
+						{
+							float* d = drow + (x + k) * 5;
+							d[0] = buf[0][k]; d[1] = buf[1][k]; d[2] = buf[2][k]; d[3] = buf[3][k]; d[4] = buf[4][k];
+						}
+					}
+#endif
+					for (; x < width; x++)
+						expandPixel(row0, row1, row2, x, drow + x * 5);
+				}
+			}
+
+			// horizontal part of the convolution and the coefficients of one pixel, used for the tail of the vector loop
+			void expandPixel(const float* row0, const float* row1, const float* row2, int x, float* d) const
+			{
+				float b1 = row0[x] * g[0], b2 = 0, b3 = row1[x] * g[0],
+					b4 = 0, b5 = row2[x] * g[0], b6 = 0;
+
+				for (int k = 1; k <= n; k++)
+				{
+					float tg = row0[x + k] + row0[x - k];
+					b1 += tg * g[k];
+					b4 += tg * xxg[k];
+					b2 += (row0[x + k] - row0[x - k])*xg[k];
+					b3 += (row1[x + k] + row1[x - k])*g[k];
+					b6 += (row1[x + k] - row1[x - k])*xg[k];
+					b5 += (row2[x + k] + row2[x - k])*g[k];
+				}
+
+				float fig11 = (float)ig11, fig03 = (float)ig03, fig33 = (float)ig33, fig55 = (float)ig55;
+
+				// do not store r1
+				d[1] = b2 * fig11;
+				d[0] = b3 * fig11;
+				d[3] = b1 * fig03 + b4 * fig33;
+				d[2] = b1 * fig03 + b5 * fig33;
+				d[4] = b6 * fig55;
+			}
+
+		private:
+			const Mat& src;
+			Mat& dst;
+			int n;
+			AutoBuffer<float> kbuf;
+			float *g, *xg, *xxg;
+			double ig11, ig03, ig33, ig55;
+		};
+
+		static void
+			FarnebackPolyExp(const Mat& src, Mat& dst, int n, double sigma)
+		{
+			CV_Assert(src.type() == CV_32FC1);
+			dst.create(src.rows, src.cols, CV_32FC(5));
+
+			FarnebackPolyExpInvoker invoker(src, dst, n, sigma);
+			parallel_for_(Range(0, src.rows), invoker, src.total() / (double)(1 << 16));
+		}
+
+		class FarnebackUpdateMatricesInvoker : public ParallelLoopBody
+		{
+		public:
+			FarnebackUpdateMatricesInvoker(const Mat& _R0, const Mat& _R1, const Mat& _flow, Mat& _matM) :
+				R0(_R0), R1(_R1), flow(_flow), matM(_matM)
+			{
+			}
+
+			void operator()(const Range& range) const
+			{
+				const int BORDER = 5;
+				static const float border[BORDER] = { 0.14f, 0.14f, 0.4472f, 0.4472f, 0.4472f };
+
+				int x, y, width = flow.cols, height = flow.rows;
+				const float* R1data = R1.ptr<float>();
+				size_t step1 = R1.step / sizeof(R1data[0]);
+
+				for (y = range.start; y < range.end; y++)
+				{
+					const float* fptr = flow.ptr<float>(y);
+					const float* R0ptr = R0.ptr<float>(y);
+					float* M = matM.ptr<float>(y);
+
+					for (x = 0; x < width; x++)
+					{
+						float dx = fptr[x * 2], dy = fptr[x * 2 + 1];
+						float fx = x + dx, fy = y + dy;
+
+						int x1 = cvFloor(fx), y1 = cvFloor(fy);
+						const float* ptr = R1data + y1 * step1 + x1 * 5;
+						float r2, r3, r4, r5, r6;
+
+						fx -= x1; fy -= y1;
+
+						if ((unsigned)x1 < (unsigned)(width - 1) &&
+							(unsigned)y1 < (unsigned)(height - 1))
+						{
+							float a00 = (1.f - fx)*(1.f - fy), a01 = fx * (1.f - fy),
+								a10 = (1.f - fx)*fy, a11 = fx * fy;
+
+							r2 = a00 * ptr[0] + a01 * ptr[5] + a10 * ptr[step1] + a11 * ptr[step1 + 5];
+							r3 = a00 * ptr[1] + a01 * ptr[6] + a10 * ptr[step1 + 1] + a11 * ptr[step1 + 6];
+							r4 = a00 * ptr[2] + a01 * ptr[7] + a10 * ptr[step1 + 2] + a11 * ptr[step1 + 7];
+							r5 = a00 * ptr[3] + a01 * ptr[8] + a10 * ptr[step1 + 3] + a11 * ptr[step1 + 8];
+							r6 = a00 * ptr[4] + a01 * ptr[9] + a10 * ptr[step1 + 4] + a11 * ptr[step1 + 9];
+
+							r4 = (R0ptr[x * 5 + 2] + r4)*0.5f;
+							r5 = (R0ptr[x * 5 + 3] + r5)*0.5f;
+							r6 = (R0ptr[x * 5 + 4] + r6)*0.25f;
+						}
+						else
+						{
+							r2 = r3 = 0.f;
+							r4 = R0ptr[x * 5 + 2];
+							r5 = R0ptr[x * 5 + 3];
+							r6 = R0ptr[x * 5 + 4] * 0.5f;
+						}
+
+						r2 = (R0ptr[x * 5] - r2)*0.5f;
+						r3 = (R0ptr[x * 5 + 1] - r3)*0.5f;
+
+						r2 += r4 * dy + r6 * dx;
+						r3 += r6 * dy + r5 * dx;
+
+						if ((unsigned)(x - BORDER) >= (unsigned)(width - BORDER * 2) ||
+							(unsigned)(y - BORDER) >= (unsigned)(height - BORDER * 2))
+						{
+							float scale = (x < BORDER ? border[x] : 1.f)*
+								(x >= width - BORDER ? border[width - x - 1] : 1.f)*
+								(y < BORDER ? border[y] : 1.f)*
+								(y >= height - BORDER ? border[height - y - 1] : 1.f);
+
+							r2 *= scale; r3 *= scale; r4 *= scale;
+							r5 *= scale; r6 *= scale;
+						}
+
+						M[x * 5] = r4 * r4 + r6 * r6; // G(1,1)
+						M[x * 5 + 1] = (r4 + r5)*r6;  // G(1,2)=G(2,1)
+						M[x * 5 + 2] = r5 * r5 + r6 * r6; // G(2,2)
+						M[x * 5 + 3] = r4 * r2 + r6 * r3; // h(1)
+						M[x * 5 + 4] = r6 * r2 + r5 * r3; // h(2)
+					}
+				}
+			}
+
+		private:
+			const Mat& R0;
+			const Mat& R1;
+			const Mat& flow;
+			Mat& matM;
+		};
+
+		static void
+			FarnebackUpdateMatrices(const Mat& R0, const Mat& R1, const Mat& flow, Mat& matM)
+		{
+			matM.create(flow.rows, flow.cols, CV_32FC(5));
+			parallel_for_(Range(0, flow.rows), FarnebackUpdateMatricesInvoker(R0, R1, flow, matM),
+				flow.total() / (double)(1 << 16));
+		}
+
+		// Solves the blurred 2x2 systems for the flow; every stripe of rows keeps its own running
+		// vertical sums of the box filter, so the stripes are independent.
+		class FarnebackUpdateFlowBlurInvoker : public ParallelLoopBody
+		{
+		public:
+			FarnebackUpdateFlowBlurInvoker(const Mat& _matM, Mat& _flow, int _block_size) :
+				matM(_matM), flow(_flow), block_size(_block_size)
+			{
+			}
+
+			void operator()(const Range& range) const
+			{
+				int x, y, i, width = flow.cols, height = flow.rows;
+				int m = block_size / 2;
+				double scale = 1. / (block_size*block_size);
+
+				AutoBuffer<double> _vsum((width + m * 2 + 2) * 5);
+				double* vsum = (double*)_vsum + (m + 1) * 5;
+
+				for (y = range.start; y < range.end; y++)
+				{
+					double g11, g12, g22, h1, h2;
+					float* fptr = flow.ptr<float>(y);
+
+					// vertical blur
+					if (y == range.start)
+					{
+						const float* srow = matM.ptr<float>(std::max(y - m, 0));
+						for (x = 0; x < width * 5; x++)
+							vsum[x] = srow[x];
+						for (i = y - m + 1; i <= y + m; i++)
+						{
+							srow = matM.ptr<float>(std::min(std::max(i, 0), height - 1));
+							for (x = 0; x < width * 5; x++)
+								vsum[x] += srow[x];
+						}
+					}
+					else
+					{
+						const float* srow0 = matM.ptr<float>(std::max(y - m - 1, 0));
+						const float* srow1 = matM.ptr<float>(std::min(y + m, height - 1));
+						for (x = 0; x < width * 5; x++)
+							vsum[x] += srow1[x] - srow0[x];
+					}
+
+					// update borders
+					for (x = 0; x < (m + 1) * 5; x++)
+					{
+						vsum[-1 - x] = vsum[4 - x];
+						vsum[width * 5 + x] = vsum[width * 5 + x - 5];
+					}
+
+					// init g** and h*
+					g11 = vsum[0] * (m + 2);
+					g12 = vsum[1] * (m + 2);
+					g22 = vsum[2] * (m + 2);
+					h1 = vsum[3] * (m + 2);
+					h2 = vsum[4] * (m + 2);
+
+					for (x = 1; x < m; x++)
+					{
+						g11 += vsum[x * 5];
+						g12 += vsum[x * 5 + 1];
+						g22 += vsum[x * 5 + 2];
+						h1 += vsum[x * 5 + 3];
+						h2 += vsum[x * 5 + 4];
+					}
+
+					// horizontal blur
+					for (x = 0; x < width; x++)
+					{
+						g11 += vsum[(x + m) * 5] - vsum[(x - m) * 5 - 5];
+						g12 += vsum[(x + m) * 5 + 1] - vsum[(x - m) * 5 - 4];
+						g22 += vsum[(x + m) * 5 + 2] - vsum[(x - m) * 5 - 3];
+						h1 += vsum[(x + m) * 5 + 3] - vsum[(x - m) * 5 - 2];
+						h2 += vsum[(x + m) * 5 + 4] - vsum[(x - m) * 5 - 1];
+
+						double g11_ = g11 * scale;
+						double g12_ = g12 * scale;
+						double g22_ = g22 * scale;
+						double h1_ = h1 * scale;
+						double h2_ = h2 * scale;
+
+						double idet = 1. / (g11_*g22_ - g12_ * g12_ + 1e-3);
+
+						fptr[x * 2] = (float)((g11_*h2_ - g12_ * h1_)*idet);
+						fptr[x * 2 + 1] = (float)((g22_*h1_ - g12_ * h2_)*idet);
+					}
+				}
+			}
+
+		private:
+			const Mat& matM;
+			Mat& flow;
+			int block_size;
+		};
+
+		class FarnebackUpdateFlowGaussianInvoker : public ParallelLoopBody
+		{
+		public:
+			FarnebackUpdateFlowGaussianInvoker(const Mat& _matM, Mat& _flow, int _block_size) :
+				matM(_matM), flow(_flow), m(_block_size / 2)
+			{
+				double sigma = m * 0.3, s = 1;
+
+				kernel.allocate(m + 1);
+				kernel[0] = (float)s;
+
+				for (int i = 1; i <= m; i++)
+				{
+					float t = (float)std::exp(-i * i / (2 * sigma*sigma));
+					kernel[i] = t;
+					s += t * 2;
+				}
+
+				s = 1. / s;
+				for (int i = 0; i <= m; i++)
+					kernel[i] = (float)(kernel[i] * s);
+			}
+
+			void operator()(const Range& range) const
+			{
+				int x, y, i, width = flow.cols, height = flow.rows;
+
+				AutoBuffer<float> _vsum((width + m * 2 + 2) * 5 + 16), _hsum(width * 5 + 16);
+				AutoBuffer<const float*> _srow(m * 2 + 1);
+				float* vsum = alignPtr((float*)_vsum + (m + 1) * 5, 16), *hsum = alignPtr((float*)_hsum, 16);
+				const float** srow = (const float**)_srow + m;
+				const float* ker = kernel;
+
+				for (y = range.start; y < range.end; y++)
+				{
+					float* fptr = flow.ptr<float>(y);
+
+					// vertical blur
+					for (i = -m; i <= m; i++)
+						srow[i] = matM.ptr<float>(std::min(std::max(y + i, 0), height - 1));
+
+					x = 0;
+#if CV_SIMD128
+					for (; x <= width * 5 - 4; x += 4)
+					{
+						v_float32x4 s0 = v_load(srow[0] + x) * v_setall_f32(ker[0]);
+						for (i = 1; i <= m; i++)
+							s0 = v_muladd(v_load(srow[i] + x) + v_load(srow[-i] + x), v_setall_f32(ker[i]), s0);
+						v_store(vsum + x, s0);
+					}
+#endif
+					for (; x < width * 5; x++)
+					{
+						float s0 = srow[0][x] * ker[0];
+						for (i = 1; i <= m; i++)
+							s0 += (srow[i][x] + srow[-i][x])*ker[i];
+						vsum[x] = s0;
+					}
+
+					// update borders
+					for (x = 0; x < m * 5; x++)
+					{
+						vsum[-1 - x] = vsum[4 - x];
+						vsum[width * 5 + x] = vsum[width * 5 + x - 5];
+					}
+
+					// horizontal blur
+					x = 0;
+#if CV_SIMD128
+					for (; x <= width * 5 - 4; x += 4)
+					{
+						v_float32x4 s0 = v_load(vsum + x) * v_setall_f32(ker[0]);
+						for (i = 1; i <= m; i++)
+							s0 = v_muladd(v_load(vsum + x - i * 5) + v_load(vsum + x + i * 5), v_setall_f32(ker[i]), s0);
+						v_store_aligned(hsum + x, s0);
+					}
+#endif
+					for (; x < width * 5; x++)
+					{
+						float s0 = vsum[x] * ker[0];
+						for (i = 1; i <= m; i++)
+							s0 += ker[i] * (vsum[x - i * 5] + vsum[x + i * 5]);
+						hsum[x] = s0;
+					}
+
+					for (x = 0; x < width; x++)
+					{
+						double g11 = hsum[x * 5];
+						double g12 = hsum[x * 5 + 1];
+						double g22 = hsum[x * 5 + 2];
+						double h1 = hsum[x * 5 + 3];
+						double h2 = hsum[x * 5 + 4];
+
+						double idet = 1. / (g11*g22 - g12 * g12 + 1e-3);
+
+						fptr[x * 2] = (float)((g11*h2 - g12 * h1)*idet);
+						fptr[x * 2 + 1] = (float)((g22*h1 - g12 * h2)*idet);
+					}
+				}
+			}
+
+		private:
+			const Mat& matM;
+			Mat& flow;
+			int m;
+			AutoBuffer<float> kernel;
+		};
+
+		// One iteration of the flow refinement: the flow is solved from the blurred matrices and then,
+		// unless it is the last iteration, the matrices are recomputed for the new flow.
+		static void
+			FarnebackUpdateFlow(const Mat& R0, const Mat& R1, Mat& flow, Mat& matM,
+				int block_size, bool gaussian, bool update_matrices)
+		{
+			double nstripes = flow.total() / (double)(1 << 14);
+			if (gaussian)
+				parallel_for_(Range(0, flow.rows), FarnebackUpdateFlowGaussianInvoker(matM, flow, block_size), nstripes);
+			else
+				parallel_for_(Range(0, flow.rows), FarnebackUpdateFlowBlurInvoker(matM, flow, block_size), nstripes);
+
+			if (update_matrices)
+				FarnebackUpdateMatrices(R0, R1, flow, matM);
+		}
+
+		class FarnebackOpticalFlowImpl : public FarnebackOpticalFlow
+		{
+		public:
+			FarnebackOpticalFlowImpl(int numLevels = 5, double pyrScale = 0.5, bool fastPyramids = false, int winSize = 13,
+				int numIters = 10, int polyN = 5, double polySigma = 1.1, int flags = 0) :
+				numLevels_(numLevels), pyrScale_(pyrScale), fastPyramids_(fastPyramids), winSize_(winSize),
+				numIters_(numIters), polyN_(polyN), polySigma_(polySigma), flags_(flags)
+			{
+			}
+
+			virtual int getNumLevels() const { return numLevels_; }
+			virtual void setNumLevels(int numLevels) { numLevels_ = numLevels; }
+
+			virtual double getPyrScale() const { return pyrScale_; }
+			virtual void setPyrScale(double pyrScale) { pyrScale_ = pyrScale; }
+
+			virtual bool getFastPyramids() const { return fastPyramids_; }
+			virtual void setFastPyramids(bool fastPyramids) { fastPyramids_ = fastPyramids; }
+
+			virtual int getWinSize() const { return winSize_; }
+			virtual void setWinSize(int winSize) { winSize_ = winSize; }
+
+			virtual int getNumIters() const { return numIters_; }
+			virtual void setNumIters(int numIters) { numIters_ = numIters; }
+
+			virtual int getPolyN() const { return polyN_; }
+			virtual void setPolyN(int polyN) { polyN_ = polyN; }
+
+			virtual double getPolySigma() const { return polySigma_; }
+			virtual void setPolySigma(double polySigma) { polySigma_ = polySigma; }
+
+			virtual int getFlags() const { return flags_; }
+			virtual void setFlags(int flags) { flags_ = flags; }
+
+			virtual void calc(InputArray I0, InputArray I1, InputOutputArray flow);
+			virtual void collectGarbage();
+
+		private:
+			// builds the smoothed floating-point images of all levels
+			void buildPyramid(const Mat& img, std::vector<Mat>& pyr, int levels, bool fast) const;
+
+			int numLevels_;
+			double pyrScale_;
+			bool fastPyramids_;
+			int winSize_;
+			int numIters_;
+			int polyN_;
+			double polySigma_;
+			int flags_;
+
+			std::vector<Mat> pyr0_, pyr1_;
+			Mat R_[2], M_;
+		};
+
+		void FarnebackOpticalFlowImpl::buildPyramid(const Mat& img, std::vector<Mat>& pyr, int levels, bool fast) const
+		{
+			Mat fimg, blurred;
+			img.convertTo(fimg, CV_32F);
+			pyr.resize(levels + 1);
+
+			double scale = 1;
+			for (int k = 0; k <= levels; k++)
+			{
+				if (fast && k > 0)
+				{
+					// every level is downsampled from the previous one with the 5x5 Gaussian of pyrDown,
+					// all of them in a single pass over the first level
+					cv::buildPyramid(pyr[0], pyr, levels);
+					break;
+				}
+				if (k > 0)
+					scale *= pyrScale_;
+
+				// the levels are blurred and resized from the original image
+				double sigma = (1. / scale - 1)*0.5;
+				int smooth_sz = cvRound(sigma * 5) | 1;
+				smooth_sz = std::max(smooth_sz, 3);
+
+				GaussianBlur(fimg, blurred, Size(smooth_sz, smooth_sz), sigma, sigma);
+				if (k == 0)
+					blurred.copyTo(pyr[k]);
+				else
+					resize(blurred, pyr[k], Size(cvRound(img.cols*scale), cvRound(img.rows*scale)), 0, 0, INTER_LINEAR);
+			}
+		}
+
+		void FarnebackOpticalFlowImpl::calc(InputArray _prev0, InputArray _next0, InputOutputArray _flow0)
+		{
+			CV_INSTRUMENT_REGION()
+
+			Mat prev0 = _prev0.getMat(), next0 = _next0.getMat();
+			const int min_size = 32;
+
+			int i, k;
+			double scale;
+			Mat prevFlow, flow;
+			int levels = numLevels_;
+			// pyrDown halves the images, so the fast pyramids are only used for the classical pyramid
+			bool fastPyramids = fastPyramids_ && std::abs(pyrScale_ - 0.5) < 1e-6;
+
+			CV_Assert(prev0.size() == next0.size() && prev0.channels() == next0.channels() &&
+				prev0.channels() == 1 && pyrScale_ < 1);
+			_flow0.create(prev0.size(), CV_32FC2);
+			Mat flow0 = _flow0.getMat();
+
+			for (k = 0, scale = 1; k < levels; k++)
+			{
+				scale *= pyrScale_;
+				if (prev0.cols*scale < min_size || prev0.rows*scale < min_size)
+					break;
+			}
+
+			levels = k;
+
+			buildPyramid(prev0, pyr0_, levels, fastPyramids);
+			buildPyramid(next0, pyr1_, levels, fastPyramids);
+
+			for (k = levels; k >= 0; k--)
+			{
+				for (i = 0, scale = 1; i < k; i++)
+					scale *= pyrScale_;
+
+				int width = pyr0_[k].cols;
+				int height = pyr0_[k].rows;
+
+				if (k > 0)
+					flow.create(height, width, CV_32FC2);
+				else
+					flow = flow0;
+
+				if (prevFlow.empty())
+				{
+					if (flags_ & OPTFLOW_USE_INITIAL_FLOW)
+					{
+						resize(flow0, flow, Size(width, height), 0, 0, INTER_AREA);
+						flow *= scale;
+					}
+					else
+						flow = Scalar::all(0);
+				}
+				else
+				{
+					resize(prevFlow, flow, Size(width, height), 0, 0, INTER_LINEAR);
+					flow *= 1. / pyrScale_;
+				}
+
+				FarnebackPolyExp(pyr0_[k], R_[0], polyN_, polySigma_);
+				FarnebackPolyExp(pyr1_[k], R_[1], polyN_, polySigma_);
+
+				FarnebackUpdateMatrices(R_[0], R_[1], flow, M_);
+
+				for (i = 0; i < numIters_; i++)
+					FarnebackUpdateFlow(R_[0], R_[1], flow, M_, winSize_,
+					(flags_ & OPTFLOW_FARNEBACK_GAUSSIAN) != 0, i < numIters_ - 1);
+
+				prevFlow = flow;
+			}
+		}
+
+		void FarnebackOpticalFlowImpl::collectGarbage()
+		{
+			pyr0_.clear();
+			pyr1_.clear();
+			R_[0].release();
+			R_[1].release();
+			M_.release();
+		}
+	}
+} // namespace cv
+
+void cv::calcOpticalFlowFarneback(InputArray _prev0, InputArray _next0,
+	InputOutputArray _flow0, double pyr_scale, int levels, int winsize,
+	int iterations, int poly_n, double poly_sigma, int flags)
+{
+	CV_INSTRUMENT_REGION()
+
+	Ptr<cv::FarnebackOpticalFlow> optflow;
+	optflow = makePtr<FarnebackOpticalFlowImpl>(levels, pyr_scale, false, winsize, iterations, poly_n, poly_sigma, flags);
+	optflow->calc(_prev0, _next0, _flow0);
+}
+
+
+cv::Ptr<cv::FarnebackOpticalFlow> cv::FarnebackOpticalFlow::create(int numLevels, double pyrScale, bool fastPyramids, int winSize,
+	int numIters, int polyN, double polySigma, int flags)
+{
+	return makePtr<FarnebackOpticalFlowImpl>(numLevels, pyrScale, fastPyramids, winSize,
+		numIters, polyN, polySigma, flags);
+}